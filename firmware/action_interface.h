@@ -7,6 +7,16 @@ class ActionInterface {
   virtual unsigned int loop() = 0;
   virtual const char* debugName() = 0;
 
+  ///
+  /// @brief Called when the action is run before the delay it asked for
+  ///
+  /// Actions that keep time by adding up their delays (i.e., SSound) take
+  /// back the part they didn't sleep.
+  ///
+  /// @param[in] unusedUs - How much of the delay was cut short
+  ///
+  virtual void wokenEarly( unsigned int unusedUs ) { (void) unusedUs; }
+
 };
 
 #endif
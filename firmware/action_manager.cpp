@@ -1,32 +1,352 @@
+
+#include <algorithm>
+#include <cstring>
 #include "action_manager.h"
 
+constexpr bool ActionManager::profiling;
+constexpr unsigned int ActionManager::idleUs;
+constexpr unsigned int ActionManager::maxSleepUs;
+
+namespace {
+
+/// @brief Print a number right aligned in a column width characters wide
+void column( NetInterface& out, uint64_t value, unsigned int width )
+{
+  unsigned int digits = 1;
+  for ( uint64_t v = value; v >= 10; v /= 10 ) {
+    ++digits;
+  }
+  for ( ; digits < width; ++digits ) {
+    out << " ";
+  }
+  out << " " << (unsigned int) std::min< uint64_t >( value, ~0u );
+}
+
+/// @brief Print a name left aligned in a column width characters wide
+void column( NetInterface& out, const char* name, unsigned int width )
+{
+  out << name;
+  for ( std::size_t len = strlen( name ); len < width; ++len ) {
+    out << " ";
+  }
+}
+
+/// @brief One row of the stats table
+template< class Profile >
+void statsRow( NetInterface& out, const char* name, const Profile& p,
+  unsigned int maxLateUs )
+{
+  column( out, name, 14 );
+  column( out, p.getCalls(), 8 );
+  column( out, p.getTotalUs() / 1000, 9 );
+  column( out, p.getMinUs(), 7 );
+  column( out, p.getPercentileUs( 50 ), 7 );
+  column( out, p.getPercentileUs( 99 ), 7 );
+  column( out, p.getMaxUs(), 7 );
+  column( out, maxLateUs, 9 );
+  out << "\n";
+}
+
+}
+
 ActionManager::ActionManager(
     std::shared_ptr<NetInterface> netArg,
     std::shared_ptr<HWI> hardwareArg,
-    std::shared_ptr<DebugInterface> debugArg ) :
+    std::shared_ptr<DebugInterface> debugArg,
+    std::shared_ptr<ClockInterface> clockArg ) :
     net{ netArg },
     hardware{ hardwareArg },
     debug{ debugArg },
+    clock{ clockArg ? new MonotonicClock( clockArg ) : nullptr },
+    inputAnnounced{ false },
     timeInUs{ 0 }
 {
+  idleTime.fill( IdleTime{ 0, 0 } );
 }
 
-void ActionManager::addAction( std::shared_ptr< ActionInterface > interface )
+ActionManager::ActionId ActionManager::addAction( 
+  std::shared_ptr< ActionInterface > interface,
+  Schedule schedule )
 {
   (*net) << "Action " << interface->debugName() << " added\n";
-  size_t slot = interfaces.size();
-  interfaces.push_back( interface );
-  taskList.push( PriorityAndTaskSlot( timeInUs, slot ));
+  actions.push_back( Action{ interface, schedule, Timing{ 0, 0, 0, 0, 0 },
+    Profile(), 0 } );
+  const ActionId id = taskList.addTimer();
+  taskList.schedule( id, getTimeUs() );
+  if ( trace ) {
+    trace->setName( (uint16_t) id, interface->debugName() );
+  }
+  return id;
+}
+
+void ActionManager::cancel( ActionId id )
+{
+  ++actions.at( id ).generation;
+  taskList.cancel( id );
+}
+
+void ActionManager::reschedule( ActionId id, unsigned int delayUs )
+{
+  ++actions.at( id ).generation;
+  taskList.schedule( id, getTimeUs() + delayUs );
+}
+
+void ActionManager::wakeOnInput( ActionId id )
+{
+  if ( std::find( listeners.begin(), listeners.end(), id ) == listeners.end() ) {
+    listeners.push_back( id );
+  }
+}
+
+void ActionManager::inputReady()
+{
+  const uint64_t now = getTimeUs();
+  for ( ActionId id : listeners )
+  {
+    if ( !taskList.isScheduled( id ) ) {
+      continue;
+    }
+    const uint64_t deadline = taskList.getDeadline( id );
+    if ( deadline > now )
+    {
+      actions.at( id ).interface->wokenEarly(
+        (unsigned int) std::min< uint64_t >( deadline - now, ~0u ));
+      taskList.schedule( id, now );
+    }
+  }
+}
+
+void ActionManager::setWakeSource( std::shared_ptr< WakeInterface > source )
+{
+  wake = source;
+}
+
+void ActionManager::waitUs( unsigned int us )
+{
+  if ( us == 0 || !wake ) {
+    return;
+  }
+  SleepDepth depth = SleepDepth::AWAKE;
+  if ( idlePolicy )
+  {
+    depth = idlePolicy->choose( us );
+    // Leave time to wake up before the next action is due
+    const unsigned int latencyUs = idlePolicy->getState( depth ).exitLatencyUs;
+    if ( latencyUs >= us ) {
+      depth = SleepDepth::AWAKE;
+    }
+    else {
+      us -= latencyUs;
+    }
+    if ( depth != SleepDepth::AWAKE ) {
+      power->setSleepDepth( depth );
+    }
+  }
+  const uint64_t start = getTimeUs();
+
+  // Input stays pending until an action that wants it gets round to
+  // reading it (i.e., SSound between sampling windows).  Wake for it once
+  // rather than every time round.
+  if ( inputAnnounced && !wake->hasInput() ) {
+    inputAnnounced = false;
+  }
+  const bool woken = wake->waitUs( us, !inputAnnounced );
+
+  if ( depth != SleepDepth::AWAKE ) {
+    power->setSleepDepth( SleepDepth::AWAKE );
+  }
+  IdleTime& idle = idleTime[ (std::size_t) depth ];
+  ++idle.waits;
+  idle.totalUs += getTimeUs() - start;
+
+  if ( woken )
+  {
+    inputAnnounced = true;
+    inputReady();
+  }
+}
+
+void ActionManager::setIdlePolicy( std::shared_ptr< IdlePolicy > policyArg,
+  std::shared_ptr< PowerInterface > powerArg )
+{
+  idlePolicy = powerArg ? policyArg : nullptr;
+  power = powerArg;
+}
+
+uint64_t ActionManager::getTimeUs()
+{
+  if ( clock ) {
+    timeInUs = clock->nowUs();
+  }
+  return timeInUs;
 }
 
 unsigned int ActionManager::loop() 
 {
-  PriorityAndTaskSlot current = taskList.top();
-  taskList.pop();
-  timeInUs = current.first;
-  unsigned rescheduleAt = interfaces.at( current.second )->loop() + timeInUs;
-  taskList.push( PriorityAndTaskSlot( rescheduleAt, current.second ));
-  //(*net) << "Ran " << interfaces.at( current.second )->debugName() << " new time " << rescheduleAt << "\n"; 
-  return taskList.top().first - timeInUs;
+  const uint64_t due = taskList.nextDeadline();
+  if ( due == TimerWheel::never )
+  {
+    if ( !clock ) {
+      timeInUs += idleUs;
+    }
+    taskList.advanceTo( getTimeUs() );
+    return idleUs;
+  }
+
+  if ( !clock ) {
+    timeInUs = std::max( timeInUs, due );
+  }
+  const uint64_t loopStart = getTimeUs();
+  uint64_t inActions = 0;
+
+  // The actions can add, cancel and reschedule actions, so take a copy of
+  // the batch and don't hold on to an Action across a run.
+  batch.clear();
+  for ( ActionId id : taskList.advanceTo( loopStart )) {
+    batch.push_back( Expired{ id, actions[ id ].generation } );
+  }
+  for ( const Expired& expired : batch )
+  {
+    const ActionId id = expired.id;
+    if ( actions[ id ].generation != expired.generation ) {
+      // Cancelled or rescheduled by an earlier action in the batch
+      continue;
+    }
+    const uint64_t deadline = taskList.getDeadline( id );
+    const uint64_t start = getTimeUs();
+    if ( trace ) {
+      trace->begin( (uint16_t) id, start );
+    }
+    const unsigned int delay = actions[ id ].interface->loop();
+    Action& action = actions[ id ];
+    if ( profiling || trace )
+    {
+      const uint64_t end = getTimeUs();
+      if ( trace ) {
+        trace->end( (uint16_t) id, end, delay );
+      }
+      action.profile.record( (unsigned int) std::min< uint64_t >( end - start, ~0u ));
+      inActions += end - start;
+    }
+    const uint64_t next = nextDeadline( action, deadline, start, delay );
+    if ( action.generation == expired.generation ) {
+      taskList.schedule( id, next );
+    }
+    //(*net) << "Ran " << action.interface->debugName() << " new time " << start + delay << "\n"; 
+  }
+  const unsigned int sleep = sleepUs();
+  if ( profiling )
+  {
+    const uint64_t total = getTimeUs() - loopStart;
+    overhead.record( (unsigned int) std::min< uint64_t >( total - inActions, ~0u ));
+  }
+  return sleep;
+}
+
+void ActionManager::reportStats( NetInterface& out )
+{
+  if ( !profiling )
+  {
+    out << "profiling compiled out\n";
+    return;
+  }
+  out << "action            calls  total ms  min us  p50 us  p99 us  max us  max late\n";
+  for ( const Action& action : actions ) {
+    statsRow( out, action.interface->debugName(), action.profile,
+      action.timing.maxLateUs );
+  }
+  statsRow( out, "(scheduler)", overhead, 0 );
+
+  for ( SleepDepth d = SleepDepth::START_OF_DEPTHS; d < SleepDepth::END_OF_DEPTHS; ++d )
+  {
+    const IdleTime& idle = getIdleTime( d );
+    out << "idle ";
+    column( out, sleepDepthNames[ d ], 9 );
+    column( out, idle.waits, 8 );
+    column( out, idle.totalUs / 1000, 9 );
+    out << "\n";
+  }
+  if ( power ) {
+    power->reportEnergy( out );
+  }
+}
+
+void ActionManager::setTraceLog( std::shared_ptr< TraceLog > log )
+{
+  trace = log;
+  if ( !trace ) {
+    return;
+  }
+  for ( std::size_t id = 0; id < actions.size(); ++id ) {
+    trace->setName( (uint16_t) id, actions[ id ].interface->debugName() );
+  }
+}
+
+void ActionManager::dumpTrace( NetInterface& out )
+{
+  if ( !trace )
+  {
+    out << "no trace\n";
+    return;
+  }
+  SnapshotWriter log;
+  trace->save( log );
+  const std::vector< uint8_t >& bytes = log.getData();
+  out << "trace " << (unsigned int) bytes.size() << "\n";
+
+  static const char digits[] = "0123456789abcdef";
+  constexpr std::size_t bytesPerLine = 32;
+  char line[ bytesPerLine * 2 + 2 ];
+  for ( std::size_t pos = 0; pos < bytes.size(); pos += bytesPerLine )
+  {
+    const std::size_t n = std::min( bytesPerLine, bytes.size() - pos );
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+      line[ i * 2 ] = digits[ bytes[ pos + i ] >> 4 ];
+      line[ i * 2 + 1 ] = digits[ bytes[ pos + i ] & 0xf ];
+    }
+    line[ n * 2 ] = '\n';
+    line[ n * 2 + 1 ] = 0;
+    out << line;
+  }
+  out << "end trace\n";
 }
 
+uint64_t ActionManager::nextDeadline( 
+  Action& action, uint64_t deadline, uint64_t start, unsigned int delay )
+{
+  Timing& t = action.timing;
+  const uint64_t late = start > deadline ? start - deadline : 0;
+  t.lastLateUs = (unsigned int) std::min< uint64_t >( late, ~0u );
+  t.maxLateUs = std::max( t.maxLateUs, t.lastLateUs );
+  t.totalLateUs += late;
+  ++t.runs;
+
+  if ( action.schedule == Schedule::FIXED_DELAY || delay == 0 ) {
+    return start + delay;
+  }
+
+  // Fixed rate.  If we're more than a period behind, skip the periods we
+  // missed rather than running the action back to back.
+  uint64_t next = deadline + delay;
+  if ( next <= start )
+  {
+    const uint64_t behind = ( start - next ) / delay + 1;
+    t.skipped += (unsigned int) behind;
+    next += behind * delay;
+  }
+  return next;
+}
+
+unsigned int ActionManager::sleepUs()
+{
+  const uint64_t next = taskList.nextDeadline();
+  const uint64_t now = getTimeUs();
+  if ( next <= now ) {
+    return 0;
+  }
+  if ( !clock ) {
+    return (unsigned int) ( next - now );
+  }
+  return (unsigned int) std::min< uint64_t >( next - now, maxSleepUs );
+}
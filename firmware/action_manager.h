@@ -1,43 +1,234 @@
 #ifndef __ACTION_MANAGER_H__
 #define __ACTION_MANAGER_H__
 
+#include <cstdint>    // for uint64_t
 #include <memory>     // for std::shared_ptr
 #include <vector>     // for std::vector
-#include <queue>      // for std::priority_queue
 
 #include "action_interface.h"
+#include "action_profile.h"
+#include "clock_interface.h"
+#include "monotonic_clock.h"
 #include "net_interface.h"
 #include "debug_interface.h"
 #include "hardware_interface.h"
+#include "idle_policy.h"
+#include "power_interface.h"
+#include "stats_interface.h"
+#include "timer_wheel.h"
+#include "trace_log.h"
+#include "wake_interface.h"
 
-class ActionManager : public ActionInterface {
+/// @brief Set to 0 to compile out ActionManager's run time profiling
+#ifndef BEEFOCUS_PROFILE_ACTIONS
+#define BEEFOCUS_PROFILE_ACTIONS 1
+#endif
+
+///
+/// @brief Runs actions when they ask to be run
+///
+/// Each action's loop() returns how long until it wants to run again.
+/// The deadlines are kept in a TimerWheel, so adding, cancelling and
+/// running actions costs the same however many there are.  Every action
+/// due at the same time runs in one ActionManager::loop() call.
+///
+/// Actions may add, cancel or reschedule actions, themselves included,
+/// from their loop().  An action cancelled or rescheduled by an earlier 
+/// action in the same batch doesn't run, and an action that cancels or
+/// reschedules itself keeps that rather than what its loop() returned.
+/// Actions added during a batch first run on the next loop().
+///
+/// Time is 64 bit microseconds, so it never wraps.  Given a clock, time is
+/// the clock's; without one, time is the sum of the delays returned, as
+/// if every action took no time to run.
+///
+/// Unless BEEFOCUS_PROFILE_ACTIONS is 0, each action's run time and the
+/// time loop() spends on its own work are profiled.  reportStats() prints
+/// them.  Given a TraceLog, every action's begin and end is recorded
+/// too; dumpTrace() prints it.
+///
+/// Actions that wait on the network (see wakeOnInput) are run as soon as
+/// input arrives.  The caller sleeps with waitUs(), which a WakeInterface
+/// cuts short when there's input:
+///
+///   for ( ;; ) {
+///     manager.waitUs( manager.loop() );
+///   }
+///
+/// Given an IdlePolicy, waitUs() sleeps as deeply as the wait allows and
+/// wakes early enough to be back up when the next action is due.
+///
+class ActionManager : public ActionInterface, public StatsInterface {
   public:
 
+  using ActionId = TimerWheel::TimerId;
+
+  /// @brief Is run time profiling compiled in?
+  static constexpr bool profiling = BEEFOCUS_PROFILE_ACTIONS != 0;
+  using Profile = ActionProfile< profiling >;
+
+  /// @brief How an action's next deadline is worked out
+  enum class Schedule {
+    FIXED_DELAY,    ///< The delay is from when the action ran
+    FIXED_RATE      ///< The delay is from when the action was due
+  };
+
+  /// @brief How late an action has been, in us
+  struct Timing {
+    unsigned int runs;        ///< Number of times the action ran
+    unsigned int lastLateUs;  ///< Lateness of the latest run
+    unsigned int maxLateUs;   ///< Worst lateness
+    uint64_t totalLateUs;     ///< Sum of the lateness of every run
+    unsigned int skipped;     ///< FIXED_RATE periods skipped to catch up
+  };
+
   ActionManager(
     std::shared_ptr<NetInterface> netArg,
     std::shared_ptr<HWI> hardwareArg,
-    std::shared_ptr<DebugInterface> debugArg );
+    std::shared_ptr<DebugInterface> debugArg,
+    std::shared_ptr<ClockInterface> clockArg = nullptr );
+
+  ///
+  /// @brief Add an action.  It first runs on the next loop().
+  ///
+  /// @param[in] interface - The action
+  /// @param[in] schedule  - FIXED_RATE for periodic actions that must
+  ///                        not drift, i.e., DataMover
+  /// @return An id for cancel(), reschedule() and getTiming()
+  ///
+  ActionId addAction( std::shared_ptr< ActionInterface > interface,
+    Schedule schedule = Schedule::FIXED_DELAY );
+
+  /// @brief Stop running an action until it's rescheduled
+  void cancel( ActionId id );
+
+  /// @brief Run an action delayUs from now, replacing its current deadline
+  void reschedule( ActionId id, unsigned int delayUs );
+
+  /// @brief Run an action early, on the next loop(), when input arrives
+  void wakeOnInput( ActionId id );
+
+  ///
+  /// @brief Input has arrived.  Bring wakeOnInput actions forward to now.
+  ///
+  /// Each action that was sleeping is told how much of its delay it
+  /// didn't get (see ActionInterface::wokenEarly).
+  ///
+  void inputReady();
+
+  /// @brief What waitUs() sleeps on
+  void setWakeSource( std::shared_ptr< WakeInterface > source );
+
+  ///
+  /// @brief Sleep deeper than AWAKE when it pays
+  ///
+  /// @param[in] policyArg - Picks the depth for each wait
+  /// @param[in] powerArg  - Puts the device in that depth
+  ///
+  void setIdlePolicy( std::shared_ptr< IdlePolicy > policyArg,
+    std::shared_ptr< PowerInterface > powerArg );
+
+  /// @brief Waits at a sleep depth so far
+  struct IdleTime {
+    unsigned int waits;       ///< Number of waits
+    uint64_t totalUs;         ///< Time spent waiting
+  };
+
+  /// @brief Time waitUs() spent at a sleep depth
+  const IdleTime& getIdleTime( SleepDepth depth ) const
+  {
+    return idleTime[ (std::size_t) depth ];
+  }
 
-  void addAction( std::shared_ptr< ActionInterface > interface );
+  ///
+  /// @brief Sleep until the next loop() is due, or until input arrives
+  ///
+  /// @param[in] us - What loop() returned
+  ///
+  void waitUs( unsigned int us );
+
+  /// @brief An action's lateness so far
+  const Timing& getTiming( ActionId id ) const { return actions.at( id ).timing; }
+
+  /// @brief An action's run time profile
+  const Profile& getProfile( ActionId id ) const { return actions.at( id ).profile; }
+
+  /// @brief Time loop() spent outside the actions it ran
+  const Profile& getOverhead() const { return overhead; }
+
+  /// @brief Print a table of each action's run time and lateness
+  virtual void reportStats( NetInterface& out ) override;
+
+  /// @brief Record each action's begin and end in a log from now on
+  void setTraceLog( std::shared_ptr< TraceLog > log );
+
+  ///
+  /// @brief Print the trace log in hex
+  ///
+  /// The log sits between a "trace <bytes>" line and an "end trace"
+  /// line, 32 bytes a line.  See TraceLog::save for the format.
+  ///
+  virtual void dumpTrace( NetInterface& out ) override;
+
+  /// @brief The current time, in us
+  uint64_t getTimeUs();
+
+  /// @brief Run every action that's due
+  /// @return Microseconds until the next action is due
   virtual unsigned int loop() override final;
   virtual const char* debugName() override { return "ActionManager"; }
 
   private:
 
-  using PriorityAndTaskSlot = std::pair<unsigned, size_t >;
+  /// @brief How long loop() waits if every action is cancelled
+  static constexpr unsigned int idleUs = 1000;
+
+  /// @brief Longest wait loop() asks for, so the clock never wraps unseen
+  static constexpr unsigned int maxSleepUs = 10 * 60 * 1000 * 1000;
+
+  struct Action {
+    std::shared_ptr< ActionInterface > interface;
+    Schedule schedule;
+    Timing timing;
+    Profile profile;
+    /// @brief Bumped by cancel() and reschedule()
+    unsigned int generation;
+  };
+
+  /// @brief An action in the batch loop() is running
+  struct Expired {
+    ActionId id;
+    unsigned int generation;  ///< The action's generation when it expired
+  };
+
+  /// @brief When an action that was due at deadline and ran at start
+  ///        should run next
+  uint64_t nextDeadline( Action& action, uint64_t deadline, uint64_t start,
+    unsigned int delay );
+
+  /// @brief Microseconds from the current time to the next deadline
+  unsigned int sleepUs();
 
   std::shared_ptr<NetInterface> net;
   std::shared_ptr<HWI> hardware;
   std::shared_ptr<DebugInterface> debug;
+  std::unique_ptr<MonotonicClock> clock;
+  std::shared_ptr<TraceLog> trace;
+  std::shared_ptr<WakeInterface> wake;
+  std::shared_ptr<IdlePolicy> idlePolicy;
+  std::shared_ptr<PowerInterface> power;
+  std::array< IdleTime, (std::size_t) SleepDepth::END_OF_DEPTHS > idleTime;
 
-  std::vector< std::shared_ptr< ActionInterface >> interfaces;
+  std::vector< Action > actions;
+  /// @brief The actions loop() is running.  Kept to reuse its memory.
+  std::vector< Expired > batch;
+  std::vector< ActionId > listeners;
+  /// @brief Input woke the listeners and nobody has read it yet
+  bool inputAnnounced;
+  Profile overhead;
 
-  std::priority_queue< 
-    PriorityAndTaskSlot, 
-    std::vector<PriorityAndTaskSlot>, 
-    std::greater<PriorityAndTaskSlot> > taskList;
-  unsigned long long timeInUs;
+  TimerWheel taskList;
+  uint64_t timeInUs;
 };
 
 #endif
-
@@ -0,0 +1,94 @@
+#ifndef __ACTION_PROFILE_H__
+#define __ACTION_PROFILE_H__
+
+#include <algorithm>    // for std::min, std::max
+#include <cstdint>      // for uint64_t
+#include "histogram.h"
+
+///
+/// @brief Run time profile of one action
+///
+/// Counts calls and keeps the total, min and max run time and a histogram
+/// of run times with a bin per power of 2 us.  The enabled template
+/// argument picks between this and an empty version, so profiling can be
+/// compiled out (see ActionManager::profiling) at no cost.
+///
+template< bool enabled >
+class ActionProfile
+{
+  public:
+
+  static constexpr bool isEnabled = true;
+
+  /// @brief Bins are 0, 1, 2-3, 4-7 ... up to 2^22 us and above
+  using histogram_t = Histogram< unsigned int, 24,
+    Log2Bins< unsigned int, 24, 0 >>;
+
+  ActionProfile() : runTimes{ 0u, 0u }
+  {
+    reset();
+  }
+
+  void reset()
+  {
+    calls = 0;
+    totalUs = 0;
+    minUs = 0;
+    maxUs = 0;
+    runTimes.reset();
+  }
+
+  /// @brief Count one call that ran for us
+  void record( unsigned int us )
+  {
+    minUs = calls ? std::min( minUs, us ) : us;
+    maxUs = std::max( maxUs, us );
+    totalUs += us;
+    ++calls;
+    runTimes.insert( us );
+  }
+
+  unsigned int getCalls() const { return calls; }
+  uint64_t getTotalUs() const { return totalUs; }
+  unsigned int getMinUs() const { return minUs; }
+  unsigned int getMaxUs() const { return maxUs; }
+
+  /// @brief Approximate run time percentile, in us
+  unsigned int getPercentileUs( unsigned int percent ) const
+  {
+    return calls ? runTimes.getPercentile( percent ) : 0;
+  }
+
+  const histogram_t& getHistogram() const { return runTimes; }
+
+  private:
+
+  unsigned int calls;
+  uint64_t totalUs;
+  unsigned int minUs;
+  unsigned int maxUs;
+  histogram_t runTimes;
+};
+
+/// @brief Profiling compiled out.  Every call does nothing.
+template<>
+class ActionProfile< false >
+{
+  public:
+
+  static constexpr bool isEnabled = false;
+
+  void reset() {}
+  void record( unsigned int ) {}
+  unsigned int getCalls() const { return 0; }
+  uint64_t getTotalUs() const { return 0; }
+  unsigned int getMinUs() const { return 0; }
+  unsigned int getMaxUs() const { return 0; }
+  unsigned int getPercentileUs( unsigned int ) const { return 0; }
+};
+
+template< bool enabled >
+constexpr bool ActionProfile< enabled >::isEnabled;
+
+#endif
+
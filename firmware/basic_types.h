@@ -2,6 +2,7 @@
 #define __BASIC_TYPES_H__
 
 #include <array>
+#include <cstddef>
 
 namespace BeeFocus
 {
@@ -25,6 +26,50 @@ namespace BeeFocus
     }
     return e;
   }
+
+  /// @brief One key / value pair in an EnumTable
+  template< class E, class V >
+  struct EnumEntry
+  {
+    E key;
+    V value;
+  };
+
+  ///
+  /// @brief A constant table indexed by an enum's value
+  ///
+  /// Written out with the keys so it reads like the unordered_maps it
+  /// replaces, but looked up with a plain array index.  Declare the table
+  /// constexpr, so it's built by the compiler and lands in read-only
+  /// memory, and check it with static_assert( table.isDense(), ... ).
+  /// A missing, duplicated or out of order entry fails the check, since
+  /// the left over entries are zero initialized.
+  ///
+  /// E  The enum.  Values must run from 0 to N - 1.
+  /// V  The value type, i.e., a name or a pointer to member function
+  /// N  The number of enum values
+  ///
+  template< class E, class V, std::size_t N >
+  struct EnumTable
+  {
+    EnumEntry< E, V > entries[ N ];
+
+    static constexpr std::size_t size() { return N; }
+
+    /// @brief The value for a key.  The key must be less than N.
+    constexpr const V& operator[]( E key ) const
+    {
+      return entries[ static_cast< std::size_t >( key ) ].value;
+    }
+
+    /// @brief True if entry i has key i for every entry from start on
+    constexpr bool isDense( std::size_t start = 0 ) const
+    {
+      return start == N ||
+        ( static_cast< std::size_t >( entries[ start ].key ) == start &&
+          isDense( start + 1 ));
+    }
+  };
 };
 
 
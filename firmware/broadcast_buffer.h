@@ -0,0 +1,354 @@
+#ifndef __BROADCAST_BUFFER_H__
+#define __BROADCAST_BUFFER_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+///
+/// @brief Output shared by several readers, i.e., every connected client
+///
+/// Data is written once into a chain of segments from a fixed pool.  Each
+/// attached reader has its own cursor into the chain and each segment
+/// counts the readers that still have to get past it, so a segment goes
+/// back to the pool as soon as the last reader is done with it.  Nothing
+/// is kept while no reader is attached.
+///
+/// Readers go at their own pace.  If a write finds the pool empty, the
+/// readers holding the oldest segment skip to the newest data and the
+/// bytes they missed are counted, so a slow reader can't stop the writer
+/// or use up the pool for the others.
+///
+/// segmentSize   Bytes per segment
+/// segmentCount  Segments in the pool.  At least 2.
+/// readerCount   Number of reader slots
+///
+template< std::size_t segmentSize, std::size_t segmentCount, std::size_t readerCount >
+class BroadcastBuffer
+{
+  static_assert( segmentCount >= 2 && segmentCount < 255,
+    "BroadcastBuffer needs 2 to 254 segments" );
+  static_assert( segmentSize != 0 && segmentSize <= 0xffff,
+    "BroadcastBuffer segment size must fit in 16 bits" );
+  static_assert( readerCount != 0 && readerCount < 255,
+    "BroadcastBuffer needs 1 to 254 readers" );
+
+  public:
+
+  BroadcastBuffer() : head{ none }, tail{ none }, freeList{ 0 }
+  {
+    for ( std::size_t i = 0; i < segmentCount; ++i ) {
+      segments[i].next = i + 1 < segmentCount ? (uint8_t) ( i + 1 ) : none;
+    }
+    for ( Cursor& cursor : cursors ) {
+      cursor = Cursor{ false, none, 0, 0 };
+    }
+  }
+
+  BroadcastBuffer( const BroadcastBuffer& ) = delete;
+  BroadcastBuffer& operator=( const BroadcastBuffer& ) = delete;
+
+  ///
+  /// @brief Start a reader.  It gets what's written from now on.
+  ///
+  /// Does nothing if the reader is already attached.
+  ///
+  void attach( std::size_t reader )
+  {
+    Cursor& cursor = cursors[ reader ];
+    if ( cursor.attached ) {
+      return;
+    }
+    cursor = Cursor{ true, tail, 0, 0 };
+    if ( tail != none )
+    {
+      cursor.offset = segments[ tail ].size;
+      ++segments[ tail ].refs;
+    }
+  }
+
+  /// @brief Stop a reader and let go of everything it hadn't read
+  void detach( std::size_t reader )
+  {
+    Cursor& cursor = cursors[ reader ];
+    if ( !cursor.attached ) {
+      return;
+    }
+    cursor.attached = false;
+    release( cursor.segment, none );
+    cursor.segment = none;
+  }
+
+  bool isAttached( std::size_t reader ) const { return cursors[ reader ].attached; }
+
+  ///
+  /// @brief Add data for every attached reader
+  ///
+  /// Dropped if no reader is attached.  Never fails; see the class
+  /// comment for what happens when the pool runs out.
+  ///
+  /// @return n
+  ///
+  std::size_t write( const char* data, std::size_t n )
+  {
+    if ( !anyAttached() ) {
+      return n;
+    }
+    std::size_t done = 0;
+    while ( done < n )
+    {
+      if ( tail == none || segments[ tail ].size == segmentSize ) {
+        makeRoom();
+      }
+      Segment& segment = segments[ tail ];
+      const std::size_t room = segmentSize - segment.size;
+      const std::size_t count = room < n - done ? room : n - done;
+      memcpy( segment.data.data() + segment.size, data + done, count );
+      segment.size += count;
+      done += count;
+    }
+    return n;
+  }
+
+  /// @brief Bytes write() can take without making any reader skip
+  std::size_t getFreeSpace() const
+  {
+    std::size_t space = 0;
+    for ( uint8_t s = freeList; s != none; s = segments[ s ].next ) {
+      space += segmentSize;
+    }
+    if ( tail != none ) {
+      space += segmentSize - segments[ tail ].size;
+    }
+    return space;
+  }
+
+  ///
+  /// @brief Get the reader's next unread bytes
+  ///
+  /// @param[out] data - The bytes, in the buffer
+  /// @return The number of contiguous bytes at data.  0 if there are none
+  ///         or the reader isn't attached.
+  ///
+  std::size_t peek( std::size_t reader, const char*& data )
+  {
+    Cursor& cursor = cursors[ reader ];
+    if ( !cursor.attached ) {
+      return 0;
+    }
+    advance( cursor );
+    if ( cursor.segment == none ) {
+      return 0;
+    }
+    const Segment& segment = segments[ cursor.segment ];
+    data = segment.data.data() + cursor.offset;
+    return segment.size - cursor.offset;
+  }
+
+  /// @brief Mark n bytes from peek() as read
+  void consume( std::size_t reader, std::size_t n )
+  {
+    Cursor& cursor = cursors[ reader ];
+    if ( !cursor.attached || cursor.segment == none ) {
+      return;
+    }
+    cursor.offset += n;
+    advance( cursor );
+  }
+
+  /// @brief Bytes the reader hasn't read yet
+  std::size_t getPending( std::size_t reader ) const
+  {
+    const Cursor& cursor = cursors[ reader ];
+    if ( !cursor.attached || cursor.segment == none ) {
+      return 0;
+    }
+    std::size_t pending = 0;
+    for ( uint8_t s = cursor.segment; s != none; s = segments[ s ].next ) {
+      pending += segments[ s ].size;
+    }
+    return pending - cursor.offset;
+  }
+
+  /// @brief Bytes the reader missed because it fell behind
+  unsigned int getSkipped( std::size_t reader ) const { return cursors[ reader ].skipped; }
+
+  /// @brief Segments in the pool that aren't in use
+  std::size_t getFreeSegments() const
+  {
+    std::size_t count = 0;
+    for ( uint8_t s = freeList; s != none; s = segments[ s ].next ) {
+      ++count;
+    }
+    return count;
+  }
+
+  private:
+
+  static constexpr uint8_t none = 0xff;
+
+  struct Segment
+  {
+    std::array< char, segmentSize > data;
+    uint16_t size;
+    /// @brief Readers that haven't got past this segment yet
+    uint8_t refs;
+    uint8_t next;
+  };
+
+  struct Cursor
+  {
+    bool attached;
+    uint8_t segment;
+    uint16_t offset;
+    unsigned int skipped;
+  };
+
+  bool anyAttached() const
+  {
+    for ( const Cursor& cursor : cursors ) {
+      if ( cursor.attached ) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// @brief Move a cursor off segments it's finished with
+  void advance( Cursor& cursor )
+  {
+    while ( cursor.segment != none &&
+            cursor.offset == segments[ cursor.segment ].size &&
+            segments[ cursor.segment ].next != none )
+    {
+      const uint8_t done = cursor.segment;
+      cursor.segment = segments[ done ].next;
+      cursor.offset = 0;
+      unref( done );
+    }
+  }
+
+  /// @brief Drop a reference to each segment from first up to (not
+  ///        including) last
+  void release( uint8_t first, uint8_t last )
+  {
+    while ( first != last )
+    {
+      const uint8_t next = segments[ first ].next;
+      unref( first );
+      first = next;
+    }
+  }
+
+  ///
+  /// @brief Drop a reference to a segment, freeing it if it was the last
+  ///
+  /// Readers only move forward, so the last reference to go is always
+  /// to the oldest segment.
+  ///
+  void unref( uint8_t s )
+  {
+    if ( --segments[ s ].refs != 0 ) {
+      return;
+    }
+    head = segments[ s ].next;
+    if ( head == none ) {
+      tail = none;
+    }
+    segments[ s ].next = freeList;
+    freeList = s;
+  }
+
+  /// @brief Get an empty tail segment
+  void makeRoom()
+  {
+    if ( tail != none && caughtUp() )
+    {
+      // Everyone has read the tail, so reuse it in place
+      segments[ tail ].size = 0;
+      for ( Cursor& cursor : cursors ) {
+        cursor.offset = 0;
+      }
+      return;
+    }
+    if ( freeList == none ) {
+      skipOldest();
+    }
+
+    const uint8_t s = freeList;
+    freeList = segments[ s ].next;
+    Segment& segment = segments[ s ];
+    segment.size = 0;
+    segment.next = none;
+    segment.refs = 0;
+    for ( Cursor& cursor : cursors )
+    {
+      if ( !cursor.attached ) {
+        continue;
+      }
+      ++segment.refs;
+      if ( cursor.segment == none ) {
+        cursor.segment = s;
+      }
+    }
+    if ( tail == none ) {
+      head = s;
+    }
+    else {
+      segments[ tail ].next = s;
+    }
+    tail = s;
+  }
+
+  /// @brief Have all attached readers read everything?
+  bool caughtUp() const
+  {
+    for ( const Cursor& cursor : cursors ) {
+      if ( cursor.attached &&
+           ( cursor.segment != tail || cursor.offset != segments[ tail ].size )) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  ///
+  /// @brief Free the oldest segment by moving its readers to the end
+  ///
+  /// Only called with the pool empty, so there's more than one segment
+  /// in use and the oldest isn't the tail.
+  ///
+  void skipOldest()
+  {
+    // Moving the last reader off the oldest segment frees it and moves
+    // head on, so hold on to the segment to skip.
+    const uint8_t oldest = head;
+    for ( Cursor& cursor : cursors )
+    {
+      if ( !cursor.attached || cursor.segment != oldest ) {
+        continue;
+      }
+      const std::size_t reader = &cursor - cursors.data();
+      cursor.skipped += getPending( reader );
+      const uint8_t from = cursor.segment;
+      cursor.segment = tail;
+      cursor.offset = segments[ tail ].size;
+      release( from, tail );
+    }
+  }
+
+  std::array< Segment, segmentCount > segments;
+  std::array< Cursor, readerCount > cursors;
+  /// @brief Oldest segment in use
+  uint8_t head;
+  /// @brief Newest segment, the one written to
+  uint8_t tail;
+  uint8_t freeList;
+};
+
+template< std::size_t segmentSize, std::size_t segmentCount, std::size_t readerCount >
+constexpr uint8_t BroadcastBuffer< segmentSize, segmentCount, readerCount >::none;
+
+#endif
+
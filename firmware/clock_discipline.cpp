@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <cmath>
+#include "clock_discipline.h"
+
+constexpr unsigned int ClockDiscipline::maxSamples;
+constexpr int32_t ClockDiscipline::maxDriftPpb;
+constexpr unsigned int ClockDiscipline::outlierSlackMs;
+constexpr unsigned int ClockDiscipline::maxRejectedInARow;
+constexpr unsigned int ClockDiscipline::minSpanPerErrorMs;
+constexpr unsigned int ClockDiscipline::targetErrorMs;
+constexpr unsigned int ClockDiscipline::minIntervalMs;
+constexpr unsigned int ClockDiscipline::maxIntervalMs;
+
+ClockDiscipline::ClockDiscipline() :
+  first{ 0 }, count{ 0 }, rejectedInARow{ 0 },
+  anchorDeviceMs{ 0 }, anchorWallMs{ 0 }, driftPpb{ 0 },
+  intervalMs{ minIntervalMs }
+{
+}
+
+void ClockDiscipline::setTime( uint64_t deviceMs, uint64_t wallMs )
+{
+  first = 0;
+  count = 0;
+  rejectedInARow = 0;
+  anchorDeviceMs = deviceMs;
+  anchorWallMs = wallMs;
+  driftPpb = 0;
+  intervalMs = minIntervalMs;
+}
+
+bool ClockDiscipline::addSample( const TimeSample& reading )
+{
+  if ( count != 0 && rejectedInARow < maxRejectedInARow )
+  {
+    unsigned int bestErrorMs = sample( 0 ).errorMs;
+    for ( unsigned int i = 1; i < count; ++i ) {
+      bestErrorMs = std::min( bestErrorMs, sample( i ).errorMs );
+    }
+    if ( reading.errorMs > 2 * bestErrorMs + outlierSlackMs )
+    {
+      ++rejectedInARow;
+      return false;
+    }
+  }
+  rejectedInARow = 0;
+
+  if ( count == 0 ) {
+    intervalMs = minIntervalMs;
+  }
+  else
+  {
+    // How far the fit missed, beyond what the reading itself might be off
+    const uint64_t elapsedMs = reading.deviceMs - sample( count - 1 ).deviceMs;
+    const int64_t errorMs = (int64_t) ( reading.wallMs - wallMs( reading.deviceMs ));
+    const uint64_t absErrorMs = errorMs < 0 ? -errorMs : errorMs;
+    const uint64_t missMs = absErrorMs > reading.errorMs ? absErrorMs - reading.errorMs : 0;
+    uint64_t next = 2 * uint64_t( intervalMs );
+    if ( missMs != 0 ) {
+      next = std::min( next, uint64_t( targetErrorMs ) * elapsedMs / missMs );
+    }
+    intervalMs = (unsigned int) std::max< uint64_t >( minIntervalMs,
+      std::min< uint64_t >( maxIntervalMs, next ));
+  }
+
+  if ( count == maxSamples ) {
+    first = ( first + 1 ) % maxSamples;
+  }
+  else {
+    ++count;
+  }
+  samples[( first + count - 1 ) % maxSamples ] = reading;
+  fit();
+  return true;
+}
+
+void ClockDiscipline::fit()
+{
+  const TimeSample& newest = sample( count - 1 );
+  anchorDeviceMs = newest.deviceMs;
+  anchorWallMs = newest.wallMs;
+
+  unsigned int maxErrorMs = 1;
+  for ( unsigned int i = 0; i < count; ++i ) {
+    maxErrorMs = std::max( maxErrorMs, sample( i ).errorMs );
+  }
+  const uint64_t spanMs = newest.deviceMs - sample( 0 ).deviceMs;
+  if ( count < 2 || spanMs < uint64_t( maxErrorMs ) * minSpanPerErrorMs ) {
+    return;
+  }
+
+  // Least squares, with x the device ms before the newest reading and y
+  // how much further the wall clock moved in that time
+  double meanX = 0;
+  double meanY = 0;
+  std::array< double, maxSamples > x;
+  std::array< double, maxSamples > y;
+  for ( unsigned int i = 0; i < count; ++i )
+  {
+    x[i] = -double( newest.deviceMs - sample( i ).deviceMs );
+    y[i] = double( (int64_t) ( sample( i ).wallMs - newest.wallMs )) - x[i];
+    meanX += x[i] / count;
+    meanY += y[i] / count;
+  }
+  double sxx = 0;
+  double sxy = 0;
+  for ( unsigned int i = 0; i < count; ++i )
+  {
+    sxx += ( x[i] - meanX ) * ( x[i] - meanX );
+    sxy += ( x[i] - meanX ) * ( y[i] - meanY );
+  }
+  const double limit = maxDriftPpb / 1e9;
+  const double slope = std::max( -limit, std::min( limit, sxy / sxx ));
+  driftPpb = (int32_t) std::lround( slope * 1e9 );
+  // The fitted time at the newest reading
+  anchorWallMs += std::llround( meanY - slope * meanX );
+}
+
+uint64_t ClockDiscipline::wallMs( uint64_t deviceMs ) const
+{
+  const int64_t elapsedMs = (int64_t) ( deviceMs - anchorDeviceMs );
+  return anchorWallMs + elapsedMs + elapsedMs * driftPpb / 1000000000;
+}
+
+unsigned int ClockDiscipline::getIntervalMs() const
+{
+  // Try again soon after an outlier
+  return rejectedInARow ? minIntervalMs : intervalMs;
+}
+
@@ -0,0 +1,96 @@
+#ifndef __CLOCK_DISCIPLINE_H__
+#define __CLOCK_DISCIPLINE_H__
+
+#include <array>
+#include <cstdint>
+#include "time_interface.h"
+
+///
+/// @brief Wall clock time from the device clock and occasional readings
+///
+/// Fits a line through the last few wall clock readings (i.e., NTP
+/// replies) against the device clock, so the time between readings
+/// follows the crystal's drift to a few ms rather than a second.
+///
+/// Readings that are much less certain than the best one kept (a slow
+/// round trip) are rejected as outliers.  Drift is only fitted once the
+/// readings span long enough for their error to matter little.
+///
+/// The time between readings comes from how well the last one was
+/// predicted: it doubles while the prediction is within targetErrorMs,
+/// and shrinks to keep the expected error there when it isn't.
+///
+class ClockDiscipline
+{
+  public:
+
+  /// @brief Number of readings fitted
+  static constexpr unsigned int maxSamples = 8;
+  /// @brief Drift beyond this is a bad fit, not a crystal
+  static constexpr int32_t maxDriftPpb = 500000;
+  /// @brief Reject readings with more than twice the best error, plus this
+  static constexpr unsigned int outlierSlackMs = 10;
+  /// @brief Accept anyway after this many rejections in a row
+  static constexpr unsigned int maxRejectedInARow = 3;
+  /// @brief Fit drift once the readings span this many times their error
+  static constexpr unsigned int minSpanPerErrorMs = 100000;
+  /// @brief Error to keep the time within between readings
+  static constexpr unsigned int targetErrorMs = 50;
+  static constexpr unsigned int minIntervalMs = 64 * 1000;
+  static constexpr unsigned int maxIntervalMs = 24 * 60 * 60 * 1000;
+
+  ClockDiscipline();
+
+  ///
+  /// @brief Start over from a time that isn't a reading
+  ///
+  /// i.e., one restored after a reboot.  Readings and drift are dropped.
+  ///
+  void setTime( uint64_t deviceMs, uint64_t wallMs );
+
+  ///
+  /// @brief Add a reading and refit
+  ///
+  /// @return false if it was rejected as an outlier
+  ///
+  bool addSample( const TimeSample& sample );
+
+  ///
+  /// @brief Wall clock time in ms since 1970 at device time deviceMs
+  ///
+  /// Device times are 64 bit ms, so they never wrap.
+  ///
+  uint64_t wallMs( uint64_t deviceMs ) const;
+
+  /// @brief Wall clock ms gained per 10^9 device clock ms
+  int32_t getDriftPpb() const { return driftPpb; }
+  /// @brief How long until the next reading is wanted
+  unsigned int getIntervalMs() const;
+  /// @brief True once there's been a reading
+  bool isSynced() const { return count != 0; }
+  unsigned int getSamples() const { return count; }
+
+  private:
+
+  const TimeSample& sample( unsigned int i ) const
+  {
+    return samples[( first + i ) % maxSamples ];
+  }
+
+  /// @brief Refit the drift and the time at the newest reading
+  void fit();
+
+  std::array< TimeSample, maxSamples > samples;
+  unsigned int first;
+  unsigned int count;
+  unsigned int rejectedInARow;
+
+  /// @brief A point on the fitted line
+  uint64_t anchorDeviceMs;
+  uint64_t anchorWallMs;
+  int32_t driftPpb;
+  unsigned int intervalMs;
+};
+
+#endif
+
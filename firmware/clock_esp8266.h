@@ -0,0 +1,16 @@
+#ifndef __CLOCK_ESP8266_H__
+#define __CLOCK_ESP8266_H__
+
+#include <Arduino.h>
+#include "clock_interface.h"
+
+///
+/// @brief The ESP8266's micros() counter
+///
+class ClockESP8266: public ClockInterface {
+  public:
+
+  uint32_t microsSinceDeviceStart() override { return micros(); }
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef __CLOCK_INTERFACE_H__
+#define __CLOCK_INTERFACE_H__
+
+#include <cstdint>
+
+///
+/// @brief Free running microsecond counter
+///
+/// Like the Arduino micros() call - it starts near 0 when the device
+/// boots and wraps every 2^32 us, about 71 minutes.  See MonotonicClock
+/// for a 64 bit version.
+///
+class ClockInterface
+{
+  public:
+
+  virtual ~ClockInterface() {}
+
+  /// @brief Microseconds since the device started, modulo 2^32
+  virtual uint32_t microsSinceDeviceStart() = 0;
+};
+
+#endif
@@ -2,8 +2,8 @@
 #include "debug_interface.h"
 #include "command_parser.h"
 #include "wifi_debug_ostream.h"
-#include <vector>
 #include <algorithm>
+#include <cstring>
 
 namespace CommandParser
 {
@@ -17,20 +17,20 @@ namespace CommandParser
 /// @brief The Template for a bee-focuser command
 ///
 /// 
-class CommandTemplate
+struct CommandTemplate
 {
-  public:
-
-  const std::string inputCommand;
+  const char* inputCommand;
   CommandParser::Command outputCommand;
-  const HasArg hasArg;
+  HasArg hasArg;
 };
 
-const std::vector<CommandTemplate> commandTemplates =
+constexpr CommandTemplate commandTemplates[] =
 {
   { "abort",      Command::Abort,    HasArg::No  },
   { "status",     Command::Status,   HasArg::No  },
   { "hreset",     Command::HReset,   HasArg::No  },
+  { "stats",      Command::Stats,    HasArg::No  },
+  { "trace",      Command::Trace,    HasArg::No  },
 }; 
 
 /// @brief Process an integer argument
@@ -67,18 +67,25 @@ const CommandPacket checkForCommands(
 	DebugInterface& serialLog, 
 	NetInterface& wifi  )
 {
-	CommandPacket result;
-  
-  WifiDebugOstream log( &serialLog, &wifi );
-
   // Read the first line of the request.  
 
   static std::string command;
   bool dataReady = wifi.getString( command );
   if ( !dataReady )
   {
-    return result;
+    return CommandPacket();
   }
+  return parseCommand( serialLog, wifi, command );
+}
+
+const CommandPacket parseCommand( 
+	DebugInterface& serialLog, 
+	NetInterface& wifi,
+  std::string& command )
+{
+	CommandPacket result;
+  
+  WifiDebugOstream log( &serialLog, &wifi );
 
   std::transform( command.begin(), command.end(), command.begin(), ::tolower);
 
@@ -86,12 +93,13 @@ const CommandPacket checkForCommands(
 
   for ( const CommandTemplate& ct : commandTemplates )
   {
-    if ( command.find(ct.inputCommand ) == 0 )
+    const size_t length = strlen( ct.inputCommand );
+    if ( command.compare( 0, length, ct.inputCommand ) == 0 )
     {
       result.command = ct.outputCommand;
       if ( ct.hasArg == HasArg::Yes )
       {
-        result.optionalArg =  process_int( command,  ct.inputCommand.length()+1  );
+        result.optionalArg =  process_int( command,  length+1  );
       } 
       return result;
     }
@@ -16,6 +16,8 @@ namespace CommandParser {
     Abort = 0,            ///<  Abort a move
     Status,               ///<  Return current status
     HReset,               ///<  Hard Reset the current histogram
+    Stats,                ///<  Print run time statistics
+    Trace,                ///<  Dump the action trace log
     NoCommand,            ///<  No command was specified.
     EndOfCommands         ///<  End of the comand list.
   };
@@ -60,6 +62,18 @@ namespace CommandParser {
     NetInterface& netInterface	// Input: Network Interface
   );
 
+  ///
+  /// @brief Parse a line already read from the network
+  ///
+  /// checkForCommands without the read, for callers that await input
+  /// (see NetInterface::readable).  The line is lower cased in place.
+  ///
+  const CommandPacket parseCommand( 
+    DebugInterface& log,				// Input: Debug Log Strem
+    NetInterface& netInterface,	// Input: Network Interface, for echoing
+    std::string& command        // Input: The line read
+  );
+
 };
 
 /// @brief Increment operator for Command enum
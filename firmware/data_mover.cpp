@@ -1,30 +1,60 @@
 #include "data_mover.h"
 #include "net_interface.h"
 #include "temperature_interface.h"
-#include "wifi_ostream.h"
+#include "time_interface.h"
 
 DataMover::DataMover(
   std::string deviceNameArg,
   std::shared_ptr<TempInterface> tempArg,
-  std::shared_ptr<NetInterface> netArg
-) : temp{ tempArg}, net{ netArg }
+  std::shared_ptr<NetInterface> netArg,
+  std::shared_ptr<TimeInterface> timeArg,
+  unsigned int readingsPerFrameArg
+) : temp{ tempArg}, net{ netArg }, time{ timeArg },
+    readingsPerFrame{ readingsPerFrameArg < 1 ? 1 :
+      readingsPerFrameArg > TelemetryFrame::maxReadings / 2 ?
+        TelemetryFrame::maxReadings / 2 : readingsPerFrameArg },
+    frame{ TelemetryFrame::deviceIdFor( deviceNameArg ) },
+    samples{ 0 }
 {
-  deviceName = deviceNameArg;
-  while ( deviceName.size() < 8 ) {
-    deviceName.push_back(' ');
+}
+
+unsigned int DataMover::loop() 
+{
+  // Readings are no use without a time, so wait until it's known
+  const uint64_t nowMs = time->msSince1970();
+  if ( nowMs == 0 ) {
+    return 1000000;
+  }
+
+  const int t_int = temp->readTemperature() * 10.0f;
+  const int h_int = temp->readHumidity() * 10.0f;
+  add( TelemetryFrame::Type::TEMPERATURE, nowMs, t_int );
+  add( TelemetryFrame::Type::HUMIDITY, nowMs, h_int );
+
+  if ( ++samples >= readingsPerFrame ) {
+    sendFrame();
   }
+  return 1000000;
 }
 
-void DataMover::packageData( const char *type, unsigned int data )
+void DataMover::add( TelemetryFrame::Type type, uint64_t timeMs, int value )
 {
-  (*net) << deviceName << " " << type << " " << data << "\n";
+  if ( !frame.add( type, 0, timeMs, value ))
+  {
+    // Full early (i.e., noisy values).  Start another.
+    sendFrame();
+    frame.add( type, 0, timeMs, value );
+  }
 }
 
-unsigned int DataMover::loop() 
+void DataMover::sendFrame()
 {
-  float t = temp->readTemperature();
-  int t_int = t*10.0f;
-  packageData("Temp", t_int );
-  return 1000000;
+  if ( frame.size() )
+  {
+    const std::vector< uint8_t >& bytes = frame.finish();
+    net->write( (const char*) bytes.data(), bytes.size() );
+  }
+  frame.reset();
+  samples = 0;
 }
 
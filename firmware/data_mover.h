@@ -2,30 +2,47 @@
 #define __DATA_MOVER_H__
 
 #include <memory>
+#include <string>
 #include "action_interface.h"
+#include "telemetry_frame.h"
 
 class TempInterface;
 class NetInterface;
-
+class TimeInterface;
+
+///
+/// @brief Reads the sensors once a second and sends the readings
+///
+/// Each second's temperature and humidity are batched into a binary
+/// TelemetryFrame, sent once readingsPerFrame seconds have been taken.
+///
 class DataMover: public ActionInterface {
   public:
 
   DataMover(
     std::string deviceNameArg, 
     std::shared_ptr<TempInterface> tempArg,
-    std::shared_ptr<NetInterface> netArg
+    std::shared_ptr<NetInterface> netArg,
+    std::shared_ptr<TimeInterface> timeArg,
+    unsigned int readingsPerFrameArg = 30
   );
 
   virtual unsigned int loop() override final;
   virtual const char* debugName() override final { return "DataMover"; }
 
   private:
- 
-  void packageData( const char* type, unsigned int data );
+
+  /// @brief Add a reading, sending the frame first if it's full
+  void add( TelemetryFrame::Type type, uint64_t timeMs, int value );
+  void sendFrame();
  
   std::shared_ptr<TempInterface> temp;
   std::shared_ptr<NetInterface> net;
-  std::string deviceName;
+  std::shared_ptr<TimeInterface> time;
+  const unsigned int readingsPerFrame;
+  TelemetryFrame frame;
+  /// @brief Seconds of readings in the frame
+  unsigned int samples;
 };
 
 #endif
@@ -0,0 +1,102 @@
+#ifndef __FIXED_FFT_H__
+#define __FIXED_FFT_H__
+
+#include <array>
+#include <cmath>      // for sin, cos at construction only
+#include <cstddef>
+#include <cstdint>
+#include <utility>    // for std::swap
+
+///
+/// @brief In place, fixed point, radix-2 FFT
+///
+/// Works on Q15 (int16_t) real and imaginary arrays.  Every butterfly 
+/// stage scales its output by 1/2, so the result is the DFT divided by 
+/// size and full scale input can't overflow.  A full scale sine wave at 
+/// bin k shows up as a magnitude of 1/2 full scale at bins k and size-k.
+///
+/// The twiddle tables are built once at construction and everything 
+/// after that is integer math with no allocation.
+///
+/// log2Size  log2 of the number of points (i.e., 8 for a 256 point FFT)
+///
+template< unsigned int log2Size >
+class FixedFFT
+{
+  public:
+
+  static constexpr std::size_t size = std::size_t(1) << log2Size;
+  using array_t = std::array< int16_t, size >;
+
+  FixedFFT()
+  {
+    const double pi = 3.14159265358979323846;
+    for ( std::size_t i = 0; i < size / 2; ++i )
+    {
+      const double angle = 2.0 * pi * i / size;
+      cosTable[i] = static_cast<int16_t>( std::lround( std::cos( angle ) * 32767.0 ));
+      sinTable[i] = static_cast<int16_t>( std::lround( std::sin( angle ) * 32767.0 ));
+    }
+  }
+
+  /// @brief Forward FFT of re + j*im, in place.  Output is scaled by 1/size
+  void transform( array_t& re, array_t& im ) const
+  {
+    // Bit reversal permutation
+    for ( std::size_t i = 1, j = 0; i < size; ++i )
+    {
+      std::size_t bit = size >> 1;
+      for ( ; j & bit; bit >>= 1 )
+      {
+        j ^= bit;
+      }
+      j ^= bit;
+      if ( i < j )
+      {
+        std::swap( re[i], re[j] );
+        std::swap( im[i], im[j] );
+      }
+    }
+
+    // Butterflies
+    for ( std::size_t len = 2, step = size / 2; len <= size; len <<= 1, step >>= 1 )
+    {
+      const std::size_t half = len / 2;
+      for ( std::size_t i = 0; i < size; i += len )
+      {
+        for ( std::size_t j = 0; j < half; ++j )
+        {
+          const int32_t wr = cosTable[ j * step ];
+          const int32_t wi = -sinTable[ j * step ];
+          const std::size_t a = i + j;
+          const std::size_t b = a + half;
+          const int32_t tr = ( wr * re[b] - wi * im[b] ) >> 15;
+          const int32_t ti = ( wr * im[b] + wi * re[b] ) >> 15;
+          const int32_t ar = re[a];
+          const int32_t ai = im[a];
+          re[b] = static_cast<int16_t>(( ar - tr ) >> 1 );
+          im[b] = static_cast<int16_t>(( ai - ti ) >> 1 );
+          re[a] = static_cast<int16_t>(( ar + tr ) >> 1 );
+          im[a] = static_cast<int16_t>(( ai + ti ) >> 1 );
+        }
+      }
+    }
+  }
+
+  /// @brief Squared magnitude of bin i after a transform
+  static uint32_t magnitudeSquared( const array_t& re, const array_t& im, std::size_t i )
+  {
+    return static_cast<uint32_t>( int32_t( re[i] ) * re[i] + int32_t( im[i] ) * im[i] );
+  }
+
+  private:
+
+  std::array< int16_t, size / 2 > cosTable;
+  std::array< int16_t, size / 2 > sinTable;
+};
+
+template< unsigned int log2Size >
+constexpr std::size_t FixedFFT< log2Size >::size;
+
+#endif
+
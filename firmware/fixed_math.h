@@ -0,0 +1,58 @@
+#ifndef __FIXED_MATH_H__
+#define __FIXED_MATH_H__
+
+#include <cstdint>
+
+namespace BeeFocus
+{
+  ///
+  /// @brief Position of the highest set bit, i.e., floor( log2( x ))
+  ///
+  /// @return -1 if x is 0
+  ///
+  inline int log2Floor( uint64_t x )
+  {
+    int result = -1;
+    while ( x ) 
+    {
+      x >>= 1;
+      ++result;
+    }
+    return result;
+  }
+
+  ///
+  /// @brief log2( x ) in 24.8 fixed point
+  ///
+  /// Integer part from the highest set bit, fractional part from the next
+  /// 8 bits with a quadratic correction.  Good to about 0.01.
+  ///
+  /// @return 0 if x is 0
+  ///
+  inline int log2Q8( uint64_t x )
+  {
+    const int e = log2Floor( x );
+    if ( e < 0 ) 
+    {
+      return 0;
+    }
+    const unsigned int f = static_cast<unsigned int>(
+      ( e >= 8 ? ( x >> ( e - 8 )) : ( x << ( 8 - e ))) & 0xff );
+    // log2( 1 + f ) ~= f + 0.3466 * f * ( 1 - f )
+    return e * 256 + f + (( f * ( 256 - f ) * 89 ) >> 16 );
+  }
+
+  ///
+  /// @brief 10 * log10( x ), rounded to the nearest dB.  
+  ///
+  /// For a mean square value this is the level in dB.  0 if x is 0.
+  ///
+  inline int db10( uint64_t x )
+  {
+    // 10 * log10( 2 ) = 3.0103 ~= 771 / 256
+    return ( log2Q8( x ) * 771 + ( 1 << 15 )) >> 16;
+  }
+};
+
+#endif
+
@@ -0,0 +1,185 @@
+#ifndef __GOERTZEL_H__
+#define __GOERTZEL_H__
+
+#include <array>
+#include <cmath>      // for cos at setup only
+#include <cstddef>
+#include <cstdint>
+
+///
+/// @brief A frequency band, i.e. { "hum", 100, 600 }
+///
+struct GoertzelBandSpec
+{
+  const char* name;
+  unsigned int lowHz;
+  unsigned int highHz;
+};
+
+///
+/// @brief Streaming Goertzel filter that measures the energy in a band
+///
+/// The filter is tuned to the middle of the band and run over blocks of
+/// sampleRate / bandwidth samples, which puts the -4 dB points of its main
+/// lobe on the band edges and the first nulls one bandwidth out from the 
+/// center.  Tones just outside a wide band still leak in on the skirts.
+/// Block results are averaged, so a whole window can be streamed through 
+/// one sample at a time without being stored.
+///
+/// The coefficient is Q14 and the state is 32 bit, with 64 bit products, 
+/// so 16 bit input can't overflow.
+///
+class GoertzelFilter
+{
+  public:
+
+  GoertzelFilter() : coeffQ14{ 0 }, blockSize{ 1 }
+  {
+    reset();
+  }
+
+  ///
+  /// @brief Tune the filter
+  ///
+  /// @param[in] spec         - The band
+  /// @param[in] sampleRateHz - The rate samples will arrive at
+  ///
+  void setup( const GoertzelBandSpec& spec, unsigned int sampleRateHz )
+  {
+    const double pi = 3.14159265358979323846;
+    const double centerHz = ( spec.lowHz + spec.highHz ) / 2.0;
+    const unsigned int width = spec.highHz > spec.lowHz ? spec.highHz - spec.lowHz : 1;
+    blockSize = sampleRateHz / width;
+    blockSize = blockSize ? blockSize : 1;
+    coeffQ14 = static_cast<int32_t>( std::lround( 
+      2.0 * std::cos( 2.0 * pi * centerHz / sampleRateHz ) * 16384.0 ));
+    reset();
+  }
+
+  /// @brief Forget everything but the tuning
+  void reset()
+  {
+    s1 = 0;
+    s2 = 0;
+    n = 0;
+    sum = 0;
+    blocks = 0;
+  }
+
+  /// @brief Add a sample.  The DC bias should already be removed
+  void insert( int32_t sample )
+  {
+    const int32_t s0 = sample + 
+      static_cast<int32_t>(( int64_t( coeffQ14 ) * s1 ) >> 14 ) - s2;
+    s2 = s1;
+    s1 = s0;
+    if ( ++n == blockSize )
+    {
+      // |X|^2 = s1^2 + s2^2 - coeff * s1 * s2.  A sine wave of amplitude 
+      // A gives |X| = A * N / 2, so 2 |X|^2 / N^2 is its mean square.
+      const int64_t power = int64_t( s1 ) * s1 + int64_t( s2 ) * s2 -
+        (( int64_t( coeffQ14 ) * s1 >> 14 ) * s2 );
+      sum += static_cast<uint64_t>( power > 0 ? power : 0 ) * 2 / 
+        ( uint64_t( blockSize ) * blockSize );
+      ++blocks;
+      s1 = 0;
+      s2 = 0;
+      n = 0;
+    }
+  }
+
+  /// @brief Mean square amplitude in the band over all complete blocks
+  uint64_t getMeanSquare() const
+  {
+    return blocks ? sum / blocks : 0;
+  }
+
+  unsigned int getBlockSize() const { return blockSize; }
+
+  private:
+
+  int32_t coeffQ14;
+  unsigned int blockSize;
+  int32_t s1;
+  int32_t s2;
+  unsigned int n;
+  uint64_t sum;
+  unsigned int blocks;
+};
+
+///
+/// @brief A set of Goertzel filters fed from the same stream
+///
+/// Removes the stream's DC bias before filtering.  If no bias is set 
+/// after a reset, the first sample is used.
+///
+/// num_bands  The number of bands
+///
+template< std::size_t num_bands >
+class GoertzelBank
+{
+  public:
+
+  using spec_array_t = std::array< GoertzelBandSpec, num_bands >;
+
+  GoertzelBank( const spec_array_t& specArg, unsigned int sampleRateHz ) 
+    : specs( specArg ) 
+  {
+    for ( std::size_t i = 0; i < num_bands; ++i )
+    {
+      filters[i].setup( specs[i], sampleRateHz );
+    }
+    reset();
+  }
+
+  /// @brief Start a new window
+  void reset()
+  {
+    for ( auto& f : filters )
+    {
+      f.reset();
+    }
+    bias = 0;
+    biasKnown = false;
+  }
+
+  /// @brief Set the DC bias that's removed from each sample
+  void setBias( int32_t biasArg )
+  {
+    bias = biasArg;
+    biasKnown = true;
+  }
+
+  void insert( unsigned short sample )
+  {
+    if ( !biasKnown ) 
+    {
+      setBias( sample );
+    }
+    const int32_t x = int32_t( sample ) - bias;
+    for ( auto& f : filters )
+    {
+      f.insert( x );
+    }
+  }
+
+  /// @brief Mean square amplitude in band i over the current window
+  uint64_t getMeanSquare( std::size_t i ) const 
+  { 
+    return filters[i].getMeanSquare(); 
+  }
+
+  const GoertzelBandSpec& getSpec( std::size_t i ) const { return specs[i]; }
+
+  static constexpr std::size_t size() { return num_bands; }
+
+  private:
+
+  const spec_array_t specs;
+  std::array< GoertzelFilter, num_bands > filters;
+  int32_t bias;
+  bool biasKnown;
+};
+
+#endif
+
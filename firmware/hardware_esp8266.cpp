@@ -1,36 +1,63 @@
 #include <ESP8266WiFi.h>
 #include "hardware_esp8266.h"
 
-const std::unordered_map<HWI::Pin, int, EnumHash > HardwareESP8266::pinMap = {
-};
+constexpr BeeFocus::EnumTable< HWI::Pin, int,
+  (std::size_t) HWI::Pin::END_OF_PINS > HardwareESP8266::pinMap = {{
+  { Pin::MICROPHONE,          A0 },
+}};
 
-const std::unordered_map<HWI::PinState, int, EnumHash > HardwareESP8266::pinStateMap = {
+constexpr BeeFocus::EnumTable< HWI::PinState, int,
+  (std::size_t) HWI::PinState::END_OF_PIN_STATES > HardwareESP8266::pinStateMap = {{
   //{ PinState::HOME_INACTIVE,  HIGH },    // Active low
   //{ PinState::HOME_ACTIVE,    LOW},      // Active low
-};
+  { PinState::DUMMY_INACTIVE, LOW },
+}};
+
+// Every pin and pin state needs exactly one entry, in enum order
+void HardwareESP8266::checkTables()
+{
+  static_assert( pinMap.isDense(), "Every Pin needs an Arduino pin, in order" );
+  static_assert( pinStateMap.isDense(), "Every PinState needs a level, in order" );
+}
 
 void HardwareESP8266::DigitalWrite( Pin pin, PinState state )
 {
-  int actualPin = pinMap.at( pin );
-  int actualState = pinStateMap.at( state );
+  int actualPin = pinMap[ pin ];
+  int actualState = pinStateMap[ state ];
   digitalWrite( actualPin, actualState );
 }
 
 void HardwareESP8266::PinMode( Pin pin, PinIOMode mode )
 {
-  int actualPin = pinMap.at( pin );
+  int actualPin = pinMap[ pin ];
   pinMode( actualPin, mode == PinIOMode::M_OUTPUT ? OUTPUT : INPUT );
 }
 
 HWI::PinState HardwareESP8266::DigitalRead( Pin pin)
 {
-  int actualPin = pinMap.at( pin );
+  int actualPin = pinMap[ pin ];
   return PinState::DUMMY_INACTIVE;
 }
 
 unsigned int HardwareESP8266::AnalogRead( Pin pin)
 {
-  return analogRead( A0 );
+  return analogRead( pinMap[ pin ] );
 }
 
+void HardwareESP8266::AnalogReadBurst( Pin pin, unsigned short* buffer,
+  std::size_t count, unsigned int intervalUs )
+{
+  // Pace the reads off micros() instead of calling delayMicroseconds, so
+  // the time analogRead takes doesn't stretch the sample interval.
+  const int actualPin = pinMap[ pin ];
+  unsigned long next = micros();
+  for ( std::size_t i = 0; i < count; ++i )
+  {
+    while ( (long) ( micros() - next ) < 0 )
+    {
+    }
+    buffer[i] = analogRead( actualPin );
+    next += intervalUs;
+  }
+}
 
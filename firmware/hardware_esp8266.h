@@ -11,11 +11,19 @@ class HardwareESP8266: public HWI
   void     PinMode( Pin pin, PinIOMode state ) override;
   PinState DigitalRead( Pin pin) override;
   unsigned AnalogRead( Pin pin) override;
+  void     AnalogReadBurst( Pin pin, unsigned short* buffer,
+             std::size_t count, unsigned int intervalUs ) override;
 
   private:
  
-  static const std::unordered_map<HWI::Pin, int, EnumHash > pinMap;
-  static const std::unordered_map<HWI::PinState, int, EnumHash > pinStateMap;
+  /// @brief Arduino pin numbers and levels, indexed by enum
+  static const BeeFocus::EnumTable< HWI::Pin, int,
+    (std::size_t) HWI::Pin::END_OF_PINS > pinMap;
+  static const BeeFocus::EnumTable< HWI::PinState, int,
+    (std::size_t) HWI::PinState::END_OF_PIN_STATES > pinStateMap;
+
+  /// @brief Compile time checks of the tables above.  Never called.
+  static void checkTables();
 };
 
 #endif
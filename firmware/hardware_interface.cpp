@@ -1,16 +1,22 @@
 #include "hardware_interface.h"
 
-const std::unordered_map<HWI::Pin,std::string,EnumHash> HWI::pinNames = {
+constexpr BeeFocus::EnumTable< HWI::Pin, const char*,
+  (std::size_t) HWI::Pin::END_OF_PINS > HWI::pinNames = {{
     { Pin::MICROPHONE, "Microphone" },
-};
+}};
 
-const std::unordered_map<HWI::PinState,std::string,EnumHash> HWI::pinStateNames = {
+constexpr BeeFocus::EnumTable< HWI::PinState, const char*,
+  (std::size_t) HWI::PinState::END_OF_PIN_STATES > HWI::pinStateNames = {{
     //{ PinState::STEP_ACTIVE,     "Step Active" },
   { PinState::DUMMY_INACTIVE,     "place holder" }
-};
+}};
 
-const std::unordered_map<HWI::PinIOMode,std::string,EnumHash> HWI::pinIOModeNames = {
-    { PinIOMode::M_INPUT,        "Input" },
-    { PinIOMode::M_OUTPUT,       "Output" }
-};
+constexpr BeeFocus::EnumTable< HWI::PinIOMode, const char*,
+  (std::size_t) HWI::PinIOMode::END_OF_IO_MODES > HWI::pinIOModeNames = {{
+    { PinIOMode::M_OUTPUT,       "Output" },
+    { PinIOMode::M_INPUT,        "Input" }
+}};
 
+static_assert( HWI::pinNames.isDense(), "Every Pin needs a name, in order" );
+static_assert( HWI::pinStateNames.isDense(), "Every PinState needs a name, in order" );
+static_assert( HWI::pinIOModeNames.isDense(), "Every PinIOMode needs a name, in order" );
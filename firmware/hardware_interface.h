@@ -3,6 +3,7 @@
 
 #include <unordered_map>
 #include <string>
+#include <cstddef>
 #include "basic_types.h"
 
 struct EnumHash
@@ -42,14 +43,32 @@ class HWI
     END_OF_IO_MODES
   };
 
-  const static std::unordered_map<Pin,std::string,EnumHash> pinNames;
-  const static std::unordered_map<PinState,std::string,EnumHash> pinStateNames;
-  const static std::unordered_map<PinIOMode,std::string,EnumHash> pinIOModeNames;
+  /// @brief Debug names, indexed by enum
+  const static BeeFocus::EnumTable< Pin, const char*,
+    (std::size_t) Pin::END_OF_PINS > pinNames;
+  const static BeeFocus::EnumTable< PinState, const char*,
+    (std::size_t) PinState::END_OF_PIN_STATES > pinStateNames;
+  const static BeeFocus::EnumTable< PinIOMode, const char*,
+    (std::size_t) PinIOMode::END_OF_IO_MODES > pinIOModeNames;
 
   virtual void DigitalWrite( Pin pin, PinState state ) = 0;
   virtual void PinMode( Pin pin, PinIOMode mode ) = 0;
   virtual unsigned AnalogRead( Pin pin ) = 0;
   virtual PinState DigitalRead( Pin pin) = 0;
+
+  ///
+  /// @brief Read a block of samples from an analog pin
+  ///
+  /// @param[in]  pin        - The pin to read
+  /// @param[out] buffer     - Where the samples go.  Must hold count samples
+  /// @param[in]  count      - The number of samples to read
+  /// @param[in]  intervalUs - Time between the start of each read, in us
+  ///
+  /// Blocks for roughly count * intervalUs, so keep count small enough
+  /// that the other actions still get a look in.
+  ///
+  virtual void AnalogReadBurst( Pin pin, unsigned short* buffer,
+    std::size_t count, unsigned int intervalUs ) = 0;
 };
 
 // @brief Increment operator for Hardware Interface Pin
@@ -2,8 +2,11 @@
 #define __HISTOGRAM_H__
 
 #include <algorithm>    // for std::min
+#include <array>        // for std::array
 #include <numeric>      // for std::accumulate
+#include <type_traits>  // for std::integral_constant
 #include <iostream>     // for debugging.
+#include "histogram_bins.h"
 
 ///
 /// @brief Histogram Template...
@@ -14,17 +17,28 @@
 /// T         The data-type we're sampling (i.e., floats, ints, most needs
 ///           a subtract, multiply, and a divide )
 /// num_bins  The number of bins in the histogram
-/// min       The minimum value
-/// max       The maximum value.
+/// BinPolicy How samples map to bins.  See histogram_bins.h.  Defaults
+///           to evenly spaced bins between min and max.
 ///
-template< class T, unsigned int num_bins >
+template< class T, unsigned int num_bins, 
+          class BinPolicy = LinearBins< T, num_bins > >
 class Histogram
 {
+  static_assert( BinPolicy::numBins == num_bins, 
+    "Histogram and BinPolicy disagree on the number of bins" );
+
   public:
 
   using array_t = std::array<unsigned int, (std::size_t) num_bins>;
+  using policy_t = BinPolicy;
+
+  Histogram( T min_r, T max_r ) : bins{ min_r, max_r }
+  {
+    reset();
+  }
 
-  Histogram( T min_r, T max_r ) : min_range{ min_r }, max_range{ max_r }
+  /// @brief For policies that don't need a range (i.e., EdgeTableBins)
+  Histogram() : bins{}
   {
     reset();
   }
@@ -34,21 +48,74 @@ class Histogram
     for ( auto& i : samples ) {
       i = 0U;
     }   
+    bins.reset();
   }
 
   void insert( T sample )
   {
-    const T range = max_range - min_range;
-    const T from_min = sample - min_range;
-    int bucket = ((int) (((T) num_bins ) * from_min )) / ((int) range);
-    // bucket may be out of bounds, and that's okay.  clip.
-    bucket = std::min( bucket, (int) (num_bins-1) );
-    bucket = std::max( bucket, 0 );
-    ++samples[ bucket ];
+    fitRange( sample, std::integral_constant< bool, BinPolicy::autoRange >() );
+    ++samples[ bins.bin( sample ) ];
+  }
+
+  ///
+  /// @brief Add another histogram's counts to this one
+  ///
+  /// Both must have been constructed with the same range.  Auto ranging
+  /// histograms are widened to match first, so they can be merged even
+  /// if they have grown differently.
+  ///
+  void merge( const Histogram& other )
+  {
+    mergeCounts( other, std::integral_constant< bool, BinPolicy::autoRange >() );
+  }
+
+  /// @brief Total number of samples in all bins
+  unsigned int getTotal() const
+  {
+    return std::accumulate( samples.begin(), samples.end(), 0U );
+  }
+
+  ///
+  /// @brief Approximate percentile
+  ///
+  /// @param[in] percent - 0 to 100
+  /// @return The lower edge of the bin holding the percentile sample
+  ///
+  T getPercentile( unsigned int percent ) const
+  {
+    const unsigned int total = getTotal();
+    const unsigned int rank = ( total * percent ) / 100;
+    unsigned int seen = 0;
+    for ( unsigned int i = 0; i < num_bins; ++i )
+    {
+      seen += samples[i];
+      if ( seen > rank ) 
+      {
+        return bins.lowerEdge( i );
+      }
+    }
+    return bins.lowerEdge( num_bins - 1 );
+  }
+
+  /// @brief Save or restore the counts (see snapshot.h)
+  template< class Archive >
+  void serialize( Archive& ar )
+  {
+    ar.io( samples );
+    bins.serialize( ar );
   }
 
+  /// @brief Raw number of samples in a bin
+  unsigned int getCount( unsigned int bin ) const { return samples[ bin ]; }
+
+  /// @brief The bin a sample would go into
+  unsigned int getBin( T sample ) const { return bins.bin( sample ); }
+
+  /// @brief The smallest sample that goes into a bin
+  T getLowerEdge( unsigned int bin ) const { return bins.lowerEdge( bin ); }
+
   /// @brief takes the current samples and returns a histogram
-  void get_histogram( array_t& histogram )
+  void get_histogram( array_t& histogram ) const
   {
     histogram = samples;
     unsigned int total_left = std::accumulate( histogram.begin(), histogram.end(), 0 );
@@ -65,10 +132,53 @@ class Histogram
   }
 
   private:
+
+  void fitRange( T, std::false_type ) {}
+
+  /// @brief Widen the bins until the sample fits
+  void fitRange( T sample, std::true_type )
+  {
+    while ( !bins.covers( sample ))
+    {
+      widen();
+    }
+  }
+
+  /// @brief Double the bin width, merging pairs of bins
+  void widen()
+  {
+    bins.widen();
+    for ( unsigned int i = 0; i < num_bins; ++i )
+    {
+      const unsigned int lo = 2 * i;
+      samples[i] = ( lo < num_bins ? samples[ lo ] : 0 ) +
+                   ( lo + 1 < num_bins ? samples[ lo + 1 ] : 0 );
+    }
+  }
+
+  void mergeCounts( const Histogram& other, std::false_type )
+  {
+    for ( unsigned int i = 0; i < num_bins; ++i )
+    {
+      samples[i] += other.samples[i];
+    }
+  }
+
+  void mergeCounts( const Histogram& other, std::true_type )
+  {
+    while ( bins.getShift() < other.bins.getShift() )
+    {
+      widen();
+    }
+    const unsigned int extra = bins.getShift() - other.bins.getShift();
+    for ( unsigned int i = 0; i < num_bins; ++i )
+    {
+      samples[ i >> extra ] += other.samples[i];
+    }
+  }
+
   array_t samples;
-  const T min_range;
-  const T max_range;
+  BinPolicy bins;
 };
 
 #endif
-
@@ -0,0 +1,313 @@
+#ifndef __HISTOGRAM_BINS_H__
+#define __HISTOGRAM_BINS_H__
+
+#include <algorithm>    // for std::min, std::upper_bound
+#include <cstdint>      // for uint64_t
+#include <limits>       // for std::numeric_limits
+#include <type_traits>  // for std::is_integral
+
+///
+/// @brief Bin mapping policies for Histogram
+///
+/// A policy turns a sample into a bin index and is picked at compile time,
+/// so Histogram::insert pays only for the mapping it uses.  Every policy
+/// provides:
+///
+/// numBins                 - The number of bins it maps to
+/// autoRange               - True if the range can grow (see AutoRangeBins)
+/// Policy( T min, T max )  - Construct for a range
+/// reset()                 - Go back to the range given at construction
+/// bin( T sample )         - The bin for a sample, clipped to the edge bins
+/// lowerEdge( bin )        - The smallest sample that maps to a bin
+/// serialize( ar )         - Save or restore any state that can change
+///                           (see snapshot.h)
+///
+
+namespace BeeFocus
+{
+  /// @brief floor( log2( x )) for x > 0, without a loop where possible
+  inline unsigned int highBit( uint64_t x )
+  {
+#if defined( __GNUC__ )
+    return 63 - __builtin_clzll( x );
+#else
+    unsigned int result = 0;
+    while ( x >>= 1 )
+    {
+      ++result;
+    }
+    return result;
+#endif
+  }
+
+  ///
+  /// @brief HDR style logarithmic bucket for a value
+  ///
+  /// Values below 2^sub_bits get their own bucket.  After that every power
+  /// of 2 is split into 2^sub_bits buckets.
+  ///
+  inline unsigned int log2Bucket( uint64_t v, unsigned int sub_bits )
+  {
+    if ( v < ( 1u << sub_bits ))
+    {
+      return (unsigned int) v;
+    }
+    const unsigned int e = highBit( v );
+    const unsigned int mantissa = (unsigned int) ( v >> ( e - sub_bits )) & (( 1u << sub_bits ) - 1 );
+    return (( e - sub_bits + 1 ) << sub_bits ) + mantissa;
+  }
+
+  /// @brief The smallest value in a log2Bucket
+  inline uint64_t log2BucketLowerEdge( unsigned int bucket, unsigned int sub_bits )
+  {
+    const unsigned int subBuckets = 1u << sub_bits;
+    if ( bucket < subBuckets )
+    {
+      return bucket;
+    }
+    const unsigned int e = ( bucket >> sub_bits ) + sub_bits - 1;
+    const uint64_t mantissa = bucket & ( subBuckets - 1 );
+    return ( subBuckets + mantissa ) << ( e - sub_bits );
+  }
+}
+
+///
+/// @brief Evenly spaced bins across [min, max].  The original mapping.
+///
+/// Works for floats.  Costs a multiply and an integer divide per insert.
+///
+template< class T, unsigned int num_bins >
+class LinearBins
+{
+  public:
+
+  static constexpr unsigned int numBins = num_bins;
+  static constexpr bool autoRange = false;
+
+  LinearBins( T min_r, T max_r ) : min_range{ min_r }, max_range{ max_r }
+  {
+  }
+
+  void reset() {}
+
+  template< class Archive >
+  void serialize( Archive& ) {}
+
+  unsigned int bin( T sample ) const
+  {
+    const T range = max_range - min_range;
+    const T from_min = sample - min_range;
+    int bucket = ((int) (((T) num_bins ) * from_min )) / ((int) range);
+    // bucket may be out of bounds, and that's okay.  clip.
+    bucket = std::min( bucket, (int) (num_bins-1) );
+    bucket = std::max( bucket, 0 );
+    return (unsigned int) bucket;
+  }
+
+  T lowerEdge( unsigned int bin ) const
+  {
+    return min_range + ( max_range - min_range ) * ((T) bin ) / ((T) num_bins );
+  }
+
+  private:
+  const T min_range;
+  const T max_range;
+};
+
+///
+/// @brief Bins that are a power of 2 wide, starting at min
+///
+/// The width is the smallest power of 2 that fits [min, max] into the
+/// bins, so the top bin may reach a little past max.  Costs a subtract and
+/// a shift per insert.  Integer samples only.
+///
+template< class T, unsigned int num_bins >
+class ShiftBins
+{
+  static_assert( std::is_integral< T >::value, "ShiftBins needs integer samples" );
+
+  public:
+
+  static constexpr unsigned int numBins = num_bins;
+  static constexpr bool autoRange = false;
+
+  ShiftBins( T min_r, T max_r ) : min_range{ min_r }, initialShift{ 0 }
+  {
+    while ( ( (uint64_t) ( max_r - min_r ) >> initialShift ) >= num_bins )
+    {
+      ++initialShift;
+    }
+    shift = initialShift;
+  }
+
+  void reset() { shift = initialShift; }
+
+  template< class Archive >
+  void serialize( Archive& ar ) { ar.io( shift ); }
+
+  unsigned int bin( T sample ) const
+  {
+    if ( sample < min_range )
+    {
+      return 0;
+    }
+    const uint64_t bucket = (uint64_t) ( sample - min_range ) >> shift;
+    return bucket < num_bins ? (unsigned int) bucket : num_bins - 1;
+  }
+
+  T lowerEdge( unsigned int bin ) const
+  {
+    return min_range + (T) ( (uint64_t) bin << shift );
+  }
+
+  /// @brief log2 of the bin width
+  unsigned int getShift() const { return shift; }
+
+  protected:
+  const T min_range;
+  unsigned int initialShift;
+  unsigned int shift;
+};
+
+///
+/// @brief Shift bins that double in width instead of clipping
+///
+/// When a sample lands past the top bin the width doubles and Histogram
+/// merges each pair of neighbouring bins, so no counts are lost and
+/// memory stays fixed.  The bottom of the range never moves; samples
+/// below min still go into bin 0.
+///
+template< class T, unsigned int num_bins >
+class AutoRangeBins : public ShiftBins< T, num_bins >
+{
+  static_assert( num_bins >= 2, "AutoRangeBins needs at least 2 bins" );
+
+  public:
+
+  static constexpr bool autoRange = true;
+
+  AutoRangeBins( T min_r, T max_r ) : ShiftBins< T, num_bins >( min_r, max_r )
+  {
+  }
+
+  /// @brief True if the sample fits without widening the bins
+  bool covers( T sample ) const
+  {
+    return sample < this->min_range ||
+      ( (uint64_t) ( sample - this->min_range ) >> this->shift ) < num_bins;
+  }
+
+  /// @brief Double the bin width.  The caller merges the counts.
+  void widen() { ++this->shift; }
+};
+
+///
+/// @brief HDR style logarithmic bins
+///
+/// The first 2^sub_bits bins are 1 wide.  After that every power of 2
+/// is split into 2^sub_bits bins, so the relative error of a bin is at
+/// most 1 / 2^sub_bits however large the sample gets.  With sub_bits 2 and
+/// 32 bins the range is [min, min + 2^9).  max is not used; the bin count
+/// sets the range.  Costs a count leading zeros and a few shifts per
+/// insert.  Integer samples only.
+///
+template< class T, unsigned int num_bins, unsigned int sub_bits = 2 >
+class Log2Bins
+{
+  static_assert( std::is_integral< T >::value, "Log2Bins needs integer samples" );
+
+  public:
+
+  static constexpr unsigned int numBins = num_bins;
+  static constexpr bool autoRange = false;
+
+  Log2Bins( T min_r, T max_r ) : min_range{ min_r }
+  {
+    (void) max_r;
+  }
+
+  void reset() {}
+
+  template< class Archive >
+  void serialize( Archive& ) {}
+
+  unsigned int bin( T sample ) const
+  {
+    if ( sample < min_range )
+    {
+      return 0;
+    }
+    const unsigned int bucket = BeeFocus::log2Bucket( (uint64_t) ( sample - min_range ), sub_bits );
+    return std::min( bucket, num_bins - 1 );
+  }
+
+  T lowerEdge( unsigned int bin ) const
+  {
+    return min_range + (T) BeeFocus::log2BucketLowerEdge( bin, sub_bits );
+  }
+
+  private:
+  const T min_range;
+};
+
+namespace BeeFocus
+{
+  template< class T >
+  constexpr bool ascending( T ) { return true; }
+
+  /// @brief True if the arguments are in strictly ascending order
+  template< class T, class... Rest >
+  constexpr bool ascending( T a, T b, Rest... rest )
+  {
+    return a < b && ascending( b, rest... );
+  }
+}
+
+///
+/// @brief Bins with hand picked edges, fixed at compile time
+///
+/// Each edge is the lower edge of the next bin, so N edges make N+1
+/// bins: ( -inf, e0 ), [ e0, e1 ), ... [ eN-1, inf ).  The constructor's
+/// range is not used.  Costs a binary search of the edge table per insert.
+///
+template< class T, T... edges >
+class EdgeTableBins
+{
+  static_assert( sizeof...( edges ) >= 1, "EdgeTableBins needs at least one edge" );
+  static_assert( BeeFocus::ascending( edges... ), "EdgeTableBins edges must ascend" );
+
+  public:
+
+  static constexpr unsigned int numBins = sizeof...( edges ) + 1;
+  static constexpr bool autoRange = false;
+
+  EdgeTableBins( T min_r = T(), T max_r = T() )
+  {
+    (void) min_r;
+    (void) max_r;
+  }
+
+  void reset() {}
+
+  template< class Archive >
+  void serialize( Archive& ) {}
+
+  unsigned int bin( T sample ) const
+  {
+    return (unsigned int) ( std::upper_bound( edgeTable, edgeTable + numBins - 1, sample ) - edgeTable );
+  }
+
+  T lowerEdge( unsigned int bin ) const
+  {
+    return bin ? edgeTable[ bin - 1 ] : std::numeric_limits< T >::lowest();
+  }
+
+  private:
+  static constexpr T edgeTable[ sizeof...( edges ) ] = { edges... };
+};
+
+template< class T, T... edges >
+constexpr T EdgeTableBins< T, edges... >::edgeTable[];
+
+#endif
+
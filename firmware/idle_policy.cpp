@@ -0,0 +1,50 @@
+#include <algorithm>
+#include <cstdint>
+#include "idle_policy.h"
+
+constexpr unsigned int BreakEvenPolicy::never;
+
+const SleepStates BreakEvenPolicy::esp8266 = {{
+  { 231000,    0,    0 },     // AWAKE, 70 mA
+  {  49500, 1000,  100 },     // MODEM, 15 mA
+  {   2970, 3000, 1000 },     // LIGHT, 0.9 mA
+}};
+
+BreakEvenPolicy::BreakEvenPolicy( 
+  const SleepStates& statesArg, unsigned int maxLatencyUs ) : states{ statesArg }
+{
+  const unsigned int awakeUw = getState( SleepDepth::AWAKE ).powerUw;
+  for ( std::size_t d = 0; d < states.size(); ++d )
+  {
+    const SleepState& s = states[ d ];
+    if ( d == (std::size_t) SleepDepth::AWAKE ) 
+    {
+      minWindowUs[ d ] = 0;
+      continue;
+    }
+    if ( s.exitLatencyUs > maxLatencyUs || s.powerUw >= awakeUw )
+    {
+      minWindowUs[ d ] = never;
+      continue;
+    }
+    // uJ / uW is seconds, so scale to us
+    const uint64_t breakEvenUs = 
+      uint64_t( s.transitionUj ) * 1000000 / ( awakeUw - s.powerUw );
+    minWindowUs[ d ] = (unsigned int) std::min< uint64_t >( never,
+      std::max< uint64_t >( breakEvenUs, s.exitLatencyUs ));
+  }
+}
+
+SleepDepth BreakEvenPolicy::choose( unsigned int idleUs )
+{
+  std::size_t best = (std::size_t) SleepDepth::AWAKE;
+  for ( std::size_t d = 0; d < states.size(); ++d )
+  {
+    if ( minWindowUs[ d ] != never && idleUs >= minWindowUs[ d ] &&
+         states[ d ].powerUw <= states[ best ].powerUw ) {
+      best = d;
+    }
+  }
+  return (SleepDepth) best;
+}
+
@@ -0,0 +1,73 @@
+#ifndef __IDLE_POLICY_H__
+#define __IDLE_POLICY_H__
+
+#include "power_interface.h"
+
+///
+/// @brief Picks how deeply to sleep through an idle window
+///
+class IdlePolicy
+{
+  public:
+
+  virtual ~IdlePolicy() {}
+
+  /// @brief The depth to sleep at for the next idleUs
+  virtual SleepDepth choose( unsigned int idleUs ) = 0;
+
+  /// @brief What a depth costs
+  virtual const SleepState& getState( SleepDepth depth ) const = 0;
+};
+
+///
+/// @brief Sleep as deeply as pays for itself
+///
+/// A depth pays for itself if the window is longer than the time it takes
+/// the power saved to make up for the energy spent going in and out,
+/// and longer than the time to wake up.  Depths that take longer than
+/// maxLatencyUs to wake from are never used, so input is still answered
+/// promptly.  The deepest depth that fits is picked.
+///
+class BreakEvenPolicy : public IdlePolicy
+{
+  public:
+
+  ///
+  /// @brief Constructor
+  ///
+  /// @param[in] statesArg    - The cost of each depth
+  /// @param[in] maxLatencyUs - Longest acceptable wake up time
+  ///
+  BreakEvenPolicy( const SleepStates& statesArg, unsigned int maxLatencyUs );
+
+  SleepDepth choose( unsigned int idleUs ) override;
+
+  const SleepState& getState( SleepDepth depth ) const override
+  {
+    return states[ (std::size_t) depth ];
+  }
+
+  /// @brief Shortest window each depth is used for
+  unsigned int getMinWindowUs( SleepDepth depth ) const
+  {
+    return minWindowUs[ (std::size_t) depth ];
+  }
+
+  ///
+  /// @brief Rough ESP8266 figures at 3.3V, from the datasheet
+  ///
+  /// Good enough to rank the depths.  They aren't measured, so energy
+  /// worked out from them (see PowerSim) is an estimate.
+  ///
+  static const SleepStates esp8266;
+
+  private:
+
+  static constexpr unsigned int never = ~0u;
+
+  const SleepStates states;
+  std::array< unsigned int, (std::size_t) SleepDepth::END_OF_DEPTHS > minWindowUs;
+};
+
+#endif
+
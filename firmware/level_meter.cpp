@@ -0,0 +1,106 @@
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include "level_meter.h"
+
+constexpr unsigned int LevelMeter::fastMs;
+constexpr unsigned int LevelMeter::slowMs;
+constexpr int32_t LevelMeter::dcPoleQ15;
+
+LevelMeter::LevelMeter( 
+  unsigned int sampleRateHz,
+  unsigned int timeConstantMs,
+  bool aWeighted,
+  int calibrationDbArg 
+) : weighted{ aWeighted }, calibrationDb{ calibrationDbArg },
+    primed{ false }, lastX8{ 0 }, dcY8{ 0 },
+    weighted16{ 0 }, max16{ 0 }, sumSq16{ 0 }, count{ 0 }
+{
+  // alpha = 1 / ( tau * fs )
+  const uint64_t samplesPerTau = 
+    std::max< uint64_t >( 1, uint64_t( sampleRateHz ) * timeConstantMs / 1000 );
+  alphaQ16 = std::max< int64_t >( 1, 65536 / samplesPerTau );
+
+  for ( auto& section : aWeighting )
+  {
+    section = FixedBiquad{ 1 << 14, 0, 0, 0, 0, 0, 0, 0, 0 };
+  }
+  if ( weighted )
+  {
+    designAWeighting( sampleRateHz );
+  }
+}
+
+void LevelMeter::reset()
+{
+  max16 = weighted16;
+  sumSq16 = 0;
+  count = 0;
+}
+
+//
+// A-weighting is ( IEC 61672 )
+//
+//                        k * s^4
+// H(s) = ------------------------------------------
+//        ( s + w1 )^2 ( s + w2 ) ( s + w3 ) ( s + w4 )^2
+//
+// Split into three second order sections and map each to z with the
+// bilinear transform, then scale for 0 dB at 1 kHz.  There's no 
+// prewarping, so the bilinear transform squeezes the whole analog 
+// frequency axis into 0 to Nyquist, bending each frequency down by
+// f' = fs / pi * atan( pi * f / fs ).  Nothing folds; the 12.2 kHz poles
+// just land below Nyquist (about 4.2 kHz at 10 kHz), so the top octave
+// rolls off early.
+//
+void LevelMeter::designAWeighting( unsigned int sampleRateHz )
+{
+  using complex = std::complex< double >;
+  const double pi = 3.14159265358979323846;
+  const double w1 = 2.0 * pi * 20.598997;
+  const double w2 = 2.0 * pi * 107.65265;
+  const double w3 = 2.0 * pi * 737.86223;
+  const double w4 = 2.0 * pi * 12194.217;
+  const double k = 2.0 * sampleRateHz;
+
+  struct Section { double b0, b1, b2, a0, a1, a2; };
+
+  // s^2 / (( s + a )( s + b )) and 1 / (( s + a )( s + b )) after the 
+  // bilinear transform s = k ( 1 - z^-1 ) / ( 1 + z^-1 )
+  auto poles = [&]( double a, double b, Section& sec )
+  {
+    sec.a0 = ( k + a ) * ( k + b );
+    sec.a1 = -(( k + a ) * ( k - b ) + ( k - a ) * ( k + b ));
+    sec.a2 = ( k - a ) * ( k - b );
+  };
+  std::array< Section, 3 > sections;
+  poles( w1, w1, sections[0] );
+  sections[0].b0 = k * k; sections[0].b1 = -2.0 * k * k; sections[0].b2 = k * k;
+  poles( w2, w3, sections[1] );
+  sections[1].b0 = k * k; sections[1].b1 = -2.0 * k * k; sections[1].b2 = k * k;
+  poles( w4, w4, sections[2] );
+  sections[2].b0 = 1.0; sections[2].b1 = 2.0; sections[2].b2 = 1.0;
+
+  // Gain at 1 kHz
+  const complex z = std::polar( 1.0, 2.0 * pi * 1000.0 / sampleRateHz );
+  const complex zi = 1.0 / z;
+  complex h = 1.0;
+  for ( const auto& sec : sections )
+  {
+    h *= ( sec.b0 + sec.b1 * zi + sec.b2 * zi * zi ) /
+         ( sec.a0 + sec.a1 * zi + sec.a2 * zi * zi );
+  }
+  const double gain = 1.0 / std::abs( h );
+
+  for ( std::size_t i = 0; i < sections.size(); ++i )
+  {
+    const Section& sec = sections[i];
+    const double g = ( i == sections.size() - 1 ) ? gain : 1.0;
+    auto q14 = [&]( double v ) { return static_cast<int32_t>( std::lround( v / sec.a0 * 16384.0 )); };
+    aWeighting[i] = FixedBiquad{ 
+      q14( sec.b0 * g ), q14( sec.b1 * g ), q14( sec.b2 * g ), 
+      q14( sec.a1 ), q14( sec.a2 ), 0, 0, 0, 0 };
+  }
+}
+
@@ -0,0 +1,167 @@
+#ifndef __LEVEL_METER_H__
+#define __LEVEL_METER_H__
+
+#include <array>
+#include <cstdint>
+#include "fixed_math.h"
+
+///
+/// @brief Fixed point biquad filter section (Direct Form I)
+///
+/// Coefficients are Q14 with a0 normalized to 1.  The signal is whatever
+/// fixed point format the caller uses; products are 64 bit.
+///
+struct FixedBiquad
+{
+  int32_t b0, b1, b2, a1, a2;
+  int32_t x1, x2, y1, y2;
+
+  void reset()
+  {
+    x1 = x2 = y1 = y2 = 0;
+  }
+
+  int32_t process( int32_t x )
+  {
+    const int64_t acc = int64_t( b0 ) * x + int64_t( b1 ) * x1 +
+      int64_t( b2 ) * x2 - int64_t( a1 ) * y1 - int64_t( a2 ) * y2;
+    const int32_t y = static_cast<int32_t>( acc >> 14 );
+    x2 = x1;
+    x1 = x;
+    y2 = y1;
+    y1 = y;
+    return y;
+  }
+};
+
+///
+/// @brief Streaming RMS / sound level meter
+///
+/// Consumes one sample at a time and never stores the window.  Keeps:
+///
+/// - An exponentially time weighted mean square, like the Fast (125 ms)
+///   or Slow (1 s) setting on a sound level meter, and its maximum.
+/// - An equivalent level (Leq) - the plain mean square since the last
+///   reset.
+///
+/// The DC bias is removed with a one pole high pass (about 8 Hz at
+/// 10 kHz).  Optionally the signal is A-weighted by three biquads, designed
+/// for the sample rate at construction and then run in fixed point.
+/// Internally the signal is 24.8 fixed point and mean squares are 16.16;
+/// results are in LSB^2 of the input.  Levels are 10 * log10( mean square )
+/// plus a calibration offset, so with the right offset they are dB SPL.
+/// Levels below 0 dB (silence, or a negative offset) read as 0, so they
+/// always fit an unsigned histogram.
+///
+class LevelMeter
+{
+  public:
+
+  /// @brief Standard time constants, in ms
+  static constexpr unsigned int fastMs = 125;
+  static constexpr unsigned int slowMs = 1000;
+
+  ///
+  /// @brief Constructor
+  ///
+  /// @param[in] sampleRateHz - Rate samples arrive at
+  /// @param[in] timeConstantMs - Exponential time weighting constant
+  /// @param[in] aWeighted    - Apply the A-weighting filter
+  /// @param[in] calibrationDbArg - Added to every level in dB
+  ///
+  LevelMeter( unsigned int sampleRateHz,
+              unsigned int timeConstantMs = fastMs,
+              bool aWeighted = false,
+              int calibrationDbArg = 0 );
+
+  /// @brief Start a new measurement.  Filter state is kept.
+  void reset();
+
+  /// @brief Add one raw (biased) sample
+  void insert( unsigned short sample )
+  {
+    if ( !primed )
+    {
+      lastX8 = int32_t( sample ) << 8;
+      primed = true;
+    }
+
+    // DC blocker: y = x - x[-1] + R * y[-1]
+    const int32_t x8 = int32_t( sample ) << 8;
+    dcY8 = x8 - lastX8 + static_cast<int32_t>(( int64_t( dcY8 ) * dcPoleQ15 ) >> 15 );
+    lastX8 = x8;
+
+    int32_t y8 = dcY8;
+    if ( weighted )
+    {
+      for ( auto& section : aWeighting )
+      {
+        y8 = section.process( y8 );
+      }
+    }
+
+    const int64_t sq16 = int64_t( y8 ) * y8;
+    sumSq16 += static_cast<uint64_t>( sq16 );
+    ++count;
+
+    weighted16 += (( sq16 - weighted16 ) * alphaQ16 ) >> 16;
+    if ( weighted16 > max16 )
+    {
+      max16 = weighted16;
+    }
+  }
+
+  /// @brief Time weighted mean square, in LSB^2
+  uint32_t getMeanSquare() const { return static_cast<uint32_t>( weighted16 >> 16 ); }
+
+  /// @brief Largest time weighted mean square since the last reset
+  uint32_t getMaxMeanSquare() const { return static_cast<uint32_t>( max16 >> 16 ); }
+
+  /// @brief Mean square since the last reset, in LSB^2
+  uint32_t getLeqMeanSquare() const
+  {
+    return count ? static_cast<uint32_t>(( sumSq16 / count ) >> 16 ) : 0;
+  }
+
+  /// @brief Samples since the last reset
+  unsigned int getCount() const { return count; }
+
+  /// @brief Time weighted level, in dB
+  unsigned int getLevelDb() const { return toDb( weighted16 ); }
+
+  /// @brief Largest time weighted level since the last reset, in dB
+  unsigned int getMaxDb() const { return toDb( max16 ); }
+
+  /// @brief Equivalent level since the last reset, in dB
+  unsigned int getLeqDb() const { return toDb( count ? sumSq16 / count : 0 ); }
+
+  private:
+
+  unsigned int toDb( uint64_t meanSquare16 ) const
+  {
+    // meanSquare16 is Q16, and 10 * log10( 65536 ) = 48.2
+    const int db = meanSquare16 ? 
+      BeeFocus::db10( meanSquare16 ) - 48 + calibrationDb : calibrationDb;
+    return db < 0 ? 0 : db;
+  }
+
+  void designAWeighting( unsigned int sampleRateHz );
+
+  const bool weighted;
+  const int calibrationDb;
+  int64_t alphaQ16;
+  static constexpr int32_t dcPoleQ15 = 32604;   // 0.995
+
+  bool primed;
+  int32_t lastX8;
+  int32_t dcY8;
+  std::array< FixedBiquad, 3 > aWeighting;
+
+  int64_t weighted16;
+  int64_t max16;
+  uint64_t sumSq16;
+  unsigned int count;
+};
+
+#endif
+
@@ -0,0 +1,185 @@
+#ifndef __LINE_FRAMER_H__
+#define __LINE_FRAMER_H__
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+///
+/// @brief A line of input, still in the LineFramer's buffer
+///
+/// Valid until the framer is next written to.
+///
+struct LineView
+{
+  const char* data;
+  std::size_t size;
+};
+
+///
+/// @brief Splits a byte stream into lines in a fixed size buffer
+///
+/// Input is read straight into the buffer (writeSpace, then commit) and
+/// lines come back as views into it, so nothing is copied on the way
+/// through and nothing is allocated.  A trailing '\r' is dropped, so
+/// telnet's "\r\n" works.
+///
+/// Unread bytes are moved to the front when the end of the buffer is
+/// reached, so the next read and every line are contiguous.  If the
+/// buffer fills with complete lines no more is accepted until they're
+/// read, which leaves the rest in the socket.  A line that won't fit at
+/// all is dropped, up to its newline, and counted.
+///
+/// capacity  Buffer size, and one more than the longest line kept
+///
+template< std::size_t capacity >
+class LineFramer
+{
+  static_assert( capacity >= 2, "LineFramer needs room for a line and its newline" );
+
+  public:
+
+  LineFramer() : start{ 0 }, end{ 0 }, scanned{ 0 }, discarding{ false }, dropped{ 0 }
+  {
+  }
+
+  /// @brief Throw away everything buffered.  The drop count is kept.
+  void clear()
+  {
+    start = end = scanned = 0;
+    discarding = false;
+  }
+
+  ///
+  /// @brief Get space to read new bytes into
+  ///
+  /// @param[out] space - Bytes available at the returned pointer.  0 if
+  ///                     the buffer is full of unread lines.
+  /// @return Where to put the bytes.  Call commit() with the number put.
+  ///
+  char* writeSpace( std::size_t& space )
+  {
+    if ( end == capacity )
+    {
+      if ( start != 0 ) {
+        compact();
+      }
+      else if ( !memchr( buffer.data(), '\n', end ))
+      {
+        // One line fills the buffer.  Drop it, and the rest of it when
+        // it arrives.
+        if ( !discarding ) {
+          ++dropped;
+        }
+        start = end = scanned = 0;
+        discarding = true;
+      }
+    }
+    space = capacity - end;
+    return buffer.data() + end;
+  }
+
+  /// @brief Add count bytes put at writeSpace()
+  void commit( std::size_t count ) { end += count; }
+
+  ///
+  /// @brief Copy bytes in, for sources that can't read into writeSpace()
+  ///
+  /// @return The number of bytes taken.  Fewer than size if the buffer
+  ///         filled with unread lines.
+  ///
+  std::size_t write( const char* data, std::size_t size )
+  {
+    std::size_t taken = 0;
+    while ( taken < size )
+    {
+      std::size_t space;
+      char* to = writeSpace( space );
+      if ( space == 0 ) {
+        break;
+      }
+      const std::size_t n = space < size - taken ? space : size - taken;
+      memcpy( to, data + taken, n );
+      commit( n );
+      taken += n;
+    }
+    return taken;
+  }
+
+  ///
+  /// @brief Get the next complete line, without its newline
+  ///
+  /// @return false if there's no complete line yet
+  ///
+  bool nextLine( LineView& line )
+  {
+    while ( scanned < end )
+    {
+      const char* newLine = (const char*) memchr( buffer.data() + scanned, '\n', end - scanned );
+      if ( !newLine )
+      {
+        scanned = end;
+        return false;
+      }
+      const std::size_t at = newLine - buffer.data();
+      const std::size_t first = start;
+      start = scanned = at + 1;
+      if ( discarding )
+      {
+        // The end of a line that was too long
+        discarding = false;
+        continue;
+      }
+      std::size_t size = at - first;
+      if ( size && buffer[ at - 1 ] == '\r' ) {
+        --size;
+      }
+      line = LineView{ buffer.data() + first, size };
+      return true;
+    }
+    return false;
+  }
+
+  /// @brief Is there a complete line to read?
+  bool hasLine() const
+  {
+    const char* newLine = (const char*) memchr( buffer.data() + scanned, '\n', end - scanned );
+    if ( newLine && discarding )
+    {
+      // That one ends a dropped line
+      const char* after = newLine + 1;
+      newLine = (const char*) memchr( after, '\n', buffer.data() + end - after );
+    }
+    return newLine != nullptr;
+  }
+
+  /// @brief Number of lines dropped for being too long
+  unsigned int getDroppedLines() const { return dropped; }
+
+  static constexpr std::size_t getCapacity() { return capacity; }
+
+  private:
+
+  /// @brief Move the unread bytes to the front of the buffer
+  void compact()
+  {
+    memmove( buffer.data(), buffer.data() + start, end - start );
+    end -= start;
+    scanned -= start;
+    start = 0;
+  }
+
+  std::array< char, capacity > buffer;
+  /// @brief First unread byte
+  std::size_t start;
+  /// @brief One past the last byte written
+  std::size_t end;
+  /// @brief Bytes before this, from start, have no newline
+  std::size_t scanned;
+  /// @brief True while dropping the rest of a line that was too long
+  bool discarding;
+  unsigned int dropped;
+};
+
+#endif
+
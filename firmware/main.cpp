@@ -3,10 +3,18 @@
 #include "sample_sound.h"
 #include "net_esp8266.h"
 #include "hardware_esp8266.h"
+#include "sample_timer_esp8266.h"
+#include "sound_sampler.h"
+#include "state_saver.h"
+#include "storage_esp8266.h"
 #include "debug_esp8266.h"
 #include "action_manager.h"
-#include "time_esp8266.h"
+#include "clock_esp8266.h"
+#include "idle_policy.h"
+#include "power_esp8266.h"
+#include "ntp_client.h"
 #include "time_manager.h"
+#include "udp_esp8266.h"
 #include "temperature_dh11.h"
 #include "data_mover.h"
 #include "wifi_secrets.h"
@@ -14,30 +22,49 @@
 std::shared_ptr<ActionManager> action_manager;
 
 void loop() {
-  unsigned int pause = action_manager->loop();
-  if ( pause != 0 )
-  {
-    int ms = pause / 1000;
-    int usRemainder = pause % 1000;
-    delay( ms );
-    delayMicroseconds( usRemainder );
-  }
+  action_manager->waitUs( action_manager->loop() );
 }
 
 void setup() {
   auto debug     = std::make_shared<DebugESP8266>();
-  auto wifi      = std::make_shared<WifiInterfaceEthernet>(debug);
+  auto clock     = std::make_shared<ClockESP8266>();
+  auto wifi      = std::make_shared<WifiInterfaceEthernet>(debug, clock);
   auto hardware  = std::make_shared<HardwareESP8266>();
-  auto timeNNTP  = std::make_shared<TimeESP8266>( debug );
-  auto time      = std::make_shared<TimeManager>( timeNNTP );
+  auto ntp       = std::make_shared<NtpClient>(
+                      std::make_shared<UdpESP8266>( 2390 ), clock, debug,
+                      "time.nist.gov" );
+  auto time      = std::make_shared<TimeManager>( ntp );
   auto temp      = std::make_shared<TempDH11>( 0 );
-  //auto sound     = std::make_shared<FS::SSound>( wifi, hardware, debug, time );
-  auto datamover = std::make_shared<DataMover>( WifiSecrets::hostname, temp, wifi );
+  auto timer     = std::make_shared<SampleTimerESP8266>();
+  auto sampler   = std::make_shared<SoundSampler>( timer );
+  auto sound     = std::make_shared<FS::SSound>( wifi, hardware, debug, time,
+                      FS::SampleMode::TIMER, sampler );
+  auto datamover = std::make_shared<DataMover>( WifiSecrets::hostname, temp, wifi, time );
+  auto storage   = std::make_shared<StorageESP8266>( "/snapshot.bin" );
+  auto saver     = std::make_shared<StateSaver>( storage, debug,
+                      std::vector<std::shared_ptr<PersistentInterface>>{ time, sound } );
 
-  action_manager = std::make_shared<ActionManager>( wifi, hardware, debug );
-  //action_manager->addAction( sound );
-  action_manager->addAction( time );
-  action_manager->addAction( datamover );
-  action_manager->addAction( wifi );
+  // Pick up where we left off before the last reboot.
+  saver->restore();
+
+  action_manager = std::make_shared<ActionManager>( wifi, hardware, debug,
+                      clock );
+  const auto soundId = action_manager->addAction( sound );
+  action_manager->addAction( ntp );
+  action_manager->addAction( time, ActionManager::Schedule::FIXED_RATE );
+  action_manager->addAction( datamover, ActionManager::Schedule::FIXED_RATE );
+  const auto wifiId = action_manager->addAction( wifi );
+  action_manager->addAction( saver );
+  // The last few seconds of scheduling, for the trace command
+  action_manager->setTraceLog( std::make_shared<TraceLog>( 256 ));
+  // Commands and new clients get answered right away, not on the next poll
+  action_manager->setWakeSource( wifi );
+  action_manager->wakeOnInput( soundId );
+  action_manager->wakeOnInput( wifiId );
+  // Sleep through gaps like SSound's pauses, but answer within 5 ms
+  action_manager->setIdlePolicy(
+    std::make_shared<BreakEvenPolicy>( BreakEvenPolicy::esp8266, 5000 ),
+    std::make_shared<PowerESP8266>() );
+  sound->setStatsReporter( action_manager );
 }
 
@@ -0,0 +1,66 @@
+#ifndef __MONOTONIC_CLOCK_H__
+#define __MONOTONIC_CLOCK_H__
+
+#include <cstdint>
+#include <memory>
+#include "clock_interface.h"
+
+///
+/// @brief Widens a free running 32 bit counter to 64 bits
+///
+/// Counts the counter's wraps, so it has to see the counter at least
+/// once per wrap.
+///
+class WrapCounter
+{
+  public:
+
+  WrapCounter() : last{ 0 }, high{ 0 }
+  {
+  }
+
+  /// @brief The 64 bit count, given the counter's current value
+  uint64_t extend( uint32_t raw )
+  {
+    if ( raw < last ) {
+      high += uint64_t( 1 ) << 32;
+    }
+    last = raw;
+    return high | raw;
+  }
+
+  private:
+
+  uint32_t last;
+  uint64_t high;
+};
+
+///
+/// @brief 64 bit microsecond time that never wraps
+///
+/// Extends a ClockInterface's 32 bit counter by counting its wraps.  A
+/// wrap is only seen if nowUs() is called at least once per wrap (about
+/// every 71 minutes) - ActionManager never sleeps that long.
+///
+class MonotonicClock
+{
+  public:
+
+  explicit MonotonicClock( std::shared_ptr<ClockInterface> sourceArg ) :
+    source{ sourceArg }
+  {
+  }
+
+  /// @brief Microseconds since the device started
+  uint64_t nowUs()
+  {
+    return wraps.extend( source->microsSinceDeviceStart() );
+  }
+
+  private:
+
+  std::shared_ptr<ClockInterface> source;
+  WrapCounter wraps;
+};
+
+#endif
@@ -4,12 +4,17 @@
 #include "wifi_debug_ostream.h"
 
 WifiInterfaceEthernet::WifiInterfaceEthernet(
-  std::shared_ptr<DebugInterface> logArg
+  std::shared_ptr<DebugInterface> logArg,
+  std::shared_ptr<ClockInterface> clock
 ) 
   : log{ logArg },
     m_lastSlotAllocated{0}, 
     m_kickout{0}, 
-    m_nextToKick{m_connections.begin()}
+    m_nextToKick{m_connections.begin()},
+    // Send about a packet at a time, and nothing later than 20 ms.  A
+    // client that's 1.5K behind gets 5 ms to catch up before it skips.
+    m_output{ clock, *this, StreamWriterConfig{ 1024, 20000,
+      StreamWriterConfig::WhenFull::BLOCK, 5000 }}
 {
   delay(10);
   (*log) << "Init Wifi\n";
@@ -42,7 +47,6 @@ WifiInterfaceEthernet::WifiInterfaceEthernet(
     adr[i] = dsIP[i];
   (*log) << "Telnet to this address to connect: " << adr << " " << tcp_port << "\n";
 
-  //wifi_set_sleep_type(LIGHT_SLEEP_T);
   reset();
 }
 
@@ -59,9 +63,42 @@ unsigned int WifiInterfaceEthernet::loop()
 {
   handleNewConnections();
   flush();
-  return 500000;
+  // Come back in time to send anything flush() put off
+  return std::min( 500000u, m_output.getUsUntilDue() );
 } 
 
+bool WifiInterfaceEthernet::hasInput()
+{
+  return m_server.hasClient() || 
+    std::any_of( m_connections.begin(), m_connections.end(), [] ( WifiConnectionEthernet& connection )
+    {
+      return connection.hasInput();
+    });
+}
+
+bool WifiInterfaceEthernet::waitUs( unsigned int timeoutUs, bool wakeOnInput )
+{
+  if ( !wakeOnInput )
+  {
+    delay( timeoutUs / 1000 );
+    delayMicroseconds( timeoutUs % 1000 );
+    return false;
+  }
+  const unsigned long start = micros();
+  while ( micros() - start + 1000 <= timeoutUs )
+  {
+    if ( hasInput() ) {
+      return true;
+    }
+    delay( 1 );
+  }
+  const unsigned long slept = micros() - start;
+  if ( slept < timeoutUs ) {
+    delayMicroseconds( timeoutUs - slept );
+  }
+  return hasInput();
+}
+
 void WifiInterfaceEthernet::handleNewConnections()
 {
   if ( m_server.hasClient() )
@@ -89,32 +126,29 @@ void WifiInterfaceEthernet::handleNewConnections()
     }
 
     slot->initConnection( m_server );
+    // The new client starts with what's written from now on
+    m_output.attach( slot - m_connections.begin(), &*slot );
   }
 }
 
 std::streamsize WifiInterfaceEthernet::write(const char_type* s, std::streamsize n)
 {
-  std::for_each( m_connections.begin(), m_connections.end(), [&] ( NetConnection& interface )
-  {
-    interface.write( s, n );
-  }); 
+  m_output.write( s, n );
   return n;
 }
 
 void WifiInterfaceEthernet::flush()
 {
-  std::for_each( m_connections.begin(), m_connections.end(), [&] ( NetConnection& interface )
-  {
-    interface.flush();
-  }); 
+  m_output.flush();
 }
 
 void WifiInterfaceEthernet::reset(void)
 {
-  std::for_each( m_connections.begin(), m_connections.end(), [] ( NetConnection& interface )
+  for ( std::size_t slot = 0; slot < m_connections.size(); ++slot )
   {
-    interface.reset(); 
-  });
+    m_output.detach( slot );
+    m_connections[ slot ].reset();
+  }
 }
 
 std::unique_ptr<NetConnection> 
@@ -145,71 +179,67 @@ bool WifiConnectionEthernet::getString( std::string& string )
 {
   handleNewIncomingData();
 
-  std::string& incomingBuffer = m_incomingBuffers[ m_currentIncomingBuffer ];
-  size_t newLine = incomingBuffer.find('\n');
-  if ( newLine != std::string::npos )
-  {
-    string.replace( 0, newLine, incomingBuffer );
-    string.resize( newLine );
-    m_currentIncomingBuffer = 1-m_currentIncomingBuffer;
-    std::string& newIncomingBuffer = m_incomingBuffers[ m_currentIncomingBuffer ];
-    size_t rest = incomingBuffer.length() - newLine - 1;
-    newIncomingBuffer.replace( 0, rest, incomingBuffer, newLine+1, rest );
-    newIncomingBuffer.resize( rest );
-    
-    return true;
+  LineView line;
+  if ( !m_incoming.nextLine( line ) ) {
+    return false;
   }
-  
-  return false;
+  string.assign( line.data, line.size );
+  return true;
 }
 
 
+bool WifiConnectionEthernet::hasInput()
+{
+  return ( m_connectedClient && m_connectedClient.available() ) ||
+    m_incoming.hasLine();
+}
+
 void WifiConnectionEthernet::handleNewIncomingData()
 {
-  std::string& incomingBuffer = m_incomingBuffers[ m_currentIncomingBuffer ];
-  
-  if ( !m_connectedClient || !m_connectedClient.available())
-  {
+  if ( !m_connectedClient ) {
     return;
   }
 
-  while (m_connectedClient.available())
+  // Read in bulk, straight into the framer.  If it's full of unread
+  // lines the rest stays in the socket until they're read.
+  int available;
+  while (( available = m_connectedClient.available() ) > 0 )
   {
-    uint8_t byte;
-    m_connectedClient.read( &byte, 1 );
-    incomingBuffer += ((char) byte);
+    std::size_t space;
+    char* to = m_incoming.writeSpace( space );
+    if ( space == 0 ) {
+      return;
+    }
+    const int got = m_connectedClient.read( (uint8_t*) to,
+      std::min( space, (std::size_t) available ));
+    if ( got <= 0 ) {
+      return;
+    }
+    m_incoming.commit( got );
   }
 }
 
 std::streamsize WifiConnectionEthernet::write( const char_type* s, std::streamsize n )
 {
-  if ( !m_connectedClient ) { return n; }
-  if ( n + bytesInOutBuffer > outgoingBuffer.max_size() )
+  if ( m_connectedClient )
   {
-    flush();
+    m_connectedClient.write( (const uint8_t*) s, n );
   }
-  memcpy( outgoingBuffer.data() + bytesInOutBuffer, s, n );
-  bytesInOutBuffer +=n;
   return n;
 } 
 
 void WifiConnectionEthernet::flush()
 {
-  if ( !m_connectedClient ) { return; }
+  // Writes go straight to the socket, and Nagle is off, so there's
+  // nothing to push.  Shared output is batched by StreamWriter.
+}
 
-  if ( bytesInOutBuffer )
-  { 
-    //wifi_set_sleep_type(NONE_SLEEP_T);
-    m_connectedClient.write( outgoingBuffer.data(), bytesInOutBuffer );
-    allOutputFlushed = false;
-    bytesInOutBuffer = 0;
-  }
-  else if ( !allOutputFlushed )
-  {
-    allOutputFlushed = m_connectedClient.flush(1);
-  }
-  else {
-    //wifi_set_sleep_type(LIGHT_SLEEP_T);
-  }
-} 
+std::size_t WifiConnectionEthernet::writeSpace()
+{
+  return m_connectedClient ? m_connectedClient.availableForWrite() : 0;
+}
 
+std::size_t WifiConnectionEthernet::send( const char* data, std::size_t n )
+{
+  return m_connectedClient.write( (const uint8_t*) data, n );
+}
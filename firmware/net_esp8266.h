@@ -8,12 +8,22 @@
 #include "wifi_ostream.h"
 #include "wifi_secrets.h"
 #include "debug_interface.h"
+#include "wake_interface.h"
+#include "line_framer.h"
+#include "stream_writer.h"
+#include "clock_interface.h"
 
 class WifiOstream;
 
 class WifiDebugOstream;
 
-class WifiConnectionEthernet: public NetConnection {
+/// @brief Most clients connected at once
+constexpr std::size_t wifiMaxClients = 4;
+
+/// @brief Output for all clients; 1.5K shared instead of 1.5K each
+using WifiOutputWriter = StreamWriter< 128, 12, wifiMaxClients >;
+
+class WifiConnectionEthernet: public NetConnection, public StreamSink {
 
   public:
 
@@ -32,9 +42,7 @@ class WifiConnectionEthernet: public NetConnection {
 
   void reset( void ) 
   { 
-    m_currentIncomingBuffer=0;
-    m_incomingBuffers[0].resize(0);
-    m_incomingBuffers[1].resize(0);
+    m_incoming.clear();
     if (m_connectedClient)
     {
       m_connectedClient.stop();
@@ -43,33 +51,40 @@ class WifiConnectionEthernet: public NetConnection {
 
   void initConnection( WiFiServer &server );
   bool getString( std::string& string ) override;
+  /// @brief Is there unread data, or a buffered line?
+  bool hasInput();
+  /// @brief Number of input lines dropped for being too long
+  unsigned int getDroppedLines() const { return m_incoming.getDroppedLines(); }
   operator bool( void ) override {
     return m_connectedClient;
   }
 
+  /// @brief Write to this client only, i.e., the welcome message
   std::streamsize write( const char_type* s, std::streamsize n ) override; 
   void flush() override;
 
+  bool isOpen() override { return m_connectedClient; }
+  std::size_t writeSpace() override;
+  std::size_t send( const char* data, std::size_t n ) override;
+
   private:
 
   void handleNewIncomingData();    
 
-  int m_currentIncomingBuffer;
-  std::string m_incomingBuffers[2];
+  /// @brief Commands are short, so lines longer than this are dropped
+  LineFramer< 256 > m_incoming;
   WiFiClient m_connectedClient;
-  std::array< char, 1500> outgoingBuffer;
-  size_t bytesInOutBuffer = 0;
-  bool allOutputFlushed = true;
 };
 
 /// @brief Interface to the client
 ///
 /// This class's one job is to provide an interface to the client.
 ///
-class WifiInterfaceEthernet: public NetInterface {
+class WifiInterfaceEthernet: public NetInterface, public WakeInterface {
   public:
 
-  WifiInterfaceEthernet( std::shared_ptr<DebugInterface> debugLog );
+  WifiInterfaceEthernet( std::shared_ptr<DebugInterface> debugLog,
+    std::shared_ptr<ClockInterface> clock );
 
   ~WifiInterfaceEthernet()
   {
@@ -88,11 +103,26 @@ class WifiInterfaceEthernet: public NetInterface {
     return "WifiInterfaceEthernet";
   }
   std::unique_ptr<NetConnection> connect( const std::string& location, unsigned int port );
+
+  /// @brief Output batching and back-pressure counters
+  const StreamWriterStats& getOutputStats() const { return m_output.getStats(); }
+
+  /// @brief Is there a new client or data from a client?
+  bool hasInput() override;
+
+  ///
+  /// @brief Sleep until a client connects or sends data
+  ///
+  /// The Arduino WiFiClient has no data callback, so this checks the
+  /// server and clients every millisecond.  delay() runs the Wifi stack
+  /// and lets the CPU sleep in between.
+  ///
+  bool waitUs( unsigned int timeoutUs, bool wakeOnInput ) override;
   
   private:
 
   void handleNewConnections();
-  typedef std::array< WifiConnectionEthernet, 4 > ConnectionArray;
+  typedef std::array< WifiConnectionEthernet, wifiMaxClients > ConnectionArray;
 
   // Make a CI Test to lock these defaults in?
   static constexpr const char* ssid = WifiSecrets::ssid; 
@@ -105,6 +135,7 @@ class WifiInterfaceEthernet: public NetInterface {
   int m_kickout;
   ConnectionArray m_connections;
   ConnectionArray::iterator m_nextToKick;
+  WifiOutputWriter m_output;
 
   WiFiServer m_server{tcp_port};
 };
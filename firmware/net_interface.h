@@ -52,6 +52,35 @@ class NetInterface: public ActionInterface {
   virtual void flush() = 0;
   virtual std::unique_ptr<NetConnection> connect( const std::string& location, unsigned int port ) = 0;
 
+  ///
+  /// @brief Awaitable for a line of input (see BEEFOCUS_CO_AWAIT)
+  ///
+  class Readable
+  {
+    public:
+
+    Readable( NetInterface& netArg, std::string& lineArg, unsigned int pollArg ) :
+      net( netArg ), line( lineArg ), poll{ pollArg } {}
+
+    /// @brief Read the line if there is one
+    bool ready() { return net.getString( line ); }
+    unsigned int pollUs() const { return poll; }
+
+    private:
+
+    NetInterface& net;
+    std::string& line;
+    const unsigned int poll;
+  };
+
+  ///
+  /// @brief Await a line of input into line, checking every pollUs
+  ///
+  Readable readable( std::string& line, unsigned int pollUs )
+  {
+    return Readable( *this, line, pollUs );
+  }
+
   private:
 };
 
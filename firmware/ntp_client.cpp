@@ -0,0 +1,216 @@
+#include <algorithm>
+#include "ntp_client.h"
+
+constexpr uint16_t NtpClient::ntpPort;
+constexpr unsigned int NtpClient::pollUs;
+constexpr unsigned int NtpClient::replyTimeoutMs;
+constexpr unsigned int NtpClient::minRetryMs;
+constexpr unsigned int NtpClient::maxRetryMs;
+constexpr unsigned int NtpClient::resyncMs;
+constexpr unsigned int NtpClient::dnsCacheMs;
+constexpr unsigned int NtpClient::failuresBeforeLookup;
+constexpr std::size_t NtpClient::packetSize;
+constexpr uint32_t NtpClient::secondsFrom1900To1970;
+
+namespace {
+
+// Offsets into an NTP packet, see RFC 5905
+constexpr std::size_t originTimestamp = 24;
+constexpr std::size_t transmitTimestamp = 40;
+// LI 0, version 4, mode 3 (client) / mode 4 (server)
+constexpr uint8_t clientMode = 0x23;
+constexpr uint8_t serverMode = 4;
+
+uint64_t readBigEndian( const uint8_t* bytes, unsigned int size )
+{
+  uint64_t value = 0;
+  for ( unsigned int i = 0; i < size; ++i ) {
+    value = ( value << 8 ) | bytes[i];
+  }
+  return value;
+}
+
+void writeBigEndian( uint8_t* bytes, uint64_t value )
+{
+  for ( int i = 7; i >= 0; --i )
+  {
+    bytes[i] = (uint8_t) value;
+    value >>= 8;
+  }
+}
+
+}
+
+NtpClient::NtpClient(
+    std::shared_ptr<UdpInterface> udpArg,
+    std::shared_ptr<ClockInterface> clockArg,
+    std::shared_ptr<DebugInterface> debugArg,
+    const char* serverArg,
+    uint16_t portArg ) :
+  udp{ udpArg }, clock{ clockArg }, debug{ debugArg },
+  server{ serverArg }, port{ portArg },
+  state{ State::RESOLVE }, address{{ 0, 0, 0, 0 }}, addressKnown{ false },
+  resolvedAtMs{ 0 }, lookups{ 0 }, requestId{ 0 }, sequence{ 0 }, sentAtMs{ 0 },
+  nextQueryAtMs{ 0 }, failures{ 0 }, syncIntervalMs{ resyncMs },
+  synced{ false }, sampleTaken{ false }, syncedTimeMs{ 0 },
+  syncedAtMs{ 0 }, roundTripMs{ 0 }
+{
+}
+
+unsigned int NtpClient::secondsSince1970()
+{
+  return (unsigned int) ( msSince1970() / 1000 );
+}
+
+uint64_t NtpClient::msSince1970()
+{
+  if ( !synced ) {
+    return 0;
+  }
+  return syncedTimeMs + nowMs() - syncedAtMs;
+}
+
+bool NtpClient::getSample( TimeSample& sample )
+{
+  if ( !synced || sampleTaken ) {
+    return false;
+  }
+  sampleTaken = true;
+  // Plus a ms for the server's fraction being rounded down
+  sample = TimeSample{ (unsigned int) syncedAtMs, syncedTimeMs, roundTripMs / 2 + 1 };
+  return true;
+}
+
+void NtpClient::setSyncIntervalMs( unsigned int intervalMs )
+{
+  syncIntervalMs = intervalMs;
+  if ( state == State::SYNCED ) {
+    nextQueryAtMs = syncedAtMs + syncIntervalMs;
+  }
+}
+
+unsigned int NtpClient::msSinceDeviceStart()
+{
+  return (unsigned int) nowMs();
+}
+
+unsigned int NtpClient::loop()
+{
+  switch ( state )
+  {
+    case State::RESOLVE:    return resolve();
+    case State::SEND:       return send();
+    case State::WAIT_REPLY: return checkForReply();
+    case State::SYNCED:     return waitToResync();
+  }
+  return pollUs;
+}
+
+unsigned int NtpClient::resolve()
+{
+  const uint64_t now = nowMs();
+  if ( now < nextQueryAtMs ) {
+    return (unsigned int) std::min< uint64_t >(( nextQueryAtMs - now ) * 1000, maxRetryMs * 1000ULL );
+  }
+  if ( addressKnown && now - resolvedAtMs < dnsCacheMs )
+  {
+    state = State::SEND;
+    return 0;
+  }
+  ++lookups;
+  addressKnown = udp->resolve( server, address );
+  if ( !addressKnown ) {
+    return fail( "lookup failed" );
+  }
+  resolvedAtMs = now;
+  state = State::SEND;
+  return 0;
+}
+
+unsigned int NtpClient::send()
+{
+  // Anything left over is a late reply to an earlier request
+  packet_t packet;
+  while ( udp->receive( packet.data(), packet.size() ) != 0 );
+
+  packet.fill( 0 );
+  packet[0] = clientMode;
+  // The server echoes our transmit timestamp back as the origin, which
+  // ties the reply to this request.  It only has to be unique, so use the
+  // device clock and a count.
+  sentAtMs = nowMs();
+  requestId = ( clock.nowUs() << 16 ) | ++sequence;
+  writeBigEndian( &packet[ transmitTimestamp ], requestId );
+  if ( !udp->send( address, port, packet.data(), packet.size() )) {
+    return fail( "send failed" );
+  }
+  state = State::WAIT_REPLY;
+  return pollUs;
+}
+
+unsigned int NtpClient::checkForReply()
+{
+  packet_t packet;
+  std::size_t size;
+  while (( size = udp->receive( packet.data(), packet.size() )) != 0 )
+  {
+    if ( useReply( packet, size ))
+    {
+      failures = 0;
+      nextQueryAtMs = syncedAtMs + syncIntervalMs;
+      state = State::SYNCED;
+      return waitToResync();
+    }
+  }
+  if ( nowMs() - sentAtMs >= replyTimeoutMs ) {
+    return fail( "no reply" );
+  }
+  return pollUs;
+}
+
+unsigned int NtpClient::waitToResync()
+{
+  const uint64_t now = nowMs();
+  if ( now < nextQueryAtMs ) {
+    return (unsigned int) std::min< uint64_t >(( nextQueryAtMs - now ) * 1000, resyncMs * 1000ULL );
+  }
+  state = State::RESOLVE;
+  return resolve();
+}
+
+unsigned int NtpClient::fail( const char* why )
+{
+  ++failures;
+  (*debug) << "NTP " << server << ": " << why << "\n";
+  if ( failures % failuresBeforeLookup == 0 ) {
+    addressKnown = false;
+  }
+  const unsigned int shift = std::min( failures - 1, 16u );
+  const unsigned int backOff = std::min( minRetryMs << shift, maxRetryMs );
+  nextQueryAtMs = nowMs() + backOff;
+  state = State::RESOLVE;
+  return backOff * 1000;
+}
+
+bool NtpClient::useReply( const packet_t& reply, std::size_t size )
+{
+  if ( size < packetSize ||
+       ( reply[0] & 0x7 ) != serverMode ||
+       reply[1] == 0 ||   // stratum 0 is a "kiss of death", not a time
+       readBigEndian( &reply[ originTimestamp ], 8 ) != requestId )
+  {
+    (*debug) << "NTP " << server << ": ignoring packet\n";
+    return false;
+  }
+  const uint64_t now = nowMs();
+  const uint64_t seconds = (uint32_t) ( readBigEndian( &reply[ transmitTimestamp ], 4 ) - secondsFrom1900To1970 );
+  const uint64_t fraction = readBigEndian( &reply[ transmitTimestamp + 4 ], 4 );
+  roundTripMs = (unsigned int) ( now - sentAtMs );
+  // The reply was sent about half way through the round trip
+  syncedTimeMs = seconds * 1000 + (( fraction * 1000 ) >> 32 ) + roundTripMs / 2;
+  syncedAtMs = now;
+  synced = true;
+  sampleTaken = false;
+  return true;
+}
+
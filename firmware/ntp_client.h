@@ -0,0 +1,145 @@
+#ifndef __NTP_CLIENT_H__
+#define __NTP_CLIENT_H__
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include "action_interface.h"
+#include "basic_types.h"
+#include "clock_interface.h"
+#include "debug_interface.h"
+#include "monotonic_clock.h"
+#include "time_interface.h"
+#include "udp_interface.h"
+
+///
+/// @brief Gets the time from an NTP server without ever blocking
+///
+/// A state machine run by loop(): look the server up (the answer is
+/// cached for a day), send a request, then check for the reply on later
+/// loop() calls.  A request that isn't answered within a second is
+/// retried with a growing back off, and the cached address is dropped
+/// after a few failures in case the server moved.  Once synced it asks
+/// again every hour, or as often as setSyncIntervalMs asks.
+///
+/// secondsSince1970() only reads the last answer, moved on by the device
+/// clock, so it's cheap to call from anywhere (i.e., SSound).  It's 0
+/// until the first reply.
+///
+class NtpClient: public TimeInterface, public ActionInterface
+{
+  public:
+
+  enum class State {
+    RESOLVE,        ///< Look up the server
+    SEND,           ///< Send a request
+    WAIT_REPLY,     ///< Check for the reply
+    SYNCED          ///< Wait until it's time to ask again
+  };
+
+  static constexpr uint16_t ntpPort = 123;
+  /// @brief How often loop() checks for a reply
+  static constexpr unsigned int pollUs = 10 * 1000;
+  /// @brief How long to wait for a reply
+  static constexpr unsigned int replyTimeoutMs = 1000;
+  /// @brief Back off after the first failure; doubles each failure after
+  static constexpr unsigned int minRetryMs = 2000;
+  static constexpr unsigned int maxRetryMs = 5 * 60 * 1000;
+  /// @brief Time between queries once synced, until told otherwise
+  static constexpr unsigned int resyncMs = 60 * 60 * 1000;
+  /// @brief How long a looked up address is used
+  static constexpr unsigned int dnsCacheMs = 24 * 60 * 60 * 1000;
+  /// @brief Failures in a row before the address is looked up again
+  static constexpr unsigned int failuresBeforeLookup = 3;
+
+  ///
+  /// @brief Constructor
+  ///
+  /// @param[in] udpArg    - Socket to talk to the server with
+  /// @param[in] clockArg  - The device's microsecond clock
+  /// @param[in] debugArg  - Interface to the debug logger
+  /// @param[in] serverArg - The server's name.  Must outlive the client.
+  /// @param[in] portArg   - The server's port
+  ///
+  NtpClient(
+    std::shared_ptr<UdpInterface> udpArg,
+    std::shared_ptr<ClockInterface> clockArg,
+    std::shared_ptr<DebugInterface> debugArg,
+    const char* serverArg,
+    uint16_t portArg = ntpPort );
+
+  /// @brief The time from the last reply, or 0 if there's been none
+  virtual unsigned int secondsSince1970() override final;
+  virtual unsigned int msSinceDeviceStart() override final;
+  virtual uint64_t msSince1970() override final;
+  /// @brief The last reply, once.  Good to half the round trip.
+  virtual bool getSample( TimeSample& sample ) override final;
+  /// @brief Ask again this long after the last reply
+  virtual void setSyncIntervalMs( unsigned int intervalMs ) override final;
+
+  virtual unsigned int loop() override final;
+  virtual const char* debugName() override final { return "NtpClient"; }
+
+  State getState() const { return state; }
+  /// @brief Failed requests since the last reply
+  unsigned int getFailures() const { return failures; }
+  /// @brief Number of times the server's name was looked up
+  unsigned int getLookups() const { return lookups; }
+  /// @brief Round trip time of the last reply
+  unsigned int getRoundTripMs() const { return roundTripMs; }
+
+  /// @brief NTP's packet size, without extensions
+  static constexpr std::size_t packetSize = 48;
+  using packet_t = std::array< uint8_t, packetSize >;
+
+  private:
+
+  /// @brief Seconds from 1900, NTP's epoch, to 1970
+  static constexpr uint32_t secondsFrom1900To1970 = 2208988800U;
+
+  uint64_t nowMs() { return clock.nowUs() / 1000; }
+
+  unsigned int resolve();
+  unsigned int send();
+  unsigned int checkForReply();
+  unsigned int waitToResync();
+
+  /// @brief Give up on this request and back off before the next
+  unsigned int fail( const char* why );
+
+  /// @brief Use a reply if it answers our request.  @return false if not.
+  bool useReply( const packet_t& reply, std::size_t size );
+
+  std::shared_ptr<UdpInterface> udp;
+  MonotonicClock clock;
+  std::shared_ptr<DebugInterface> debug;
+  const char* server;
+  const uint16_t port;
+
+  State state;
+  BeeFocus::IpAddress address;
+  bool addressKnown;
+  uint64_t resolvedAtMs;
+  unsigned int lookups;
+
+  /// @brief The request's transmit timestamp, which the reply must echo
+  uint64_t requestId;
+  uint16_t sequence;
+  uint64_t sentAtMs;
+  /// @brief When to move on from SYNCED or a failure's back off
+  uint64_t nextQueryAtMs;
+  unsigned int failures;
+
+  unsigned int syncIntervalMs;
+
+  bool synced;
+  /// @brief True once getSample has handed over the last reply
+  bool sampleTaken;
+  /// @brief Time of the last reply, in ms since 1970, and when it came
+  uint64_t syncedTimeMs;
+  uint64_t syncedAtMs;
+  unsigned int roundTripMs;
+};
+
+#endif
+
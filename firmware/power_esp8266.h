@@ -0,0 +1,48 @@
+#ifndef __POWER_ESP8266_H__
+#define __POWER_ESP8266_H__
+
+#include <Arduino.h>
+extern "C" {
+#include "user_interface.h"
+}
+#include "power_interface.h"
+
+///
+/// @brief ESP8266 sleep depths
+///
+/// The SDK sleeps at the chosen depth on its own while delay() runs, and
+/// the Wifi stack and timers still wake it.  AWAKE is the SDK's default,
+/// modem sleep, rather than NONE_SLEEP_T, which would keep the radio on
+/// and cost more than not managing power at all.  So AWAKE and MODEM are
+/// the same here, and only LIGHT changes anything.
+///
+/// Nothing on the device measures the current drawn.  The figures the 
+/// IdlePolicy works from (i.e., BreakEvenPolicy::esp8266) are the 
+/// datasheet's and only rank the depths; the real draw depends on the
+/// board and the access point's beacon interval.
+///
+class PowerESP8266: public PowerInterface {
+  public:
+
+  PowerESP8266() : current{ wifi_get_sleep_type() }
+  {
+  }
+
+  void setSleepDepth( SleepDepth depth ) override
+  {
+    const sleep_type_t type = depth == SleepDepth::LIGHT ? LIGHT_SLEEP_T : MODEM_SLEEP_T;
+    // Switching modes isn't free, and ActionManager sets a depth around
+    // every wait
+    if ( type != current )
+    {
+      wifi_set_sleep_type( type );
+      current = type;
+    }
+  }
+
+  private:
+
+  sleep_type_t current;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef __POWER_INTERFACE_H__
+#define __POWER_INTERFACE_H__
+
+#include <array>
+#include <cstddef>
+#include "basic_types.h"
+
+class NetInterface;
+
+/// @brief How deeply the device sleeps while it waits for the next action
+enum class SleepDepth {
+  START_OF_DEPTHS = 0,
+  AWAKE = 0,            ///< CPU and radio on
+  MODEM,                ///< Radio off between access point beacons
+  LIGHT,                ///< CPU clock gated too.  Timers and Wifi wake it.
+  END_OF_DEPTHS
+};
+
+/// @brief Debug names, indexed by SleepDepth
+constexpr BeeFocus::EnumTable< SleepDepth, const char*,
+  (std::size_t) SleepDepth::END_OF_DEPTHS > sleepDepthNames =
+{{
+  { SleepDepth::AWAKE,  "awake" },
+  { SleepDepth::MODEM,  "modem" },
+  { SleepDepth::LIGHT,  "light" },
+}};
+static_assert( sleepDepthNames.isDense(), "Every SleepDepth needs a name, in order" );
+
+/// @brief Increment operator for SleepDepth
+inline SleepDepth& operator++( SleepDepth& d )
+{
+  return BeeFocus::advance< SleepDepth, SleepDepth::END_OF_DEPTHS >( d );
+}
+
+/// @brief What a sleep depth costs
+struct SleepState {
+  unsigned int powerUw;         ///< Power drawn while in the state
+  unsigned int exitLatencyUs;   ///< Time to get back to AWAKE
+  unsigned int transitionUj;    ///< Energy spent going in and out
+};
+
+/// @brief A SleepState for each SleepDepth, in SleepDepth order
+using SleepStates = std::array< SleepState, (std::size_t) SleepDepth::END_OF_DEPTHS >;
+
+///
+/// @brief Puts the device into a sleep depth
+///
+/// ActionManager sets the depth before it waits and sets AWAKE after.
+///
+class PowerInterface
+{
+  public:
+
+  virtual ~PowerInterface() {}
+
+  virtual void setSleepDepth( SleepDepth depth ) = 0;
+
+  /// @brief Print what's known about energy use.  Most devices can't tell.
+  virtual void reportEnergy( NetInterface& out ) { (void) out; }
+};
+
+#endif
+
@@ -0,0 +1,192 @@
+#ifndef __QUANTILE_SKETCH_H__
+#define __QUANTILE_SKETCH_H__
+
+#include <algorithm>    // for std::min, std::max
+#include <array>        // for std::array
+#include <cstdint>      // for uint64_t
+#include <type_traits>  // for std::is_integral
+#include "histogram_bins.h"
+
+///
+/// @brief Constant memory, mergeable quantile estimator
+///
+/// Samples are counted in HDR style logarithmic buckets (see Log2Bins),
+/// so any quantile is within 1 / 2^sub_bits of the true value - with the
+/// default of 3 that's 12.5%, or about half a dB for energies.  Only a
+/// window of num_buckets consecutive buckets is kept.  If a sample lands
+/// above the window it slides up and the buckets that fall off the bottom
+/// are collapsed into the lowest one.  High quantiles stay accurate; only
+/// quantiles that fall in the collapsed bucket lose resolution.
+///
+/// Two sketches with the same template arguments merge exactly: the
+/// result is the sketch of both streams.  That makes it possible to
+/// combine sketches from different devices or time periods.
+///
+/// T            The data-type we're sampling.  Integers only; negative
+///              samples are counted as 0.
+/// num_buckets  The number of buckets kept
+/// sub_bits     log2 of the buckets per power of 2
+///
+template< class T, unsigned int num_buckets, unsigned int sub_bits = 3 >
+class QuantileSketch
+{
+  static_assert( std::is_integral< T >::value, "QuantileSketch needs integer samples" );
+  static_assert( num_buckets >= 2, "QuantileSketch needs at least 2 buckets" );
+
+  public:
+
+  using array_t = std::array< unsigned int, (std::size_t) num_buckets >;
+
+  QuantileSketch()
+  {
+    reset();
+  }
+
+  /// @brief Forget all samples
+  void reset()
+  {
+    for ( auto& i : counts ) {
+      i = 0U;
+    }
+    offset = 0;
+    count = 0;
+    minSample = T();
+    maxSample = T();
+  }
+
+  void insert( T sample )
+  {
+    if ( sample < T() ) {
+      sample = T();
+    }
+    if ( count == 0 )
+    {
+      minSample = sample;
+      maxSample = sample;
+    }
+    minSample = std::min( minSample, sample );
+    maxSample = std::max( maxSample, sample );
+    ++count;
+    add( BeeFocus::log2Bucket( (uint64_t) sample, sub_bits ), 1 );
+  }
+
+  /// @brief Add another sketch's samples to this one
+  void merge( const QuantileSketch& other )
+  {
+    if ( other.count == 0 ) {
+      return;
+    }
+    if ( count == 0 )
+    {
+      minSample = other.minSample;
+      maxSample = other.maxSample;
+    }
+    minSample = std::min( minSample, other.minSample );
+    maxSample = std::max( maxSample, other.maxSample );
+    count += other.count;
+    for ( unsigned int i = 0; i < num_buckets; ++i )
+    {
+      if ( other.counts[i] ) {
+        add( other.offset + i, other.counts[i] );
+      }
+    }
+  }
+
+  ///
+  /// @brief Estimate a quantile
+  ///
+  /// @param[in] percent - 0 to 100.  0 is the minimum, 100 the maximum.
+  /// @return The middle of the bucket holding the sample at that rank,
+  ///         clipped to the smallest and largest samples.  0 if empty.
+  ///
+  T getQuantile( unsigned int percent ) const
+  {
+    if ( count == 0 ) {
+      return T();
+    }
+    const uint64_t rank = (( count - 1 ) * std::min( percent, 100U )) / 100;
+    uint64_t seen = 0;
+    unsigned int i = 0;
+    for ( ; i < num_buckets - 1; ++i )
+    {
+      seen += counts[i];
+      if ( seen > rank ) {
+        break;
+      }
+    }
+    const uint64_t lower = BeeFocus::log2BucketLowerEdge( offset + i, sub_bits );
+    const uint64_t upper = BeeFocus::log2BucketLowerEdge( offset + i + 1, sub_bits );
+    const T mid = (T) ( lower + ( upper - lower ) / 2 );
+    return std::min( std::max( mid, minSample ), maxSample );
+  }
+
+  /// @brief Number of samples inserted since the last reset
+  uint64_t getCount() const { return count; }
+
+  /// @brief Smallest sample (0 if there are no samples)
+  T getMin() const { return minSample; }
+
+  /// @brief Largest sample (0 if there are no samples)
+  T getMax() const { return maxSample; }
+
+  /// @brief The bucket number of counts[0], for exporting the sketch
+  unsigned int getOffset() const { return offset; }
+
+  /// @brief Raw bucket counts, starting at getOffset()
+  const array_t& getCounts() const { return counts; }
+
+  /// @brief Save or restore the sketch (see snapshot.h)
+  template< class Archive >
+  void serialize( Archive& ar )
+  {
+    ar.io( counts );
+    ar.io( offset );
+    ar.io( count );
+    ar.io( minSample );
+    ar.io( maxSample );
+  }
+
+  private:
+
+  /// @brief Count samples in an (absolute) bucket, sliding the window up
+  void add( unsigned int bucket, unsigned int n )
+  {
+    if ( bucket >= offset + num_buckets ) {
+      slideTo( bucket - num_buckets + 1 );
+    }
+    counts[ bucket < offset ? 0 : bucket - offset ] += n;
+  }
+
+  /// @brief Move the window's bottom up, collapsing what falls off
+  void slideTo( unsigned int newOffset )
+  {
+    const unsigned int drop = newOffset - offset;
+    unsigned int collapsed = 0;
+    for ( unsigned int i = 0; i < num_buckets; ++i )
+    {
+      if ( i <= drop )
+      {
+        collapsed += counts[i];
+      }
+      else
+      {
+        counts[ i - drop ] = counts[i];
+      }
+    }
+    const unsigned int kept = drop < num_buckets ? num_buckets - drop : 0;
+    for ( unsigned int i = kept; i < num_buckets; ++i ) {
+      counts[i] = 0;
+    }
+    counts[0] = collapsed;
+    offset = newOffset;
+  }
+
+  array_t counts;
+  unsigned int offset;
+  uint64_t count;
+  T minSample;
+  T maxSample;
+};
+
+#endif
+
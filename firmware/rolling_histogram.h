@@ -0,0 +1,190 @@
+#ifndef __ROLLING_HISTOGRAM_H__
+#define __ROLLING_HISTOGRAM_H__
+
+#include <array>        // for std::array
+#include <cstddef>      // for std::size_t
+
+namespace BeeFocus
+{
+  /// @brief Compile time list of indices, i.e., IndexList< 0, 1, 2 >
+  template< std::size_t... I >
+  struct IndexList {};
+
+  /// @brief Builds IndexList< 0, 1, ... N-1 >
+  template< std::size_t N, std::size_t... I >
+  struct MakeIndexList : MakeIndexList< N - 1, N - 1, I... > {};
+
+  template< std::size_t... I >
+  struct MakeIndexList< 0, I... >
+  {
+    using type = IndexList< I... >;
+  };
+}
+
+///
+/// @brief A ring of histograms, one per time slot
+///
+/// New samples go into the current slot.  Moving to the next slot reuses
+/// the oldest one, so the last num_slots slots are always kept and the
+/// memory used is fixed at compile time - num_slots histograms and a few
+/// counters.  Views over the most recent slots (i.e., "the last 6 hours")
+/// are built by merging bins on demand.
+///
+/// The caller decides what a slot means by numbering them; i.e., the
+/// current hour since 1970.  advanceTo() rotates one slot per step and
+/// stops after num_slots, since by then every slot has been cleared.
+///
+/// H          The Histogram type for each slot
+/// num_slots  The number of slots kept
+///
+template< class H, unsigned int num_slots >
+class RollingHistogram
+{
+  static_assert( num_slots >= 1, "RollingHistogram needs at least one slot" );
+
+  public:
+
+  using histogram_t = H;
+  static constexpr unsigned int numSlots = num_slots;
+
+  ///
+  /// @brief Constructor
+  ///
+  /// @param[in] min_r - Passed to every slot's histogram
+  /// @param[in] max_r - Passed to every slot's histogram
+  ///
+  template< class T >
+  RollingHistogram( T min_r, T max_r ) :
+    RollingHistogram( min_r, max_r,
+      typename BeeFocus::MakeIndexList< num_slots >::type() )
+  {
+  }
+
+  /// @brief Forget every slot.  The next advanceTo() starts a new ring.
+  void reset()
+  {
+    for ( auto& s : slots ) {
+      s.reset();
+    }
+    current = 0;
+    filled = 1;
+    started = false;
+  }
+
+  /// @brief Add a sample to the current slot
+  template< class T >
+  void insert( T sample )
+  {
+    slots[ current ].insert( sample );
+  }
+
+  /// @brief Move to the next slot, clearing the oldest
+  void rotate()
+  {
+    current = ( current + 1 ) % num_slots;
+    slots[ current ].reset();
+    if ( filled < num_slots ) {
+      ++filled;
+    }
+  }
+
+  ///
+  /// @brief Move forward to a numbered slot
+  ///
+  /// Skipped slots are left empty.  Slot numbers that go backwards (i.e.,
+  /// the wall clock was set back) keep using the current slot.
+  ///
+  /// @param[in] slot - The slot number, i.e., hours since 1970
+  ///
+  void advanceTo( unsigned int slot )
+  {
+    if ( !started )
+    {
+      started = true;
+      slotNumber = slot;
+      return;
+    }
+    unsigned int steps = 0;
+    while ( slotNumber < slot && steps < num_slots )
+    {
+      rotate();
+      ++slotNumber;
+      ++steps;
+    }
+    if ( slotNumber < slot ) {
+      slotNumber = slot;
+    }
+  }
+
+  /// @brief The current slot's number
+  unsigned int getSlotNumber() const { return slotNumber; }
+
+  /// @brief Number of slots with history, including the current one
+  unsigned int getSlotsFilled() const { return filled; }
+
+  ///
+  /// @brief A slot's histogram
+  ///
+  /// @param[in] slotsBack - 0 for the current slot, 1 for the one before...
+  ///
+  const H& getSlot( unsigned int slotsBack ) const
+  {
+    return slots[ ( current + num_slots - ( slotsBack % num_slots )) % num_slots ];
+  }
+
+  ///
+  /// @brief The most recent slots merged into one histogram
+  ///
+  /// @param[in] numRecent - Number of slots, including the current one.
+  ///                        Clipped to the slots that have history.
+  ///
+  H getView( unsigned int numRecent ) const
+  {
+    H view = slots[ current ];
+    const unsigned int n = numRecent < filled ? numRecent : filled;
+    for ( unsigned int back = 1; back < n; ++back )
+    {
+      view.merge( getSlot( back ));
+    }
+    if ( n == 0 ) {
+      view.reset();
+    }
+    return view;
+  }
+
+  /// @brief Save or restore every slot (see snapshot.h)
+  template< class Archive >
+  void serialize( Archive& ar )
+  {
+    for ( auto& s : slots ) {
+      s.serialize( ar );
+    }
+    ar.io( current );
+    ar.io( filled );
+    ar.io( slotNumber );
+    ar.io( started );
+    current %= num_slots;
+    filled = filled < num_slots ? filled : num_slots;
+  }
+
+  private:
+
+  template< class T, std::size_t... I >
+  RollingHistogram( T min_r, T max_r, BeeFocus::IndexList< I... > ) :
+    slots{{ ( (void) I, H( min_r, max_r ))... }},
+    current{ 0 }, filled{ 1 }, slotNumber{ 0 }, started{ false }
+  {
+  }
+
+  std::array< H, num_slots > slots;
+  unsigned int current;
+  unsigned int filled;
+  unsigned int slotNumber;
+  bool started;
+};
+
+template< class H, unsigned int num_slots >
+constexpr unsigned int RollingHistogram< H, num_slots >::numSlots;
+
+#endif
+
@@ -1,4 +1,5 @@
 
+#include <algorithm>
 #include <iterator>
 #include <vector>
 #include <string>
@@ -7,9 +8,19 @@
 #include "wifi_debug_ostream.h"
 #include "sample_sound.h"
 #include "time_manager.h"
+#include "fixed_math.h"
 
 using namespace FS;
 
+constexpr unsigned int SSound::sampleIntervalUs;
+constexpr unsigned int SSound::burstSize;
+constexpr unsigned int SSound::drainIntervalUs;
+constexpr unsigned int SSound::sampleRateHz;
+constexpr std::size_t SSound::numBands;
+constexpr unsigned int SSound::fftLog2Size;
+constexpr unsigned int SSound::historySlotSeconds;
+constexpr unsigned int SSound::historySlots;
+
 /////////////////////////////////////////////////////////////////////////
 //
 // Public Interfaces
@@ -20,9 +31,29 @@ SSound::SSound(
     std::shared_ptr<NetInterface> netArg,
     std::shared_ptr<HWI> hardwareArg,
     std::shared_ptr<DebugInterface> debugArg,
-    std::shared_ptr<TimeInterface> timeArg
-) : net{ netArg }, hardware{ hardwareArg }, debugLog{ debugArg }, timeMgr{ timeArg }
+    std::shared_ptr<TimeInterface> timeArg,
+    SampleMode sampleModeArg,
+    std::shared_ptr<SoundSampler> samplerArg
+) : net{ netArg }, hardware{ hardwareArg }, debugLog{ debugArg }, timeMgr{ timeArg },
+    sampleMode{ sampleModeArg }, sampler{ samplerArg },
+    sampleStartTime{ 0 },
+    absSamples{ 0 }, absTotal{ 0 }, absMean{ 0 }, absVariance{ 0 },
+    min_1sec_sample{ 0 }, max_1sec_sample{ 0 },
+    leqMeanSquare{ 0 }, leqDb{ 0 }, maxFastDb{ 0 },
+    fftFill{ 0 }, fftFrames{ 0 }, peakFrequencyHz{ 0 },
+    dayEnd{ 0 }, windowEnd{ 0 }, pauseEnd{ 0 },
+    time{ 0 }, uSecRemainder{ 0 },
+    downtimePending{ false }, savedWallTime{ 0 }, restoredAtMs{ 0 }, downtimeSeconds{ 0 },
+    timeLastInterruptingCommandOccured{ 0 }
 {
+  assert( sampleMode != SampleMode::TIMER || sampler );
+  bandMeanSquare.fill( 0 );
+  fftPower.fill( 0 );
+
+#ifdef DEBUG
+  curSample = 0;
+#endif
+
   DebugInterface& dlog = *debugLog;
   dlog << "Bringing up net interface\n";
   
@@ -40,8 +71,10 @@ SSound::SSound(
 
 unsigned int SSound::loop()
 {
-  ptrToMember function = stateImpl.at( stateStack.topState() );
-  const unsigned uSecToNextCall = (this->*function)();
+  if ( downtimePending && timeMgr->isSynced() ) {
+    catchUpDowntime();
+  }
+  const unsigned uSecToNextCall = runCycle();
   uSecRemainder += uSecToNextCall;
   time += uSecRemainder / 1000;
   uSecRemainder = uSecRemainder % 1000;
@@ -49,6 +82,55 @@ unsigned int SSound::loop()
   return uSecToNextCall;
 }
 
+void SSound::wokenEarly( unsigned int unusedUs )
+{
+  uint64_t us = time * 1000 + uSecRemainder;
+  us = unusedUs < us ? us - unusedUs : 0;
+  time = us / 1000;
+  uSecRemainder = (unsigned int) ( us % 1000 );
+}
+
+void SSound::save( SnapshotWriter& out )
+{
+  unsigned int wallTime = timeMgr->secondsSince1970();
+  out.io( wallTime );
+  serializeState( out );
+}
+
+bool SSound::restore( SnapshotReader& in )
+{
+  // What we have now, to go back to if the snapshot turns out to be bad
+  SnapshotWriter before;
+  serializeState( before );
+
+  unsigned int wallTime = 0;
+  in.io( wallTime );
+  serializeState( in );
+  if ( !in.atEnd() || cycle.getPoint< State >() >= State::END_OF_STATES ) {
+    in.fail();
+  }
+  if ( !in.ok() )
+  {
+    SnapshotReader undo( before.getData().data(), before.getData().size() );
+    serializeState( undo );
+    return false;
+  }
+
+  // The sampler stopped when we went down, so the window has to restart.
+  const State point = cycle.getPoint< State >();
+  if ( point == State::SAMPLE_1SEC_SOUNDS_COL || point == State::DRAIN_SAMPLER )
+  {
+    cycle.resumeAt( State::SAMPLE_1SEC_SOUNDS );
+  }
+
+  // The wall clock is only the restored one until the network is up, so
+  // the downtime isn't known yet.  See catchUpDowntime.
+  downtimePending = true;
+  savedWallTime = wallTime;
+  restoredAtMs = timeMgr->msSinceDeviceStart();
+  return true;
+}
+
 /////////////////////////////////////////////////////////////////////////
 //
 // Private Interfaces
@@ -69,50 +151,58 @@ unsigned int SSound::loop()
 //
 /////////////////////////////////////////////////////////////////////////
 
-// What does the focuser execute if it's in a particular state?
-const std::unordered_map<State,unsigned int (SSound::*)( void ),EnumHash>
-  SSound::stateImpl =
-{
-  { State::ACCEPT_COMMANDS,           &SSound::stateAcceptCommands },
-  { State::SAMPLE_1SEC_SOUNDS_COL,    &SSound::stateSample1SecCollector},
-  { State::SAMPLE_1SEC_SOUNDS,        &SSound::stateSample1Sec},
-  { State::SAMPLE_1HR,                &SSound::stateSample1Hr},
-  { State::SAMPLE_1HR_COL,            &SSound::stateSample1HrCollector},
-  { State::DO_PAUSE,                  &SSound::stateDoingPause},
-  { State::ERROR_STATE,               &SSound::stateError }
-};
-
 // Bind State Enums to Human Readable Debug Names
-const StateToString FS::stateNames =
-{
+constexpr StateToString FS::stateNames =
+{{
+  { State::START,                         "Starting" },
   { State::ACCEPT_COMMANDS,               "ACCEPTING_COMMANDS" },
-  { State::SAMPLE_1SEC_SOUNDS_COL,        "Collecting Samples" },
-  { State::SAMPLE_1SEC_SOUNDS,            "Collect 1 Sec of Samples"},
   { State::SAMPLE_1HR,                    "1Hr Sound Histogram" },
-  { State::SAMPLE_1HR_COL,                "Collecting 1Hr Histogram Samples"},
+  { State::SAMPLE_1SEC_SOUNDS,            "Collect 1 Sec of Samples"},
+  { State::SAMPLE_1SEC_SOUNDS_COL,        "Collecting Samples" },
+  { State::DRAIN_SAMPLER,                 "Draining Samples" },
   { State::DO_PAUSE,                      "Collect Sound Histogram Idle"},
-  { State::ERROR_STATE,                   "ERROR ERROR ERROR"  },
-};
+}};
+static_assert( FS::stateNames.isDense(), "Every State needs a name, in order" );
 
 // Implementation of the commands that the SSound Supports 
-const std::unordered_map<CommandParser::Command,
-  void (SSound::*)( CommandParser::CommandPacket),EnumHash> 
-  SSound::commandImpl = 
-{
+// Entries must be in Command order (see checkTables)
+constexpr BeeFocus::EnumTable< CommandParser::Command, SSound::ptrToCommand,
+  (std::size_t) CommandParser::Command::EndOfCommands > SSound::commandImpl = 
+{{
   { CommandParser::Command::Abort,      &SSound::doAbort },
   { CommandParser::Command::Status,     &SSound::doStatus },
   { CommandParser::Command::HReset,     &SSound::doHReset},
+  { CommandParser::Command::Stats,      &SSound::doStats },
+  { CommandParser::Command::Trace,      &SSound::doTrace },
   { CommandParser::Command::NoCommand,  &SSound::doError },
-};
+}};
+
+// Frequency bands of interest for a bee hive
+const GoertzelBank< SSound::numBands >::spec_array_t SSound::bandSpecs = {{
+  { "hum",    100,  600 },    // General hive hum
+  { "swarm",  200,  300 },    // Rises before a swarm
+  { "piping", 400,  500 },    // Queen tooting
+  { "high",   600, 2000 },    // Everything else we can hear
+}};
 
 // Can a command be interrupted/aborted?
-const CommandToBool FS::doesCommandInterrupt= 
-{
+constexpr CommandToBool FS::doesCommandInterrupt= 
+{{
   { CommandParser::Command::Abort,         true   },
   { CommandParser::Command::Status,        false  },
   { CommandParser::Command::HReset,        false  },
+  { CommandParser::Command::Stats,         false  },
+  { CommandParser::Command::Trace,         false  },
   { CommandParser::Command::NoCommand,     false  },
-};
+}};
+
+// Every state and command needs exactly one entry, in enum order
+void SSound::checkTables( void )
+{
+  static_assert( commandImpl.isDense(), "commandImpl must cover every Command in order" );
+  static_assert( doesCommandInterrupt.isDense(), 
+    "doesCommandInterrupt must cover every Command in order" );
+}
 
 /////////////////////////////////////////////////////////////////////////
 //
@@ -123,11 +213,11 @@ const CommandToBool FS::doesCommandInterrupt=
 // Entry point for all commands
 void SSound::processCommand( CommandParser::CommandPacket cp )
 {
-  if ( doesCommandInterrupt.at( cp.command ))
+  if ( doesCommandInterrupt[ cp.command ] )
   {
     timeLastInterruptingCommandOccured = time;
   }
-  auto function = commandImpl.at( cp.command );
+  auto function = commandImpl[ cp.command ];
   (this->*function)( cp );
 }
 
@@ -141,6 +231,40 @@ void SSound::doHReset( CommandParser::CommandPacket cp )
 {
   (void) cp;
   samples.reset();
+  levelSketch.reset();
+  for ( auto& h : bandSamples ) {
+    h.reset();
+  }
+}
+
+void SSound::setStatsReporter( std::shared_ptr<StatsInterface> reporter )
+{
+  statsReporter = reporter;
+}
+
+void SSound::doStats( CommandParser::CommandPacket cp )
+{
+  (void) cp;
+  *net << "Stats :\n";
+  auto reporter = statsReporter.lock();
+  if ( reporter ) {
+    reporter->reportStats( *net );
+  }
+  else {
+    *net << "no stats\n";
+  }
+}
+
+void SSound::doTrace( CommandParser::CommandPacket cp )
+{
+  (void) cp;
+  auto reporter = statsReporter.lock();
+  if ( reporter ) {
+    reporter->dumpTrace( *net );
+  }
+  else {
+    *net << "no trace\n";
+  }
 }
 
 void SSound::doStatus( CommandParser::CommandPacket cp )
@@ -149,8 +273,10 @@ void SSound::doStatus( CommandParser::CommandPacket cp )
   DebugInterface& log = *debugLog;
   log << "Processing status request\n";
   *net << "Status :\n";
+  // The big histogram covers all the history we have.
+  const histogram_t history = samples.getView( historySlots );
   histogram_t::array_t histoout;
-  samples.get_histogram( histoout );
+  history.get_histogram( histoout );
   int count=0;
 
   static std::string timeAsString;
@@ -162,11 +288,60 @@ void SSound::doStatus( CommandParser::CommandPacket cp )
 
   *net << "min 1sec sample " << min_1sec_sample << "\n";
   *net << "max 1sec sample " << max_1sec_sample << "\n";
-  *net << "histogram_slot  " << (max_1sec_sample - min_1sec_sample ) / 2 << "\n";
+  *net << "leq ms          " << leqMeanSquare << "\n";
+  *net << "leq dB          " << leqDb << "\n";
+  *net << "fast max dB     " << maxFastDb << "\n";
+  *net << "fast dB         " << levelMeter.getLevelDb() << "\n";
+  *net << "leq p50 dB      " << BeeFocus::db10( levelSketch.getQuantile( 50 )) << "\n";
+  *net << "leq p90 dB      " << BeeFocus::db10( levelSketch.getQuantile( 90 )) << "\n";
+  *net << "leq p99 dB      " << BeeFocus::db10( levelSketch.getQuantile( 99 )) << "\n";
+  *net << "histogram_slot  " << history.getBin( leqDb ) << "\n";
+  *net << "histogram_width " << history.getLowerEdge( 1 ) << "\n";
   *net << "absSamples      " << absSamples << "\n"; 
   *net << "absTotal        " << absTotal << "\n"; 
   *net << "absmean         " << absMean << "\n"; 
-  *net << "absAvg          " << absTotal/ absSamples << "\n"; 
+  *net << "absAvg          " << ( absSamples ? absTotal / absSamples : 0 ) << "\n"; 
+  *net << "variance        " << absVariance << "\n"; 
+  if ( sampler )
+  {
+    *net << "overruns        " << sampler->getOverruns() << "\n"; 
+  }
+  *net << "peak freq       " << peakFrequencyHz << "\n";
+  *net << "fft frames      " << fftFrames << "\n";
+  *net << "downtime s      " << downtimeSeconds << "\n";
+  *net << "state           " << stateNames[ cycle.getPoint< State >() ] << "\n";
+  for ( std::size_t b = 0; b < numBands; ++b )
+  {
+    const GoertzelBandSpec& spec = bandSpecs[b];
+    const uint64_t ms = bandMeanSquare[b];
+    *net << "band " << spec.name << " " << spec.lowHz << "-" << spec.highHz 
+         << " ms " << (unsigned int) std::min< uint64_t >( ms, ~0u ) 
+         << " dB " << BeeFocus::db10( ms ) << " :";
+    histogram_t::array_t bandOut;
+    bandSamples[b].get_histogram( bandOut );
+    for ( auto i : bandOut ) {
+      *net << " " << i;
+    }
+    *net << "\n";
+  }
+  // Trends.  Slots are numbered in hours since 1970, so the slot number
+  // also gives the UTC hour of the day.
+  const unsigned int slotsPerDay = 24 * 60 * 60 / historySlotSeconds;
+  const unsigned int slotOfDay = samples.getSlotNumber() % slotsPerDay;
+  printSummary( "last hour", samples.getView( 1 ));
+  printSummary( "last 6 hours", samples.getView( 6 ));
+  printSummary( "last 24 hours", history );
+  printSummary( "today", samples.getView( slotOfDay + 1 ));
+  for ( unsigned int back = 0; back < samples.getSlotsFilled(); ++back )
+  {
+    const histogram_t& slot = samples.getSlot( back );
+    if ( slot.getTotal() == 0 ) {
+      continue;
+    }
+    *net << "slot " << ( slotOfDay + slotsPerDay - back % slotsPerDay ) % slotsPerDay;
+    printSummary( "", slot );
+  }
+
   int total = 0;
   for ( auto i : histoout ) {
     total += i;
@@ -181,7 +356,7 @@ void SSound::doStatus( CommandParser::CommandPacket cp )
     count++;
   }
 #ifdef DEBUG 
-  for ( auto i = 0; i < absSamples; ++i )
+  for ( size_t i = 0; i < curSample; ++i )
   {
     for ( int j = 0; j < rawSamples[i]-absMean+40; ++j ) {
       *net << " ";
@@ -194,7 +369,8 @@ void SSound::doStatus( CommandParser::CommandPacket cp )
 void SSound::doError( CommandParser::CommandPacket cp )
 {
   (void) cp;
-  stateStack.push( State::ERROR_STATE, __LINE__ );   
+  WifiDebugOstream log( debugLog.get(), net.get() );
+  log << "hep hep hep error error error\n";
 }
 
 /////////////////////////////////////////////////////////////////////////
@@ -204,121 +380,279 @@ void SSound::doError( CommandParser::CommandPacket cp )
 /////////////////////////////////////////////////////////////////////////
 
 
-unsigned int SSound::stateAcceptCommands()
+unsigned int SSound::runCycle()
 {
-  DebugInterface& log = *debugLog;
-  auto cp = CommandParser::checkForCommands( log, *net );
-
-  if ( cp.command != CommandParser::Command::NoCommand )
+  BEEFOCUS_CO_BEGIN( cycle );
+  for ( ;; )
   {
-    processCommand( cp );
-    return 0;
+    // Answer commands between days, then start the day a second later
+    while ( acceptCommand() ) {
+      BEEFOCUS_CO_SLEEP( cycle, State::ACCEPT_COMMANDS, 0 );
+    }
+    BEEFOCUS_CO_SLEEP( cycle, State::SAMPLE_1HR, 1000 * 1000 );
+    sampleStartTime = timeMgr->secondsSince1970();
+    dayEnd = time + 1000 * 60 * 60 * 24;
+
+    for ( ;; )
+    {
+      BEEFOCUS_CO_SLEEP( cycle, State::SAMPLE_1SEC_SOUNDS, 0 );
+      startWindow();
+      windowEnd = time + 1000;
+      while ( !( windowEnd < time ))
+      {
+        if ( sampleMode == SampleMode::TIMER )
+        {
+          // The timer keeps sampling while other actions run.  Catch up
+          // a block at a time.
+          BEEFOCUS_CO_AWAIT_UNTIL( cycle, State::DRAIN_SAMPLER,
+            sampler->samples( burstSize, drainIntervalUs ), windowEnd < time );
+          drainSampler();
+        }
+        else
+        {
+          BEEFOCUS_CO_SLEEP( cycle, State::SAMPLE_1SEC_SOUNDS_COL, collectSamples() );
+        }
+      }
+      finishWindow();
+      if ( dayEnd < time ) {
+        break;
+      }
+
+      // Pause, answering commands as they come in
+      pauseEnd = time + 1000 * 3;
+      while ( !( pauseEnd < time ))
+      {
+        BEEFOCUS_CO_AWAIT_UNTIL( cycle, State::DO_PAUSE,
+          net->readable( commandLine, 1000 * 1000 ), pauseEnd < time );
+        if ( !( pauseEnd < time ))
+        {
+          auto cp = CommandParser::parseCommand( *debugLog, *net, commandLine );
+          if ( cp.command != CommandParser::Command::NoCommand ) {
+            processCommand( cp );
+          }
+        }
+      }
+    }
   }
+  BEEFOCUS_CO_END( cycle );
+}
 
-  stateStack.push( State::SAMPLE_1HR, 0 );
+bool SSound::acceptCommand()
+{
+  auto cp = CommandParser::checkForCommands( *debugLog, *net );
+  if ( cp.command == CommandParser::Command::NoCommand ) {
+    return false;
+  }
+  processCommand( cp );
+  return true;
+}
 
-  return 1000*1000;
+void SSound::startWindow()
+{
+  // Use the last window's mean as the DC bias if we have one.
+  bands.reset();
+  windowStats.reset();
+  if ( absSamples ) 
+  {
+    bands.setBias( absMean );
+  }
+  levelMeter.reset();
+  fftFill = 0;
+  fftFrames = 0;
+  fftPower.fill( 0 );
+#ifdef DEBUG
+  curSample = 0;
+#endif
+  if ( sampleMode == SampleMode::TIMER )
+  {
+    sampler->start( sampleIntervalUs );
+  }
 }
 
-unsigned int SSound::stateSample1SecCollector()
+unsigned int SSound::collectSamples()
 {
-  const unsigned endTime = (unsigned) stateStack.topArg().getInt();
-  if ( endTime < time ||
-    curSample >= rawSamples.size() )
+  if ( sampleMode == SampleMode::BURST )
   {
-    stateStack.pop();
+    // Read a whole block while we have the CPU.  The burst takes real 
+    // time, so account for it before handing control back.
+    std::array< unsigned short, burstSize > burst;
+    hardware->AnalogReadBurst( HWI::Pin::MICROPHONE, burst.data(), 
+      burst.size(), sampleIntervalUs );
+    for ( auto curSound : burst )
+    {
+      processSample( curSound );
+    }
+    uSecRemainder += burstSize * sampleIntervalUs;
     return 0;
   }
 
-  unsigned curSound = hardware->AnalogRead( HWI::Pin::MICROPHONE );
-  rawSamples[ curSample ] =  curSound;
-  curSample++;
-
-  min_1sec_sample = std::min( curSound, min_1sec_sample );
-  max_1sec_sample = std::max( curSound, max_1sec_sample );
-  return 100;
+  processSample( hardware->AnalogRead( HWI::Pin::MICROPHONE ));
+  return sampleIntervalUs;
 }
 
-unsigned int SSound::stateSample1Sec()
+void SSound::finishWindow()
 {
-  curSample = 0;
-  unsigned curSound = hardware->AnalogRead( HWI::Pin::MICROPHONE );
-  min_1sec_sample = curSound;
-  max_1sec_sample = curSound;
-  stateStack.pop();
-  stateStack.push( State::SAMPLE_1SEC_SOUNDS_COL, time + 1000 );
-  return 0;
+  if ( sampleMode == SampleMode::TIMER )
+  {
+    sampler->stop();
+    drainSampler();
+  }
+
+  absSamples = windowStats.getCount();
+  absTotal = windowStats.getAbsTotal();
+  absMean = windowStats.getMean();
+  absVariance = windowStats.getVariance();
+  min_1sec_sample = windowStats.getMin();
+  max_1sec_sample = windowStats.getMax();
+  leqMeanSquare = levelMeter.getLeqMeanSquare();
+  leqDb = levelMeter.getLeqDb();
+  maxFastDb = levelMeter.getMaxDb();
+  analyzeWindow();
+
+  // Use the Leq rather than the peak to peak value so one transient 
+  // can't skew the histogram.
+  samples.advanceTo( timeMgr->secondsSince1970() / historySlotSeconds );
+  samples.insert( leqDb );
+  levelSketch.insert( leqMeanSquare );
 }
 
-unsigned int SSound::stateSample1HrCollector()
+/////////////////////////////////////////////////////////////////////////
+//
+// Section 4. Utility Methods
+//
+/////////////////////////////////////////////////////////////////////////
+
+void SSound::processSample( unsigned short sample )
 {
-  unsigned int mean = 0;
-  for ( size_t i = 0; i < curSample; ++i )
+  windowStats.insert( sample );
+  levelMeter.insert( sample );
+  bands.insert( sample );
+  fftRe[ fftFill++ ] = sample;
+  if ( fftFill == fftRe.size() ) {
+    addFftFrame();
+  }
+
+#ifdef DEBUG
+  if ( curSample < rawSamples.size() )
   {
-    mean += (unsigned int ) rawSamples[ i ];
+    rawSamples[ curSample ] = sample;
+    curSample++;
   }
-  mean/= curSample;
+#endif
+}
 
-  unsigned int abs_total = 0;
-  for ( size_t i = 0; i < curSample; ++i )
+void SSound::drainSampler()
+{
+  std::array< unsigned short, burstSize > block;
+  std::size_t count;
+  while (( count = sampler->drain( block.data(), block.size() )) != 0 )
   {
-    int abs = ((int) mean) - ((int) rawSamples[i]);
-    abs = abs < 0 ? -abs : abs;
-    abs_total += abs;
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+      processSample( block[i] );
+    }
   }
+}
 
-  absSamples = curSample;
-  absTotal = abs_total;
-  absMean = mean;
+void SSound::addFftFrame()
+{
+  fftFill = 0;
 
-  // We pushed a 1 second sample on the stack when we started, so there's
-  // guaranteed data that can be read.
-  samples.insert( max_1sec_sample - min_1sec_sample );
+  // Remove the DC bias and scale the 10 bit ADC values up to Q15.
+  int32_t mean = 0;
+  for ( auto i : fftRe ) {
+    mean += i;
+  }
+  mean /= (int32_t) fftRe.size();
+  for ( std::size_t i = 0; i < fftRe.size(); ++i )
+  {
+    int32_t x = ( fftRe[i] - mean ) * 32;
+    x = std::min( std::max( x, (int32_t) -32768 ), (int32_t) 32767 );
+    fftRe[i] = (int16_t) x;
+    fftIm[i] = 0;
+  }
+  fft.transform( fftRe, fftIm );
 
-  // Are we done?
-  const unsigned endTime = (unsigned) stateStack.topArg().getInt();
-  if ( endTime < time ) {
-    stateStack.pop();
-    return 0;
+  for ( std::size_t i = 1; i < fftPower.size(); ++i ) {
+    fftPower[i] += fft_t::magnitudeSquared( fftRe, fftIm, i );
   }
-  stateStack.push( State::SAMPLE_1SEC_SOUNDS, 0);
-  stateStack.push( State::DO_PAUSE, time + 1000 * 3 );
-  return 0;
+  ++fftFrames;
 }
 
-unsigned int SSound::stateDoingPause()
+void SSound::analyzeWindow()
 {
-  const unsigned endTime = (unsigned) stateStack.topArg().getInt();
-  if ( endTime < time ) {
-    stateStack.pop();
-    return 0;
+  for ( std::size_t b = 0; b < numBands; ++b )
+  {
+    bandMeanSquare[b] = bands.getMeanSquare( b );
+    bandSamples[b].insert( BeeFocus::db10( bandMeanSquare[b] ));
   }
 
-  DebugInterface& debug= *debugLog;
-  auto cp = CommandParser::checkForCommands( debug, *net );
-  if ( cp.command != CommandParser::Command::NoCommand )
+  // The peak of the spectrum averaged over every full frame.  The samples
+  // after the last full frame are left out.
+  std::size_t peakBin = 0;
+  uint64_t peakPower = 0;
+  for ( std::size_t i = 1; i < fftPower.size(); ++i )
   {
-    processCommand( cp );
-    return 0;
+    if ( fftPower[i] > peakPower ) 
+    {
+      peakPower = fftPower[i];
+      peakBin = i;
+    }
   }
-
-  return 1000*1000;
+  peakFrequencyHz = peakBin * sampleRateHz / fft_t::size;
 }
 
-unsigned int SSound::stateSample1Hr()
+void SSound::printSummary( const char* name, const histogram_t& h )
 {
-  samples.reset();
-  sampleStartTime = timeMgr->secondsSince1970();
-  stateStack.push( State::SAMPLE_1HR_COL, time + 1000 * 60 * 60 * 24 );
-  stateStack.push( State::SAMPLE_1SEC_SOUNDS, time + 1000 * 60 * 60 );
-  return 0;
+  *net << name << " n " << h.getTotal();
+  if ( h.getTotal() ) 
+  {
+    *net << " p10 " << h.getPercentile( 10 ) << " p50 " << h.getPercentile( 50 )
+         << " p90 " << h.getPercentile( 90 );
+  }
+  *net << "\n";
 }
 
-unsigned int SSound::stateError()
+void SSound::catchUpDowntime()
 {
-  WifiDebugOstream log( debugLog.get(), net.get() );
-  log << "hep hep hep error error error\n";
-  return 10*1000*1000; // 10 sec pause 
+  downtimePending = false;
+
+  // Move our clock on by the downtime so the pending end times still 
+  // line up with the wall clock.  A long outage ends the cycle.
+  constexpr unsigned int maxDowntimeSeconds = 60 * 60 * 24 * 2;
+  const unsigned int sinceRestoreMs = timeMgr->msSinceDeviceStart() - restoredAtMs;
+  const uint64_t restoredAt = ( timeMgr->msSince1970() - sinceRestoreMs ) / 1000;
+  downtimeSeconds = 0;
+  if ( savedWallTime != 0 && restoredAt > savedWallTime ) {
+    downtimeSeconds = (unsigned int) std::min< uint64_t >( 
+      restoredAt - savedWallTime, maxDowntimeSeconds );
+  }
+  time += uint64_t( downtimeSeconds ) * 1000;
 }
 
-
+template< class Archive >
+void SSound::serializeState( Archive& ar )
+{
+  ar.io( time );
+  ar.io( sampleStartTime );
+  cycle.serialize( ar );
+  ar.io( dayEnd );
+  ar.io( windowEnd );
+  ar.io( pauseEnd );
+  samples.serialize( ar );
+  levelSketch.serialize( ar );
+  for ( auto& h : bandSamples ) {
+    h.serialize( ar );
+  }
+  ar.io( absSamples );
+  ar.io( absTotal );
+  ar.io( absMean );
+  ar.io( absVariance );
+  ar.io( min_1sec_sample );
+  ar.io( max_1sec_sample );
+  ar.io( leqMeanSquare );
+  ar.io( leqDb );
+  ar.io( maxFastDb );
+  ar.io( bandMeanSquare );
+  ar.io( peakFrequencyHz );
+}
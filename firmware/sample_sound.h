@@ -5,16 +5,21 @@
 #include <memory>
 #include <string>
 #include <assert.h>
-#include <unordered_map>
 #include "command_parser.h"
 #include "net_interface.h"
 #include "hardware_interface.h"
 #include "histogram.h"
+#include "quantile_sketch.h"
+#include "rolling_histogram.h"
+#include "streaming_stats.h"
+#include "sound_sampler.h"
+#include "goertzel.h"
+#include "fixed_fft.h"
+#include "level_meter.h"
 #include "time_interface.h"
-
-#ifdef GTEST_FOUND
-#include <gtest/gtest_prod.h>
-#endif
+#include "snapshot.h"
+#include "state_machine.h"
+#include "stats_interface.h"
 
 #include "action_interface.h"
 
@@ -23,117 +28,30 @@
 /// 
 namespace FS {
 
-/// @brief SSound's State Enum
+/// @brief Where SSound's sampling cycle is
 ///
-/// @see FS Namespace for high level description.
+/// The resume points of SSound's coroutine (see BeeFocus::Coroutine).
 ///
 enum class State 
 {
   START_OF_STATES = 0,        ///< Start of States
-  ACCEPT_COMMANDS = 0,        ///< Accepting commands from the net interface
-  SAMPLE_1SEC_SOUNDS,         ///< Get the max sound over 1 second
-  SAMPLE_1SEC_SOUNDS_COL,     ///< Collector state for SAMPLE_1SEC_SOUNDS
-  SAMPLE_1HR,                 ///< Get the max sound over 1 second
-  SAMPLE_1HR_COL,             ///< Collector for Sample_1HR
+  START = 0,                  ///< About to start the cycle
+  ACCEPT_COMMANDS,            ///< Accepting commands from the net interface
+  SAMPLE_1HR,                 ///< Waiting to start a day of windows
+  SAMPLE_1SEC_SOUNDS,         ///< About to start a 1 second window
+  SAMPLE_1SEC_SOUNDS_COL,     ///< Collecting a window, a sample or burst at a time
+  DRAIN_SAMPLER,              ///< Collecting a window from the SoundSampler
   DO_PAUSE,                   ///< Pause.  Check for commands every 1s
-  ERROR_STATE,                ///< Error Errror Error
   END_OF_STATES               ///< End of States
 };
 
-class StateArg
-{
-  public: 
-
-  enum class Type {
-    NONE,
-    INT
-  };
-
-  StateArg() : type{ Type::NONE}  {}
-  StateArg( int i ) : type{Type::INT}, intArg{ i } {}
-  Type getType() { return type; }
-  int getInt() { assert( type==Type::INT ); return intArg; }
-
-  private:
-
-  Type type;
-
-  union {
-    int intArg;
-  };
-};
-
+/// @brief How SSound reads the microphone
 ///
-/// @brief Stack of FS:States.
-///
-/// Invariants:
-///
-/// - In normal operation, the stack's bottom is always an ACCEPT_COMMANDS state
-/// - After construction, the stack can never be empty
-/// - If a pop operation leaves the stack empty an ERROR_STATE is pushed
-/// 
-class StateStack {
-  public:
-
-  StateStack()
-  {
-    push( State::ACCEPT_COMMANDS, StateArg() );
-  }
-
-  /// @brief Reset the stack to the newly initialized state.
-  void reset( void )
-  {
-    while ( stack.size() > 1 ) pop();
-  }
-
-  /// @brief Get the top state.
-  State topState( void )
-  {
-    return stack.back().state;
-  }
-
-  /// @brief Get the top state's argumment.
-  StateArg topArg( void )
-  {
-    return stack.back().arg;
-  }
-
-  /// @brief Set the top state's argumment.
-  void topArgSet( StateArg newVal )
-  {
-    stack.back().arg = newVal;
-  }
-
-  /// @brief Pop the top entry on the stack.
-  void pop( void )
-  {
-    stack.pop_back();
-    if ( stack.size() > 10 ) 
-    {
-      push( State::ERROR_STATE, StateArg(__LINE__) ); 
-    }
-    if ( stack.empty() ) 
-    {
-      // bug, should never happen.
-      push( State::ERROR_STATE, StateArg(__LINE__) ); 
-    }
-  }
-
-  /// @brief Push a new entry onto the stack
-  void push( State newState, StateArg newArg = StateArg() )
-  {
-    stack.push_back( { newState , newArg } );
-  }  
-  
-  private:
-
-  typedef struct 
-  {
-    State state;   
-    StateArg arg; 
-  } CommandPacket;
-
-  std::vector< CommandPacket > stack;
+enum class SampleMode
+{
+  POLLED,                     ///< One AnalogRead per loop() call
+  BURST,                      ///< A block of AnalogReads per loop() call
+  TIMER                       ///< Drain a SoundSampler's ring per loop() call
 };
 
 /// @brief Main SSound Class
@@ -160,7 +78,7 @@ class StateStack {
 ///   delayMicroseconds( delay );   
 /// }
 /// 
-class SSound : public ActionInterface
+class SSound : public ActionInterface, public PersistentInterface
 {
   public:
  
@@ -169,15 +87,37 @@ class SSound : public ActionInterface
   /// @param[in] netArg       - Interface to the network
   /// @param[in] hardwareArg  - Interface to the Hardware
   /// @param[in] debugArg     - Interface to the debug logger.
-  /// @param[in] params       - Hardware Parameters 
+  /// @param[in] timeArg      - Interface to the time manager
+  /// @param[in] sampleModeArg- How the microphone is read
+  /// @param[in] samplerArg   - Timer driven sampler.  Required for 
+  ///                           SampleMode::TIMER, otherwise ignored.
   ///
   SSound( 
 		std::shared_ptr<NetInterface> netArg,
 		std::shared_ptr<HWI> hardwareArg,
 		std::shared_ptr<DebugInterface> debugArg,
-		std::shared_ptr<TimeInterface>timeArg 
+		std::shared_ptr<TimeInterface>timeArg,
+    SampleMode sampleModeArg = SampleMode::BURST,
+    std::shared_ptr<SoundSampler> samplerArg = nullptr
 	);
 
+  /// @brief Time between microphone samples, in us (i.e., 10 kHz)
+  static constexpr unsigned int sampleIntervalUs = 100;
+  /// @brief Number of samples read per loop() call in BURST mode
+  static constexpr unsigned int burstSize = 64;
+  /// @brief Time between ring drains in TIMER mode, in us
+  static constexpr unsigned int drainIntervalUs = 10 * 1000;
+  /// @brief Microphone sample rate
+  static constexpr unsigned int sampleRateHz = 1000 * 1000 / sampleIntervalUs;
+  /// @brief Number of frequency bands measured in each window
+  static constexpr std::size_t numBands = 4;
+  /// @brief log2 of the size of each FFT frame.  A window's frames are averaged.
+  static constexpr unsigned int fftLog2Size = 8;
+  /// @brief Length of each slot of level history, in seconds
+  static constexpr unsigned int historySlotSeconds = 60 * 60;
+  /// @brief Number of slots of level history kept (i.e., 24 hours)
+  static constexpr unsigned int historySlots = 24;
+
   ///
   /// @brief Update the SSound's State
   ///
@@ -188,21 +128,55 @@ class SSound : public ActionInterface
 
   virtual const char* debugName() override final { return "SSound"; } 
 
+  ///
+  /// @brief Take back the part of the last delay that wasn't slept
+  ///
+  /// SSound's clock is the sum of the delays loop() returned, so it's
+  /// wound back when a command wakes it early.
+  ///
+  virtual void wokenEarly( unsigned int unusedUs ) override final;
+
+  ///
+  /// @brief Save the histograms, level history and where the cycle is
+  ///
+  virtual void save( SnapshotWriter& out ) override final;
+
+  ///
+  /// @brief Restore a saved SSound
+  ///
+  /// Sampling continues where it left off.  A 1 second window that was
+  /// being collected starts again.  Once the wall clock is synced (the 
+  /// restored time is only the time of the last save), the cycle's clock
+  /// is moved on by the time that passed while the device was down.
+  ///
+  /// Nothing changes unless the whole snapshot reads back.
+  ///
+  virtual bool restore( SnapshotReader& in ) override final;
+
+  ///
+  /// @brief Set what the stats and trace commands report on
+  ///
+  /// Only a weak reference is kept, as the reporter is usually the
+  /// ActionManager that owns this SSound.
+  ///
+  void setStatsReporter( std::shared_ptr<StatsInterface> reporter );
+
   private:
 
-#ifdef GTEST_FOUND
-  // So we can unit test the consistency of the class's constant - static 
-  // data without exposing it to everybody
-  FRIEND_TEST(SSOUND_ENUM, allStatesHaveImplementations );
-  FRIEND_TEST(SSOUND_ENUM, allCommandsHaveImplementations);
-#endif
+  using ptrToCommand = void ( SSound::*) ( CommandParser::CommandPacket );
+  /// @brief What SSound executes for each command, indexed by command
+  static const BeeFocus::EnumTable< CommandParser::Command, ptrToCommand,
+    (std::size_t) CommandParser::Command::EndOfCommands > commandImpl;
+
+  /// @brief The frequency bands measured in each window
+  static const GoertzelBank< numBands >::spec_array_t bandSpecs;
 
-  static const std::unordered_map<CommandParser::Command,
-    void (SSound::*)( CommandParser::CommandPacket),EnumHash> 
-    commandImpl;
+  /// @brief 2 dB bins from 0 that widen rather than clip loud readings
+  using histogram_t = Histogram< unsigned int, 30, 
+    AutoRangeBins< unsigned int, 30 >>;
 
-  using ptrToMember = unsigned int ( SSound::*) ( void );
-  static const std::unordered_map< State, ptrToMember, EnumHash > stateImpl;
+  /// @brief Compile time checks of the tables above.  Never called.
+  static void checkTables( void );
 
   /// @brief Deleted copy constructor
   SSound( const SSound& other ) = delete;
@@ -211,58 +185,134 @@ class SSound : public ActionInterface
   /// @brief Deleted assignment operator
   SSound& operator=( const SSound& ) = delete;
   
-  StateStack stateStack;
-
   void processCommand( CommandParser::CommandPacket cp );
 
-  /// @brief Wait for commands from the network interface
-  unsigned int stateAcceptCommands( void ); 
-  /// @brief Collect a sound sample. Exit when the time is past the state arg
-  unsigned int stateSample1SecCollector( void ); 
-  /// @brief Sample sound for 1 second, computing the maximum volume
-  unsigned int stateSample1Sec( void ); 
-  /// @brief Sample sound for 1 hour, computing a histogram of max volumes
-  unsigned int stateSample1Hr( void ); 
-  /// @brief Collector for 1 hour histogram sample
-  unsigned int stateSample1HrCollector( void ); 
-  /// @brief Pause (but accept commands)
-  unsigned int stateDoingPause( void ); 
-  /// @brief If we land in this state, complain a lot.
-  unsigned int stateError( void );
+  ///
+  /// @brief The sampling cycle, as a coroutine
+  ///
+  /// Answers commands, then spends a day collecting 1 second windows
+  /// with a 3 second pause after each, and starts over.
+  ///
+  /// @return The time until it should be resumed, in us
+  ///
+  unsigned int runCycle( void );
+  /// @brief Reset the window's statistics and start sampling
+  void startWindow( void );
+  /// @brief Collect a sample or a burst.  @return The time until the next
+  unsigned int collectSamples( void );
+  /// @brief Stop sampling and add the window to the histograms
+  void finishWindow( void );
+  /// @brief Process a command if there is one.  @return false if not.
+  bool acceptCommand( void );
+
+  /// @brief Add one microphone sample to the current 1 second window
+  void processSample( unsigned short sample );
+  /// @brief Move everything in the sampler's ring into the current window
+  void drainSampler( void );
+  /// @brief Transform a full FFT frame and add it to the window's spectrum
+  void addFftFrame( void );
+  /// @brief Compute the band energies and spectrum peak for the window
+  void analyzeWindow( void );
+  /// @brief Save or restore everything that survives a reboot
+  template< class Archive >
+  void serializeState( Archive& ar );
+  /// @brief Move the clock on by the downtime before the last restore
+  void catchUpDowntime( void );
+  /// @brief Print a one line summary of a histogram for status
+  void printSummary( const char* name, const histogram_t& h );
 
   void doAbort( CommandParser::CommandPacket );
   void doStatus( CommandParser::CommandPacket );
   void doHReset( CommandParser::CommandPacket );
+  void doStats( CommandParser::CommandPacket );
+  void doTrace( CommandParser::CommandPacket );
   void doError( CommandParser::CommandPacket );
 
   std::shared_ptr<NetInterface> net;
   std::shared_ptr<HWI> hardware;
   std::shared_ptr<DebugInterface> debugLog;
   std::shared_ptr<TimeInterface> timeMgr;
+  const SampleMode sampleMode;
+  std::shared_ptr<SoundSampler> sampler;
+  std::weak_ptr<StatsInterface> statsReporter;
   
-  unsigned min_1sec_sample;
-  unsigned max_1sec_sample;
+  unsigned int sampleStartTime;
+  /// @brief Histograms of each window's Leq, in dB, one per hour
+  RollingHistogram< histogram_t, historySlots > samples{ 0u, 59u }; 
+  /// @brief Every window's Leq mean square since the last hreset
+  QuantileSketch< unsigned int, 128 > levelSketch;
 
-  using histogram_t = Histogram< unsigned int, 30>;
+  /// @brief Fast weighted sound level and Leq for the current window
+  LevelMeter levelMeter{ sampleRateHz, LevelMeter::fastMs };
 
-  unsigned int sampleStartTime;
-  histogram_t samples{ 0, 59}; 
+  /// @brief Statistics for the 1 second window being collected
+  StreamingStats< unsigned short > windowStats;
 
+#ifdef DEBUG
+  /// @brief Raw capture of the current window, for the status dump
   std::array< unsigned short, 10000> rawSamples;
   size_t curSample;
+#endif
 
+  /// @brief Results from the last completed 1 second window
   unsigned int absSamples;
   unsigned int absTotal;
   unsigned int absMean;
-
-  /// @brief SSound uptime in MS
-  unsigned int time;
+  unsigned int absVariance;
+  unsigned int min_1sec_sample;
+  unsigned int max_1sec_sample;
+  unsigned int leqMeanSquare;
+  unsigned int leqDb;
+  unsigned int maxFastDb;
+
+  /// @brief Energy in each band for the current window
+  GoertzelBank< numBands > bands{ bandSpecs, sampleRateHz };
+  /// @brief Histograms of each band's level, in dB
+  std::array< histogram_t, numBands > bandSamples{{ 
+    { 0, 59 }, { 0, 59 }, { 0, 59 }, { 0, 59 } }};
+  /// @brief Mean square amplitude of each band in the last window
+  std::array< uint64_t, numBands > bandMeanSquare;
+
+  using fft_t = FixedFFT< fftLog2Size >;
+  fft_t fft;
+  /// @brief The frame being filled, then its FFT
+  fft_t::array_t fftRe;
+  fft_t::array_t fftIm;
+  std::size_t fftFill;
+  /// @brief Each bin's magnitude squared, summed over the window's frames
+  std::array< uint64_t, fft_t::size / 2 > fftPower;
+  /// @brief Number of frames in fftPower
+  unsigned int fftFrames;
+  /// @brief Strongest frequency in the last window
+  unsigned int peakFrequencyHz;
+
+  /// @brief Where runCycle left off
+  BeeFocus::Coroutine cycle;
+  /// @brief When the current day, window and pause end, in SSound's time
+  uint64_t dayEnd;
+  uint64_t windowEnd;
+  uint64_t pauseEnd;
+  /// @brief Input read by the pause
+  std::string commandLine;
+
+  /// @brief SSound uptime in MS.  64 bits, like ActionManager's clock,
+  ///        so the end times above still compare after 49.7 days.
+  uint64_t time;
 
   /// @brief For computing time in SSound::loop
   unsigned int uSecRemainder;
 
+  /// @brief The clock needs moving on once the wall clock is synced
+  bool downtimePending;
+  /// @brief Wall clock time of the restored snapshot, in seconds
+  unsigned int savedWallTime;
+  /// @brief timeMgr->msSinceDeviceStart() at the restore
+  unsigned int restoredAtMs;
+  /// @brief Downtime the clock was last moved on by, in seconds
+  unsigned int downtimeSeconds;
+
   /// @brief Time the last command that could have caused an interrupt happened
-  unsigned int timeLastInterruptingCommandOccured;
+  uint64_t timeLastInterruptingCommandOccured;
 };
 
 /// @brief Increment operator for State enum
@@ -272,10 +322,12 @@ inline State& operator++( State &s )
   return BeeFocus::advance< State, State::END_OF_STATES>(s);
 }
 
-/// @brief State to std::string Unordered Map
-using StateToString = std::unordered_map< State, const std::string, EnumHash >;
-/// @brief Command to bool Unordered Map
-using CommandToBool = std::unordered_map< CommandParser::Command, bool, EnumHash >;
+/// @brief State to debug name table, indexed by state
+using StateToString = BeeFocus::EnumTable< State, const char*,
+  (std::size_t) State::END_OF_STATES >;
+/// @brief Command to bool table, indexed by command
+using CommandToBool = BeeFocus::EnumTable< CommandParser::Command, bool,
+  (std::size_t) CommandParser::Command::EndOfCommands >;
 
 extern const StateToString stateNames;
 ///
@@ -286,25 +338,6 @@ extern const StateToString stateNames;
 ///
 extern const CommandToBool doesCommandInterrupt;
 
-/// @brief Output StateArg
-template <class T,
-  typename = my_enable_if_t<is_beefocus_sink<T>::value>>
-T& operator<<( T& sink, StateArg sA )
-{
-  switch (sA.getType() )
-  {
-    case StateArg::Type::NONE:
-      sink << "NoArg";
-      break;
-    case StateArg::Type::INT:
-      sink << sA.getInt();
-      break;
-    default:
-      assert(0);
-  }
-  return sink; 
-}
-
 }
 
 #endif
@@ -0,0 +1,72 @@
+#include <Arduino.h>
+#include "sample_timer_esp8266.h"
+
+namespace {
+
+// The interrupt handler and everything it touches must not live in flash:
+// the handler can fire while the flash cache is disabled.  The ring is 
+// in DRAM and SpscRing::push is always inlined into the handler.
+SampleRing* volatile timerRing = nullptr;
+
+// The SAR ADC's registers, as the SDK's system_adc_read() uses them
+constexpr uint32_t sarConfig = 0x60000D50;
+constexpr uint32_t sarData   = 0x60000D80;
+constexpr uint32_t sarStart  = 0x02;
+
+BEEFOCUS_ALWAYS_INLINE volatile uint32_t& sarReg( uint32_t address )
+{
+  return *reinterpret_cast< volatile uint32_t* >( address );
+}
+
+///
+/// @brief Read A0 without leaving IRAM
+///
+/// Does what system_adc_read() does once the SDK has set the SAR up:
+/// start a conversion, wait for the state machine to go idle and
+/// average its eight 11 bit results, which are stored inverted, down to 
+/// analogRead()'s 0 - 1023.  A conversion takes about 10 us.
+///
+uint16_t ICACHE_RAM_ATTR readAdc()
+{
+  sarReg( sarConfig ) &= ~sarStart;
+  sarReg( sarConfig ) |= sarStart;
+  while (( sarReg( sarConfig ) >> 24 ) & 0x07 )
+  {
+  }
+  uint32_t sum = 0;
+  for ( uint32_t i = 0; i < 8; ++i ) {
+    sum += ~sarReg( sarData + i * 4 ) & 0x7ff;
+  }
+  return ( sum + 8 ) >> 4;
+}
+
+void ICACHE_RAM_ATTR onTimer1()
+{
+  SampleRing* ring = timerRing;
+  if ( ring ) {
+    ring->push( readAdc() );
+  }
+}
+
+}
+
+void SampleTimerESP8266::start( unsigned int intervalUs, SampleRing& ring )
+{
+  stop();
+  // Let the SDK power up and configure the SAR, from normal context
+  analogRead( A0 );
+  timerRing = &ring;
+
+  // 80 MHz / 16 = 5 ticks per us.
+  timer1_isr_init();
+  timer1_attachInterrupt( onTimer1 );
+  timer1_enable( TIM_DIV16, TIM_EDGE, TIM_LOOP );
+  timer1_write( intervalUs * 5 );
+}
+
+void SampleTimerESP8266::stop()
+{
+  timer1_disable();
+  timer1_detachInterrupt();
+  timerRing = nullptr;
+}
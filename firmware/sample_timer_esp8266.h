@@ -0,0 +1,21 @@
+#ifndef __SAMPLE_TIMER_ESP8266_H__
+#define __SAMPLE_TIMER_ESP8266_H__
+
+#include "sample_timer_interface.h"
+
+///
+/// @brief Fixed rate sampling of A0 using the ESP8266's hardware timer 1
+///
+/// There's only one timer 1 and one ADC, so only one instance should be
+/// running at a time.  The interrupt handler, the ADC read and the ring
+/// push all run from IRAM, so sampling carries on while the flash cache
+/// is disabled.
+///
+class SampleTimerESP8266: public SampleTimerInterface {
+  public:
+
+  void start( unsigned int intervalUs, SampleRing& ring ) override;
+  void stop() override;
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef __SAMPLE_TIMER_INTERFACE_H__
+#define __SAMPLE_TIMER_INTERFACE_H__
+
+#include "spsc_ring.h"
+
+/// @brief Ring the sample timer fills.  At 10 kHz, about 200 ms of slack.
+using SampleRing = SpscRing< unsigned short, 2048 >;
+
+///
+/// @brief Interface to a fixed rate sample timer
+///
+/// Reads the microphone at a fixed rate, independent of ActionManager,
+/// and pushes each reading into a SampleRing.  The timer is the ring's
+/// only producer; a reading that doesn't fit is dropped and counted by 
+/// the ring.
+///
+/// On the device the reading is taken in an interrupt.  That interrupt 
+/// can fire while the flash cache is disabled (e.g., during a LittleFS 
+/// write), so everything it touches must live in IRAM or DRAM - no
+/// virtual calls, no callbacks and no analogRead, which all run from
+/// flash.
+///
+class SampleTimerInterface {
+  public:
+
+  virtual ~SampleTimerInterface() {}
+
+  ///
+  /// @brief Start pushing a reading into ring every intervalUs
+  ///
+  /// @param[in] intervalUs - Time between readings, in us
+  /// @param[in] ring       - Where the readings go.  Must outlive stop()
+  ///
+  virtual void start( unsigned int intervalUs, SampleRing& ring ) = 0;
+
+  /// @brief Stop reading.  Nothing is pushed after stop returns
+  virtual void stop() = 0;
+};
+
+#endif
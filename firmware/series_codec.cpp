@@ -0,0 +1,248 @@
+#include "series_codec.h"
+
+constexpr std::size_t SeriesEncoder::headerSize;
+
+namespace {
+
+uint64_t zigzag( int64_t value )
+{
+  return ( (uint64_t) value << 1 ) ^ (uint64_t) ( value >> 63 );
+}
+
+int64_t unzigzag( uint64_t value )
+{
+  return (int64_t) ( value >> 1 ) ^ -(int64_t) ( value & 1 );
+}
+
+/// @brief Prefix code buckets: prefix, prefix bits, payload bits
+struct Bucket
+{
+  uint8_t prefix;
+  uint8_t prefixBits;
+  uint8_t payloadBits;
+};
+
+constexpr Bucket buckets[] = {
+  { 0x02, 2, 6 },
+  { 0x06, 3, 9 },
+  { 0x0e, 4, 12 },
+  { 0x1e, 5, 32 },
+  { 0x1f, 5, 64 },
+};
+
+bool putUnsigned( BitWriter& out, uint64_t value )
+{
+  if ( value == 0 ) {
+    return out.put( 0, 1 );
+  }
+  for ( const Bucket& b : buckets )
+  {
+    if ( b.payloadBits == 64 || value < ( 1ULL << b.payloadBits )) {
+      return out.put( b.prefix, b.prefixBits ) && out.put( value, b.payloadBits );
+    }
+  }
+  return false;
+}
+
+bool getUnsigned( BitReader& in, uint64_t& value )
+{
+  // Count the 1s in the prefix, up to 5
+  unsigned int ones = 0;
+  uint64_t bit = 1;
+  while ( ones < 5 )
+  {
+    if ( !in.get( bit, 1 )) {
+      return false;
+    }
+    if ( !bit ) {
+      break;
+    }
+    ++ones;
+  }
+  if ( ones == 0 )
+  {
+    value = 0;
+    return true;
+  }
+  return in.get( value, buckets[ ones - 1 ].payloadBits );
+}
+
+}
+
+bool BitWriter::put( uint64_t value, unsigned int count )
+{
+  if ( bits + count > capacityBits ) {
+    return false;
+  }
+  while ( count )
+  {
+    const unsigned int offset = bits & 7;
+    const unsigned int room = 8 - offset;
+    const unsigned int n = count < room ? count : room;
+    const uint8_t chunk = (uint8_t) (( value >> ( count - n )) & (( 1u << n ) - 1 ));
+    uint8_t& byte = data[ bits >> 3 ];
+    // Clear the rest of the byte too; it may hold a rewound write
+    byte = (uint8_t) (( byte & ~( 0xffu >> offset )) | ( chunk << ( room - n )));
+    bits += n;
+    count -= n;
+  }
+  return true;
+}
+
+bool BitReader::get( uint64_t& value, unsigned int count )
+{
+  if ( bits + count > sizeBits ) {
+    return false;
+  }
+  value = 0;
+  while ( count )
+  {
+    const unsigned int offset = bits & 7;
+    const unsigned int room = 8 - offset;
+    const unsigned int n = count < room ? count : room;
+    const uint8_t byte = data[ bits >> 3 ];
+    value = ( value << n ) | (( byte >> ( room - n )) & (( 1u << n ) - 1 ));
+    bits += n;
+    count -= n;
+  }
+  return true;
+}
+
+SeriesEncoder::SeriesEncoder( uint8_t* blockArg, std::size_t blockSize,
+  SeriesCoding codingArg, uint64_t baseMs ) :
+  block{ blockArg },
+  writer{ blockSize >= headerSize ? blockArg + headerSize : nullptr,
+    blockSize >= headerSize ? blockSize - headerSize : 0 },
+  coding{ codingArg }, count{ 0 }, lastMs{ baseMs }, lastGapMs{ 0 },
+  lastValue{ 0 }, leading{ 0 }, meaningful{ 0 }
+{
+  if ( blockSize >= headerSize )
+  {
+    block[0] = 0;
+    block[1] = 0;
+    block[2] = (uint8_t) coding;
+  }
+}
+
+bool SeriesEncoder::append( uint64_t timeMs, int32_t value )
+{
+  if ( count == 0xffff ) {
+    return false;
+  }
+  const std::size_t start = writer.getBits();
+  const uint8_t oldLeading = leading;
+  const uint8_t oldMeaningful = meaningful;
+
+  const int64_t gapMs = (int64_t) ( timeMs - lastMs );
+  if ( !putUnsigned( writer, zigzag( gapMs - lastGapMs )) || !putValue( value ))
+  {
+    writer.rewind( start );
+    leading = oldLeading;
+    meaningful = oldMeaningful;
+    return false;
+  }
+  lastGapMs = gapMs;
+  lastMs = timeMs;
+  lastValue = (uint32_t) value;
+  ++count;
+  block[0] = (uint8_t) count;
+  block[1] = (uint8_t) ( count >> 8 );
+  return true;
+}
+
+bool SeriesEncoder::putValue( int32_t value )
+{
+  if ( coding == SeriesCoding::DELTA ) {
+    return putUnsigned( writer, zigzag( (int64_t) value - (int32_t) lastValue ));
+  }
+
+  const uint32_t x = (uint32_t) value ^ lastValue;
+  if ( x == 0 ) {
+    return writer.put( 0, 1 );
+  }
+  const unsigned int lead = __builtin_clz( x );
+  const unsigned int trail = __builtin_ctz( x );
+  if ( meaningful && lead >= leading && trail >= 32u - leading - meaningful )
+  {
+    // The changed bits fit in the last window
+    return writer.put( 2, 2 ) &&
+      writer.put( x >> ( 32 - leading - meaningful ), meaningful );
+  }
+  leading = (uint8_t) ( lead > 31 ? 31 : lead );
+  meaningful = (uint8_t) ( 32 - leading - trail );
+  return writer.put( 3, 2 ) && writer.put( leading, 5 ) &&
+    writer.put( meaningful - 1, 5 ) && writer.put( x >> trail, meaningful );
+}
+
+SeriesDecoder::SeriesDecoder( const uint8_t* block, std::size_t size, uint64_t baseMs ) :
+  reader{ size >= SeriesEncoder::headerSize ? block + SeriesEncoder::headerSize : nullptr,
+    size >= SeriesEncoder::headerSize ? size - SeriesEncoder::headerSize : 0 },
+  coding{ SeriesCoding::DELTA }, count{ 0 }, read{ 0 }, lastMs{ baseMs },
+  lastGapMs{ 0 }, lastValue{ 0 }, leading{ 0 }, meaningful{ 0 }
+{
+  if ( size < SeriesEncoder::headerSize || block[2] > (uint8_t) SeriesCoding::XOR ) {
+    return;
+  }
+  count = block[0] | ( block[1] << 8 );
+  coding = (SeriesCoding) block[2];
+}
+
+bool SeriesDecoder::next( uint64_t& timeMs, int32_t& value )
+{
+  uint64_t dod;
+  if ( read == count || !getUnsigned( reader, dod ) || !getValue( value ))
+  {
+    read = count;
+    return false;
+  }
+  lastGapMs += unzigzag( dod );
+  lastMs += lastGapMs;
+  lastValue = (uint32_t) value;
+  timeMs = lastMs;
+  ++read;
+  return true;
+}
+
+bool SeriesDecoder::getValue( int32_t& value )
+{
+  uint64_t bits;
+  if ( coding == SeriesCoding::DELTA )
+  {
+    if ( !getUnsigned( reader, bits )) {
+      return false;
+    }
+    value = (int32_t) ( (int32_t) lastValue + unzigzag( bits ));
+    return true;
+  }
+
+  if ( !reader.get( bits, 1 )) {
+    return false;
+  }
+  if ( !bits )
+  {
+    value = (int32_t) lastValue;
+    return true;
+  }
+  if ( !reader.get( bits, 1 )) {
+    return false;
+  }
+  if ( bits )
+  {
+    uint64_t lead, length;
+    if ( !reader.get( lead, 5 ) || !reader.get( length, 5 ) ||
+         lead + length + 1 > 32 ) {
+      return false;
+    }
+    leading = (uint8_t) lead;
+    meaningful = (uint8_t) ( length + 1 );
+  }
+  else if ( !meaningful ) {
+    return false;
+  }
+  if ( !reader.get( bits, meaningful )) {
+    return false;
+  }
+  value = (int32_t) ( lastValue ^ (uint32_t) ( bits << ( 32 - leading - meaningful )));
+  return true;
+}
+
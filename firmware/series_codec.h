@@ -0,0 +1,183 @@
+#ifndef __SERIES_CODEC_H__
+#define __SERIES_CODEC_H__
+
+#include <cstddef>
+#include <cstdint>
+
+///
+/// @brief Writes bit fields, most significant bit first, into a fixed buffer
+///
+class BitWriter
+{
+  public:
+
+  BitWriter() : data{ nullptr }, capacityBits{ 0 }, bits{ 0 } {}
+  BitWriter( uint8_t* dataArg, std::size_t size ) :
+    data{ dataArg }, capacityBits{ size * 8 }, bits{ 0 } {}
+
+  ///
+  /// @brief Write the low count bits of value
+  ///
+  /// @return false if they don't fit.  Nothing is written.
+  ///
+  bool put( uint64_t value, unsigned int count );
+
+  /// @brief Bits written
+  std::size_t getBits() const { return bits; }
+
+  /// @brief Go back to an earlier getBits(), i.e., to undo a failed write
+  void rewind( std::size_t to ) { bits = to; }
+
+  private:
+
+  uint8_t* data;
+  std::size_t capacityBits;
+  std::size_t bits;
+};
+
+///
+/// @brief Reads what BitWriter wrote
+///
+class BitReader
+{
+  public:
+
+  BitReader( const uint8_t* dataArg, std::size_t size ) :
+    data{ dataArg }, sizeBits{ size * 8 }, bits{ 0 } {}
+
+  /// @brief Read count bits
+  /// @return false if there aren't that many left
+  bool get( uint64_t& value, unsigned int count );
+
+  private:
+
+  const uint8_t* data;
+  std::size_t sizeBits;
+  std::size_t bits;
+};
+
+///
+/// @brief How a series' values are coded
+///
+enum class SeriesCoding : uint8_t
+{
+  /// @brief Zigzag coded change from the last value.  Best for integer
+  ///        and fixed point readings that move slowly.
+  DELTA = 0,
+  /// @brief Gorilla style: the bits that changed from the last value.
+  ///        Best for values that repeat or change in a few bits.
+  XOR = 1
+};
+
+///
+/// @brief Compresses a series of timestamped integers into a fixed block
+///
+/// Timestamps are coded as the change in the gap between samples (delta
+/// of delta), so samples on a schedule take a bit each.  Values are
+/// coded as set by SeriesCoding.  Both go through the same prefix code:
+///
+/// @code
+///   0                   0
+///   10    + 6 bits      < 2^6
+///   110   + 9 bits      < 2^9
+///   1110  + 12 bits     < 2^12
+///   11110 + 32 bits     < 2^32
+///   11111 + 64 bits     anything else
+/// @endcode
+///
+/// A block starts with a 3 byte header, the sample count (16 bits, little
+/// endian) and the coding, so it can be stored or sent as is and decoded
+/// on its own given the base time.  Blocks are fixed size and owned by
+/// the caller; when one is full append() fails and the caller starts
+/// another.
+///
+class SeriesEncoder
+{
+  public:
+
+  static constexpr std::size_t headerSize = 3;
+
+  SeriesEncoder() : SeriesEncoder( nullptr, 0, SeriesCoding::DELTA ) {}
+
+  ///
+  /// @brief Constructor
+  ///
+  /// @param[in] block     - Where the series goes
+  /// @param[in] blockSize - Its size, at least headerSize
+  /// @param[in] coding    - How values are coded
+  /// @param[in] baseMs    - The first timestamp is coded relative to
+  ///                        this.  The decoder needs the same value.
+  ///
+  SeriesEncoder( uint8_t* block, std::size_t blockSize, SeriesCoding coding,
+    uint64_t baseMs = 0 );
+
+  ///
+  /// @brief Add a sample
+  ///
+  /// @return false if the block is full.  The sample isn't added and the
+  ///         block is still valid.
+  ///
+  bool append( uint64_t timeMs, int32_t value );
+
+  /// @brief Samples in the block
+  std::size_t size() const { return count; }
+
+  /// @brief Bytes of the block in use, header included
+  std::size_t bytesUsed() const { return headerSize + ( writer.getBits() + 7 ) / 8; }
+
+  private:
+
+  bool putValue( int32_t value );
+
+  uint8_t* block;
+  BitWriter writer;
+  SeriesCoding coding;
+  uint16_t count;
+  uint64_t lastMs;
+  int64_t lastGapMs;
+  uint32_t lastValue;
+  /// @brief XOR coding's last window of changed bits
+  uint8_t leading;
+  uint8_t meaningful;
+};
+
+///
+/// @brief Reads a block written by SeriesEncoder
+///
+class SeriesDecoder
+{
+  public:
+
+  ///
+  /// @brief Constructor
+  ///
+  /// @param[in] block  - The block, bytesUsed() of it is enough
+  /// @param[in] size   - Bytes at block
+  /// @param[in] baseMs - The encoder's baseMs
+  ///
+  SeriesDecoder( const uint8_t* block, std::size_t size, uint64_t baseMs = 0 );
+
+  /// @brief Samples in the block; 0 if the header is bad
+  std::size_t size() const { return count; }
+
+  /// @brief Get the next sample
+  /// @return false at the end of the series, or if the block is corrupt
+  bool next( uint64_t& timeMs, int32_t& value );
+
+  private:
+
+  bool getValue( int32_t& value );
+
+  BitReader reader;
+  SeriesCoding coding;
+  std::size_t count;
+  std::size_t read;
+  uint64_t lastMs;
+  int64_t lastGapMs;
+  uint32_t lastValue;
+  uint8_t leading;
+  uint8_t meaningful;
+};
+
+#endif
+
@@ -0,0 +1,147 @@
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+///
+/// @brief Serializes state into a compact binary snapshot
+///
+/// Classes that can be snapshotted write one template method,
+///
+///   template< class Archive > void serialize( Archive& ar );
+///
+/// that calls ar.io() on each member.  The same method is used with a
+/// SnapshotWriter to save and a SnapshotReader to restore, so the two
+/// can't drift apart.  Values are stored in native byte order, so a
+/// snapshot is only read back on the hardware that wrote it - but maybe
+/// by a later build, after an OTA update.  Nothing in the snapshot says
+/// which fields it has, so any change to a serialize() needs a new
+/// StateSaver::version.
+///
+class SnapshotWriter
+{
+  public:
+
+  SnapshotWriter()
+  {
+  }
+
+  /// @brief Start a new snapshot, keeping the buffer's memory
+  void clear() { data.clear(); }
+
+  template< class T >
+  void io( const T& value )
+  {
+    static_assert( std::is_arithmetic< T >::value || std::is_enum< T >::value,
+      "Only numbers and enums can be written directly" );
+    const uint8_t* bytes = reinterpret_cast< const uint8_t* >( &value );
+    data.insert( data.end(), bytes, bytes + sizeof( T ));
+  }
+
+  template< class T, std::size_t N >
+  void io( const std::array< T, N >& values )
+  {
+    for ( const auto& v : values ) {
+      io( v );
+    }
+  }
+
+  /// @brief Replace a value that was already written at a byte offset
+  template< class T >
+  void overwrite( std::size_t pos, const T& value )
+  {
+    static_assert( std::is_arithmetic< T >::value, "Only numbers can be overwritten" );
+    std::memcpy( data.data() + pos, &value, sizeof( T ));
+  }
+
+  const std::vector< uint8_t >& getData() const { return data; }
+
+  private:
+
+  std::vector< uint8_t > data;
+};
+
+///
+/// @brief Reads a snapshot written by SnapshotWriter
+///
+/// Reading past the end leaves the values untouched and marks the reader
+/// as failed; callers check ok() once at the end.
+///
+class SnapshotReader
+{
+  public:
+
+  SnapshotReader( const uint8_t* dataArg, std::size_t sizeArg ) :
+    data{ dataArg }, size{ sizeArg }, pos{ 0 }, failed{ false }
+  {
+  }
+
+  template< class T >
+  void io( T& value )
+  {
+    static_assert( std::is_arithmetic< T >::value || std::is_enum< T >::value,
+      "Only numbers and enums can be read directly" );
+    if ( failed || size - pos < sizeof( T ))
+    {
+      failed = true;
+      return;
+    }
+    std::memcpy( &value, data + pos, sizeof( T ));
+    pos += sizeof( T );
+  }
+
+  template< class T, std::size_t N >
+  void io( std::array< T, N >& values )
+  {
+    for ( auto& v : values ) {
+      io( v );
+    }
+  }
+
+  /// @brief Mark the snapshot as bad (i.e., a value was out of range)
+  void fail() { failed = true; }
+
+  /// @brief True if every read so far succeeded
+  bool ok() const { return !failed; }
+
+  /// @brief True if the whole snapshot was read
+  bool atEnd() const { return pos == size; }
+
+  private:
+
+  const uint8_t* data;
+  std::size_t size;
+  std::size_t pos;
+  bool failed;
+};
+
+///
+/// @brief Something that can be saved in and restored from a snapshot
+///
+class PersistentInterface
+{
+  public:
+
+  virtual ~PersistentInterface() {}
+
+  /// @brief Write the current state
+  virtual void save( SnapshotWriter& out ) = 0;
+
+  ///
+  /// @brief Restore a saved state
+  ///
+  /// All or nothing: nothing is applied unless in is ok() and atEnd()
+  /// once everything has been decoded.
+  ///
+  /// @return false, with the state as it was, if the data was bad
+  ///
+  virtual bool restore( SnapshotReader& in ) = 0;
+};
+
+#endif
+
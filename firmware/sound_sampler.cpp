@@ -0,0 +1,36 @@
+
+#include "sound_sampler.h"
+
+constexpr std::size_t SoundSampler::ringSize;
+
+SoundSampler::SoundSampler( std::shared_ptr<SampleTimerInterface> timerArg ) :
+  timer{ timerArg }, running{ false }
+{
+}
+
+SoundSampler::~SoundSampler()
+{
+  stop();
+}
+
+void SoundSampler::start( unsigned int intervalUs )
+{
+  stop();
+  ring.discard();
+  running = true;
+  timer->start( intervalUs, ring );
+}
+
+void SoundSampler::stop()
+{
+  if ( running ) 
+  {
+    timer->stop();
+    running = false;
+  }
+}
+
+std::size_t SoundSampler::drain( unsigned short* out, std::size_t max )
+{
+  return ring.pop( out, max );
+}
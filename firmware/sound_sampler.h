@@ -0,0 +1,96 @@
+#ifndef __SOUND_SAMPLER_H__
+#define __SOUND_SAMPLER_H__
+
+#include <memory>
+#include "sample_timer_interface.h"
+
+///
+/// @brief Fixed rate sampler for the microphone
+///
+/// The timer reads the microphone and pushes the result into a ring 
+/// buffer, once per interval, whatever else is running.  The consumer 
+/// (SSound) drains the ring in bulk whenever ActionManager gets around to
+/// it, so a slow action doesn't leave a gap in the audio as long as it 
+/// takes less than a ring's worth of samples.  If the consumer falls 
+/// further behind than that the new samples are dropped and counted as
+/// overruns.
+///
+class SoundSampler {
+  public:
+
+  /// @brief Ring size.  At 10 kHz, about 200 ms of slack.
+  static constexpr std::size_t ringSize = SampleRing::getCapacity();
+
+  ///
+  /// @brief Constructor
+  ///
+  /// @param[in] timerArg     - The timer that reads the microphone
+  ///
+  explicit SoundSampler( std::shared_ptr<SampleTimerInterface> timerArg );
+
+  ~SoundSampler();
+
+  /// @brief Throw away old samples and start sampling every intervalUs
+  void start( unsigned int intervalUs );
+
+  /// @brief Stop sampling.  Samples already in the ring can still be drained
+  void stop();
+
+  /// @brief Is the timer running?
+  bool isRunning() const { return running; }
+
+  ///
+  /// @brief Remove up to max samples (consumer side)
+  ///
+  /// @param[out] out   - Where the samples go
+  /// @param[in]  max   - Space in out
+  /// @return           - The number of samples removed
+  ///
+  std::size_t drain( unsigned short* out, std::size_t max );
+
+  /// @brief Number of samples waiting to be drained (consumer side)
+  std::size_t available() const { return ring.size(); }
+
+  /// @brief Samples dropped because the ring was full
+  unsigned int getOverruns() const { return ring.getDropped(); }
+
+  ///
+  /// @brief Awaitable for samples to drain (see BEEFOCUS_CO_AWAIT)
+  ///
+  class Samples
+  {
+    public:
+
+    Samples( const SoundSampler& samplerArg, std::size_t countArg, unsigned int pollArg ) :
+      sampler( samplerArg ), count{ countArg }, poll{ pollArg } {}
+
+    bool ready() const { return sampler.available() >= count; }
+    unsigned int pollUs() const { return poll; }
+
+    private:
+
+    const SoundSampler& sampler;
+    const std::size_t count;
+    const unsigned int poll;
+  };
+
+  ///
+  /// @brief Await count samples in the ring, checking every pollUs
+  ///
+  Samples samples( std::size_t count, unsigned int pollUs ) const
+  {
+    return Samples( *this, count, pollUs );
+  }
+
+  private:
+
+  SoundSampler( const SoundSampler& ) = delete;
+  SoundSampler& operator=( const SoundSampler& ) = delete;
+
+  std::shared_ptr<SampleTimerInterface> timer;
+  bool running;
+
+  SampleRing ring;
+};
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef __SPSC_RING_H__
+#define __SPSC_RING_H__
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/// @brief Always inline, i.e., so the code ends up in an interrupt handler's
+///        IRAM section rather than in flash
+#define BEEFOCUS_ALWAYS_INLINE inline __attribute__(( always_inline ))
+
+///
+/// @brief Wait-free single producer, single consumer ring buffer
+///
+/// One context (i.e., a timer interrupt) pushes, another (i.e., an
+/// action's loop) pops.  Neither side ever blocks or loops waiting for
+/// the other.  The read and write counters run freely and are masked on
+/// access, so all capacity slots are usable.  Elements pushed while the
+/// ring is full are dropped and counted.
+///
+/// Only the producer may call push().  Only the consumer may call pop(),
+/// discard() and size().  Anyone may call getDropped().
+///
+/// T         The element type.  Should be cheap to copy.
+/// capacity  Number of elements.  Must be a power of 2.
+///
+template< class T, std::size_t capacity >
+class SpscRing
+{
+  static_assert( capacity != 0 && ( capacity & ( capacity - 1 )) == 0,
+    "SpscRing capacity must be a power of 2" );
+
+  public:
+
+  SpscRing() : writeCount{ 0 }, readCount{ 0 }, dropped{ 0 }
+  {
+  }
+
+  SpscRing( const SpscRing& ) = delete;
+  SpscRing& operator=( const SpscRing& ) = delete;
+
+  ///
+  /// @brief Add an element (producer side)
+  ///
+  /// @return false if the ring was full.  The element is dropped.
+  ///
+  BEEFOCUS_ALWAYS_INLINE bool push( T element )
+  {
+    const unsigned int w = writeCount.load( std::memory_order_relaxed );
+    const unsigned int r = readCount.load( std::memory_order_acquire );
+    if ( w - r >= capacity )
+    {
+      // Only the producer writes dropped, so no read-modify-write is needed
+      dropped.store( dropped.load( std::memory_order_relaxed ) + 1,
+        std::memory_order_relaxed );
+      return false;
+    }
+    data[ w & mask ] = element;
+    writeCount.store( w + 1, std::memory_order_release );
+    return true;
+  }
+
+  ///
+  /// @brief Remove up to max elements (consumer side)
+  ///
+  /// @param[out] out  - Where the elements go
+  /// @param[in]  max  - Space in out
+  /// @return          - The number of elements removed
+  ///
+  std::size_t pop( T* out, std::size_t max )
+  {
+    const unsigned int r = readCount.load( std::memory_order_relaxed );
+    const unsigned int w = writeCount.load( std::memory_order_acquire );
+    std::size_t n = w - r;
+    n = n < max ? n : max;
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+      out[i] = data[ ( r + i ) & mask ];
+    }
+    readCount.store( r + n, std::memory_order_release );
+    return n;
+  }
+
+  /// @brief Throw away everything in the ring (consumer side)
+  void discard()
+  {
+    readCount.store( writeCount.load( std::memory_order_acquire ),
+      std::memory_order_release );
+  }
+
+  /// @brief Number of elements waiting (consumer side)
+  std::size_t size() const
+  {
+    return writeCount.load( std::memory_order_acquire ) -
+           readCount.load( std::memory_order_relaxed );
+  }
+
+  /// @brief Elements push() has dropped since the ring was made
+  unsigned int getDropped() const
+  {
+    return dropped.load( std::memory_order_relaxed );
+  }
+
+  static constexpr std::size_t getCapacity() { return capacity; }
+
+  private:
+
+  static constexpr unsigned int mask = capacity - 1;
+
+  std::array< T, capacity > data;
+  std::atomic< unsigned int > writeCount;
+  std::atomic< unsigned int > readCount;
+  std::atomic< unsigned int > dropped;
+};
+
+#endif
+
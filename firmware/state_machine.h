@@ -0,0 +1,118 @@
+#ifndef __STATE_MACHINE_H__
+#define __STATE_MACHINE_H__
+
+#include <cstdint>      // for uint8_t
+#include "basic_types.h"
+
+///
+/// @brief Building blocks for the firmware's state machines
+///
+/// Dispatch tables are BeeFocus::EnumTables (see basic_types.h).  Like
+/// them, the coroutines are fixed size and never touch the heap, so
+/// they're safe to use from the hottest loops on the device.
+///
+namespace BeeFocus
+{
+  ///
+  /// @brief Where a stackless coroutine left off
+  ///
+  /// A coroutine is an action's loop() written as straight line code that
+  /// suspends back into ActionManager (see the BEEFOCUS_CO macros below).
+  /// The body sits in a switch on the resume point, so resuming is a
+  /// single jump and a suspension stores one byte.  Locals don't survive a
+  /// suspension - keep anything needed across one in members.
+  ///
+  /// Resume points are named by an enum rather than __LINE__, so a saved
+  /// coroutine resumes in the right place in the next build.  Each must be
+  /// used once, and 0 is the start.
+  ///
+  class Coroutine
+  {
+    public:
+
+    Coroutine() : point{ 0 } {}
+
+    /// @brief Start again from the top on the next resume
+    void restart() { point = 0; }
+
+    /// @brief Resume at a given point next (i.e., after a restore)
+    template< class E >
+    void resumeAt( E e ) { point = (uint8_t) e; }
+
+    /// @brief Where the coroutine will resume
+    template< class E >
+    E getPoint() const { return (E) point; }
+
+    /// @brief Save or restore the resume point (see snapshot.h)
+    template< class Archive >
+    void serialize( Archive& ar ) { ar.io( point ); }
+
+    /// @brief For the BEEFOCUS_CO macros only
+    uint8_t point;
+  };
+}
+
+///
+/// @brief Start a coroutine's body
+///
+/// Pairs with BEEFOCUS_CO_END, and the body goes between them:
+///
+///   unsigned int Blinker::loop()
+///   {
+///     BEEFOCUS_CO_BEGIN( co );
+///     for ( ;; ) {
+///       led( true );
+///       BEEFOCUS_CO_SLEEP( co, Point::ON, 1000 );
+///       BEEFOCUS_CO_AWAIT( co, Point::WAIT, net->readable( line, 1000 ));
+///       led( false );
+///     }
+///     BEEFOCUS_CO_END( co );
+///   }
+///
+#define BEEFOCUS_CO_BEGIN( co ) switch ( (co).point ) { case 0:
+
+///
+/// @brief Suspend for us microseconds (i.e., await sleep(us))
+///
+#define BEEFOCUS_CO_SLEEP( co, resumePoint, us ) \
+  do { \
+    (co).point = (uint8_t) ( resumePoint ); \
+    return ( us ); \
+    case (uint8_t) ( resumePoint ): ; \
+  } while ( 0 )
+
+///
+/// @brief Suspend until an awaitable is ready, or until expired is true
+///
+/// An awaitable is anything with bool ready() and unsigned int pollUs().
+/// It's built again and asked ready() on each resume, and until it's
+/// ready the coroutine sleeps for pollUs().  expired is checked first.
+/// Actions that are woken on input (see ActionManager::wakeOnInput) are
+/// resumed as soon as input arrives, rather than at the next poll.
+///
+#define BEEFOCUS_CO_AWAIT_UNTIL( co, resumePoint, awaitable, expired ) \
+  do { \
+    (co).point = (uint8_t) ( resumePoint ); \
+    case (uint8_t) ( resumePoint ): \
+    if ( !( expired )) \
+    { \
+      auto beefocusAwaitable = ( awaitable ); \
+      if ( !beefocusAwaitable.ready() ) { \
+        return beefocusAwaitable.pollUs(); \
+      } \
+    } \
+  } while ( 0 )
+
+/// @brief Suspend until an awaitable is ready
+#define BEEFOCUS_CO_AWAIT( co, resumePoint, awaitable ) \
+  BEEFOCUS_CO_AWAIT_UNTIL( co, resumePoint, awaitable, false )
+
+///
+/// @brief End a coroutine's body
+///
+/// Falling off the end starts the coroutine again on the next resume.
+///
+#define BEEFOCUS_CO_END( co ) } (co).point = 0; return 0
+
+#endif
+
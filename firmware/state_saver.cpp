@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <array>
+#include "state_saver.h"
+
+constexpr unsigned int StateSaver::snapshotIntervalMs;
+constexpr std::size_t StateSaver::pageSize;
+constexpr std::size_t StateSaver::maxPayloadSize;
+constexpr uint32_t StateSaver::magic;
+constexpr uint16_t StateSaver::version;
+constexpr std::size_t StateSaver::headerSize;
+
+StateSaver::StateSaver( 
+    std::shared_ptr<StorageInterface> storageArg,
+    std::shared_ptr<DebugInterface> debugArg,
+    std::vector< std::shared_ptr<PersistentInterface> > partsArg ) :
+  storage{ storageArg }, debug{ debugArg }, parts{ partsArg },
+  firstLoop{ true }, pagesWritten{ 0 }
+{
+}
+
+uint32_t StateSaver::checksum( const uint8_t* data, std::size_t size )
+{
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  for ( std::size_t i = 0; i < size; ++i )
+  {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+bool StateSaver::restore()
+{
+  DebugInterface& log = *debug;
+
+  std::array< uint8_t, headerSize > headerBytes;
+  if ( !storage->read( 0, headerBytes.data(), headerBytes.size() ))
+  {
+    log << "No snapshot to restore\n";
+    return false;
+  }
+  SnapshotReader header( headerBytes.data(), headerBytes.size() );
+  uint32_t headerMagic = 0;
+  uint16_t headerVersion = 0;
+  uint16_t numParts = 0;
+  uint32_t payloadSize = 0;
+  uint32_t payloadChecksum = 0;
+  header.io( headerMagic );
+  header.io( headerVersion );
+  header.io( numParts );
+  header.io( payloadSize );
+  header.io( payloadChecksum );
+  if ( headerMagic != magic || headerVersion != version || numParts != parts.size() )
+  {
+    log << "Snapshot has a different layout, ignoring it\n";
+    return false;
+  }
+  // Don't trust the header's size until the checksum has been checked
+  if ( payloadSize > maxPayloadSize )
+  {
+    log << "Snapshot is damaged, ignoring it\n";
+    return false;
+  }
+
+  std::vector< uint8_t > payload( payloadSize );
+  if ( !storage->read( headerSize, payload.data(), payload.size() ) ||
+       checksum( payload.data(), payload.size() ) != payloadChecksum )
+  {
+    log << "Snapshot is damaged, ignoring it\n";
+    return false;
+  }
+
+  // The storage now matches this payload, so the first save only has to
+  // write what changed since.
+  pageChecksums.clear();
+  for ( std::size_t p = 0; p < payload.size(); p += pageSize ) 
+  {
+    const std::size_t n = std::min( pageSize, payload.size() - p );
+    pageChecksums.push_back( checksum( payload.data() + p, n ));
+  }
+
+  bool allRestored = true;
+  std::size_t pos = 0;
+  for ( auto& part : parts )
+  {
+    uint32_t partSize = 0;
+    SnapshotReader sizeReader( payload.data() + pos, payload.size() - pos );
+    sizeReader.io( partSize );
+    pos += sizeof( partSize );
+    if ( !sizeReader.ok() || partSize > payload.size() - pos )
+    {
+      allRestored = false;
+      break;
+    }
+    SnapshotReader partReader( payload.data() + pos, partSize );
+    if ( !part->restore( partReader ))
+    {
+      log << "Part of the snapshot couldn't be restored\n";
+      allRestored = false;
+    }
+    pos += partSize;
+  }
+  log << "Snapshot restored\n";
+  return allRestored;
+}
+
+bool StateSaver::save()
+{
+  // Build the payload; each part's size goes in front of it.
+  writer.clear();
+  for ( auto& part : parts )
+  {
+    const std::size_t sizePos = writer.getData().size();
+    writer.io( uint32_t( 0 ));
+    part->save( writer );
+    const uint32_t partSize = (uint32_t) ( writer.getData().size() - sizePos - sizeof( uint32_t ));
+    writer.overwrite( sizePos, partSize );
+  }
+  const std::vector< uint8_t >& payload = writer.getData();
+  if ( payload.size() > maxPayloadSize )
+  {
+    (*debug) << "Snapshot is too big to save\n";
+    return false;
+  }
+
+  bool ok = true;
+  const std::size_t numPages = ( payload.size() + pageSize - 1 ) / pageSize;
+  pageChecksums.resize( numPages, 0 );
+  bool anyWritten = false;
+  for ( std::size_t page = 0; page < numPages; ++page )
+  {
+    const std::size_t start = page * pageSize;
+    const std::size_t n = std::min( pageSize, payload.size() - start );
+    const uint32_t sum = checksum( payload.data() + start, n );
+    if ( sum == pageChecksums[ page ] ) {
+      continue;
+    }
+    ok = storage->write( headerSize + start, payload.data() + start, n ) && ok;
+    pageChecksums[ page ] = sum;
+    ++pagesWritten;
+    anyWritten = true;
+  }
+  if ( !anyWritten ) {
+    return ok;
+  }
+
+  SnapshotWriter header;
+  header.io( magic );
+  header.io( version );
+  header.io( uint16_t( parts.size() ));
+  header.io( uint32_t( payload.size() ));
+  header.io( checksum( payload.data(), payload.size() ));
+  ok = storage->write( 0, header.getData().data(), header.getData().size() ) && ok;
+  ok = storage->commit() && ok;
+  if ( !ok ) 
+  {
+    // Don't trust what we think is on storage.
+    pageChecksums.clear();
+    (*debug) << "Snapshot write failed\n";
+  }
+  return ok;
+}
+
+unsigned int StateSaver::loop()
+{
+  // Everything was just restored (or started fresh); nothing to save yet.
+  if ( !firstLoop ) {
+    save();
+  }
+  firstLoop = false;
+  return snapshotIntervalMs * 1000;
+}
+
@@ -0,0 +1,90 @@
+#ifndef __STATE_SAVER_H__
+#define __STATE_SAVER_H__
+
+#include <memory>
+#include <vector>
+#include "action_interface.h"
+#include "debug_interface.h"
+#include "snapshot.h"
+#include "storage_interface.h"
+
+///
+/// @brief Periodically snapshots state to storage, and restores it on boot
+///
+/// Each part (i.e., SSound, TimeManager) is saved in order with its
+/// length in front, after a small header with a checksum of the whole
+/// payload.  A snapshot that fails the checksum - say, power was lost in
+/// the middle of a write - is ignored and everything starts fresh.
+///
+/// Writes are incremental.  The payload is split into pages and a
+/// checksum of each page is remembered; only pages that changed since the
+/// last snapshot are written, then the header.  Most of SSound's state is
+/// history that changes once an hour, so a typical snapshot writes a
+/// couple of pages.  Pages that have never been written have a checksum
+/// of 0, so they're written the first time.
+///
+class StateSaver : public ActionInterface
+{
+  public:
+
+  /// @brief Time between snapshots
+  static constexpr unsigned int snapshotIntervalMs = 5 * 60 * 1000;
+  /// @brief Size of the pages that are compared and rewritten
+  static constexpr std::size_t pageSize = 128;
+  /// @brief Largest payload saved or restored.  SSound's is about 4 KB.
+  static constexpr std::size_t maxPayloadSize = 16 * 1024;
+
+  ///
+  /// @brief Constructor
+  ///
+  /// @param[in] storageArg - Where snapshots go
+  /// @param[in] debugArg   - Interface to the debug logger
+  /// @param[in] partsArg   - What's saved, in order
+  ///
+  StateSaver( 
+    std::shared_ptr<StorageInterface> storageArg,
+    std::shared_ptr<DebugInterface> debugArg,
+    std::vector< std::shared_ptr<PersistentInterface> > partsArg );
+
+  ///
+  /// @brief Restore the last snapshot
+  ///
+  /// Call once at boot, before the first loop().  Parts that don't
+  /// restore cleanly keep their freshly constructed state (see
+  /// PersistentInterface::restore).
+  ///
+  /// @return true if every part was restored
+  ///
+  bool restore();
+
+  /// @brief Take a snapshot now.  @return false if storage failed
+  bool save();
+
+  /// @brief Number of pages written since construction, for testing
+  unsigned int getPagesWritten() const { return pagesWritten; }
+
+  virtual unsigned int loop() override final;
+  virtual const char* debugName() override final { return "StateSaver"; }
+
+  private:
+
+  static constexpr uint32_t magic = 0x53534642;   // "BFSS"
+  /// @brief Layout of the parts.  Bump on any change to a part's
+  ///        serialize(), so an older snapshot is ignored, not misread.
+  static constexpr uint16_t version = 5;
+  static constexpr std::size_t headerSize = 16;
+
+  static uint32_t checksum( const uint8_t* data, std::size_t size );
+
+  std::shared_ptr<StorageInterface> storage;
+  std::shared_ptr<DebugInterface> debug;
+  std::vector< std::shared_ptr<PersistentInterface> > parts;
+
+  SnapshotWriter writer;
+  std::vector< uint32_t > pageChecksums;
+  bool firstLoop;
+  unsigned int pagesWritten;
+};
+
+#endif
+
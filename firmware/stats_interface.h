@@ -0,0 +1,26 @@
+#ifndef __STATS_INTERFACE_H__
+#define __STATS_INTERFACE_H__
+
+class NetInterface;
+
+///
+/// @brief Something that can print run time statistics and traces
+///
+/// Used by the stats and trace commands, so SSound can report on objects
+/// it doesn't own (i.e., the ActionManager that runs it).
+///
+class StatsInterface
+{
+  public:
+
+  virtual ~StatsInterface() {}
+
+  /// @brief Print the statistics as a table, one line per row
+  virtual void reportStats( NetInterface& out ) = 0;
+
+  /// @brief Print the trace log as hex, for the simulator to convert
+  virtual void dumpTrace( NetInterface& out ) = 0;
+};
+
+#endif
+
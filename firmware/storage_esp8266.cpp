@@ -0,0 +1,49 @@
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "storage_esp8266.h"
+
+StorageESP8266::StorageESP8266( const char* pathArg ) : 
+  path{ pathArg }, mounted{ false }
+{
+}
+
+bool StorageESP8266::open()
+{
+  if ( file ) {
+    return true;
+  }
+  if ( !mounted ) {
+    mounted = LittleFS.begin();
+  }
+  if ( !mounted ) {
+    return false;
+  }
+  file = LittleFS.open( path, LittleFS.exists( path ) ? "r+" : "w+" );
+  return (bool) file;
+}
+
+bool StorageESP8266::read( std::size_t offset, uint8_t* data, std::size_t count )
+{
+  if ( !open() || offset + count > file.size() ) {
+    return false;
+  }
+  return file.seek( offset, SeekSet ) && file.read( data, count ) == count;
+}
+
+bool StorageESP8266::write( std::size_t offset, const uint8_t* data, std::size_t count )
+{
+  if ( !open() || !file.seek( offset, SeekSet )) {
+    return false;
+  }
+  return file.write( data, count ) == count;
+}
+
+bool StorageESP8266::commit()
+{
+  if ( !open() ) {
+    return false;
+  }
+  file.flush();
+  return true;
+}
+
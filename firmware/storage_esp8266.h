@@ -0,0 +1,33 @@
+#ifndef __STORAGE_ESP8266_H__
+#define __STORAGE_ESP8266_H__
+
+#include <FS.h>
+#include "storage_interface.h"
+
+///
+/// @brief Storage in a LittleFS file in the ESP8266's flash
+///
+/// The file is kept open and written in place, so an incremental
+/// snapshot only rewrites the flash blocks it touches.
+///
+class StorageESP8266: public StorageInterface {
+  public:
+
+  StorageESP8266( const char* pathArg );
+
+  bool read( std::size_t offset, uint8_t* data, std::size_t count ) override;
+  bool write( std::size_t offset, const uint8_t* data, std::size_t count ) override;
+  bool commit() override;
+
+  private:
+
+  /// @brief Open the file for update, creating it if needed
+  bool open();
+
+  const char* path;
+  bool mounted;
+  File file;
+};
+
+#endif
+
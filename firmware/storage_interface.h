@@ -0,0 +1,36 @@
+#ifndef __STORAGE_INTERFACE_H__
+#define __STORAGE_INTERFACE_H__
+
+#include <cstddef>
+#include <cstdint>
+
+///
+/// @brief Small block of non-volatile storage
+///
+/// Byte addressable, like an EEPROM.  Writes may be buffered until
+/// commit() is called.  On the device this is a file in flash; in the
+/// simulator and the unit tests it's a file on the host.
+///
+class StorageInterface
+{
+  public:
+
+  virtual ~StorageInterface() {}
+
+  /// 
+  /// @brief Read bytes 
+  ///
+  /// @return false if the bytes aren't there (i.e., nothing has been 
+  ///         written yet)
+  ///
+  virtual bool read( std::size_t offset, uint8_t* data, std::size_t count ) = 0;
+
+  /// @brief Write bytes.  @return false if the write failed
+  virtual bool write( std::size_t offset, const uint8_t* data, std::size_t count ) = 0;
+
+  /// @brief Make all writes so far durable.  @return false on failure
+  virtual bool commit() = 0;
+};
+
+#endif
+
@@ -0,0 +1,351 @@
+#ifndef __STREAM_WRITER_H__
+#define __STREAM_WRITER_H__
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include "broadcast_buffer.h"
+#include "clock_interface.h"
+#include "wake_interface.h"
+
+///
+/// @brief Where a StreamWriter sends output, i.e., a client's socket
+///
+class StreamSink
+{
+  public:
+
+  virtual ~StreamSink() {}
+
+  /// @brief Still connected?  The writer lets go of closed sinks.
+  virtual bool isOpen() = 0;
+
+  /// @brief Bytes send() would take right now without blocking
+  virtual std::size_t writeSpace() = 0;
+
+  /// @brief Send up to n bytes
+  /// @return The number sent
+  virtual std::size_t send( const char* data, std::size_t n ) = 0;
+};
+
+///
+/// @brief How a StreamWriter batches output
+///
+struct StreamWriterConfig
+{
+  /// @brief What to do when the sinks can't keep up with the writer
+  enum class WhenFull
+  {
+    DROP,   ///< Slow sinks skip ahead at once
+    BLOCK   ///< Wait up to maxBlockUs for the sinks, then drop
+  };
+
+  /// @brief Send once this much is waiting
+  std::size_t flushBytes;
+  /// @brief Send anything that's waited this long
+  unsigned int maxDelayUs;
+  WhenFull whenFull;
+  unsigned int maxBlockUs;
+};
+
+/// @brief StreamWriter counters
+struct StreamWriterStats
+{
+  /// @brief Bytes given to write()
+  unsigned int bytesWritten;
+  /// @brief Calls to StreamSink::send, roughly packets with Nagle off
+  unsigned int sends;
+  /// @brief flush() calls that sent
+  unsigned int flushes;
+  /// @brief flush() calls put off to batch more output
+  unsigned int deferred;
+  /// @brief Bytes sinks skipped because they fell behind
+  unsigned int droppedBytes;
+  /// @brief Time write() spent waiting for the sinks
+  unsigned int blockedUs;
+  /// @brief Sinks let go for taking nothing for maxStallUs
+  unsigned int stalledSinks;
+};
+
+///
+/// @brief Batches output to several sinks through a shared BroadcastBuffer
+///
+/// Writes of any size go into the buffer a segment at a time.  flush()
+/// only sends once flushBytes are waiting or the oldest has waited
+/// maxDelayUs, so callers can flush as often as they like and the sinks
+/// still get a few full packets instead of many small ones.  Each sink
+/// gets no more than its writeSpace(), so a full TCP window holds up
+/// only that sink; what happens when the buffer fills is set by
+/// StreamWriterConfig::whenFull.  A backlog is retried after pollUs,
+/// doubling up to maxRetryUs while no sink takes anything, and a sink
+/// that takes nothing for maxStallUs is let go.
+///
+template< std::size_t segmentSize, std::size_t segmentCount, std::size_t sinkCount >
+class StreamWriter
+{
+  public:
+
+  ///
+  /// @brief Constructor
+  ///
+  /// @param[in] clockArg  - For the flush deadline and blocking time
+  /// @param[in] waiterArg - Sleeps while blocked.  waitUs() should let
+  ///                        the sinks make progress (i.e., run the
+  ///                        network stack).
+  /// @param[in] configArg - Batching and overflow settings
+  ///
+  StreamWriter( std::shared_ptr< ClockInterface > clockArg,
+    WakeInterface& waiterArg, const StreamWriterConfig& configArg ) :
+    clock{ clockArg }, waiter( waiterArg ), config( configArg ),
+    stats{ 0, 0, 0, 0, 0, 0, 0 }, waiting{ 0 }, oldestUs{ 0 }, backlog{ false },
+    lastSendUs{ 0 }, retryUs{ pollUs }
+  {
+    sinks.fill( nullptr );
+    progressUs.fill( 0 );
+  }
+
+  StreamWriter( const StreamWriter& ) = delete;
+  StreamWriter& operator=( const StreamWriter& ) = delete;
+
+  ///
+  /// @brief Start sending to a sink, from the next write on
+  ///
+  /// Replaces any sink already in the slot, dropping its backlog.
+  ///
+  void attach( std::size_t slot, StreamSink* sink )
+  {
+    detach( slot );
+    sinks[ slot ] = sink;
+    progressUs[ slot ] = clock->microsSinceDeviceStart();
+    buffer.attach( slot );
+  }
+
+  void detach( std::size_t slot )
+  {
+    stats.droppedBytes += buffer.getPending( slot );
+    buffer.detach( slot );
+    sinks[ slot ] = nullptr;
+  }
+
+  /// @brief Queue data for all sinks.  May send, and may block (see
+  ///        StreamWriterConfig).
+  /// @return n
+  std::size_t write( const char* data, std::size_t n )
+  {
+    stats.bytesWritten += n;
+    if ( !anyAttached() ) {
+      return n;
+    }
+    std::size_t done = 0;
+    while ( done < n )
+    {
+      const std::size_t chunk = n - done < segmentSize ? n - done : segmentSize;
+      makeRoom( chunk );
+      const unsigned int skippedBefore = totalSkipped();
+      buffer.write( data + done, chunk );
+      stats.droppedBytes += totalSkipped() - skippedBefore;
+      if ( waiting == 0 ) {
+        oldestUs = clock->microsSinceDeviceStart();
+      }
+      waiting += chunk;
+      done += chunk;
+      if ( waiting >= config.flushBytes ) {
+        send();
+      }
+    }
+    return n;
+  }
+
+  /// @brief Send if enough is waiting, or it's waited long enough
+  void flush()
+  {
+    if ( isDue() ) {
+      send();
+    }
+    else if ( waiting ) {
+      ++stats.deferred;
+    }
+  }
+
+  /// @brief Send everything now, as far as the sinks will take it
+  void send()
+  {
+    ++stats.flushes;
+    backlog = false;
+    lastSendUs = clock->microsSinceDeviceStart();
+    bool progress = false;
+    for ( std::size_t slot = 0; slot < sinkCount; ++slot ) {
+      progress |= sendTo( slot );
+    }
+    waiting = 0;
+    // Back off while the sinks are stuck, so a full window doesn't
+    // keep the caller polling
+    if ( progress ) {
+      retryUs = pollUs;
+    }
+    else if ( backlog ) {
+      retryUs = retryUs < maxRetryUs / 2 ? retryUs * 2 : maxRetryUs;
+    }
+  }
+
+  /// @brief Time until flush() should next send; a large number if
+  ///        nothing's waiting
+  unsigned int getUsUntilDue()
+  {
+    const uint32_t now = clock->microsSinceDeviceStart();
+    unsigned int due = ~0u;
+    if ( backlog )
+    {
+      const uint32_t since = now - lastSendUs;
+      due = since >= retryUs ? 0 : retryUs - since;
+    }
+    if ( waiting )
+    {
+      const uint32_t age = now - oldestUs;
+      const unsigned int deadline = age >= config.maxDelayUs ? 0 : config.maxDelayUs - age;
+      due = deadline < due ? deadline : due;
+    }
+    return due;
+  }
+
+  const StreamWriterStats& getStats() const { return stats; }
+
+  private:
+
+  bool anyAttached() const
+  {
+    for ( StreamSink* sink : sinks ) {
+      if ( sink ) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool isDue()
+  {
+    return backlog || waiting >= config.flushBytes ||
+      ( waiting && clock->microsSinceDeviceStart() - oldestUs >= config.maxDelayUs );
+  }
+
+  ///
+  /// @brief Send a sink what it hasn't had, up to its writeSpace()
+  ///
+  /// Lets go of the sink if it's closed, or has taken nothing for
+  /// maxStallUs.
+  ///
+  /// @return Did the sink take anything?
+  ///
+  bool sendTo( std::size_t slot )
+  {
+    StreamSink* sink = sinks[ slot ];
+    if ( !sink ) {
+      return false;
+    }
+    if ( !sink->isOpen() )
+    {
+      detach( slot );
+      return false;
+    }
+    const uint32_t now = clock->microsSinceDeviceStart();
+    bool progress = false;
+    const char* data;
+    std::size_t size;
+    while (( size = buffer.peek( slot, data )) > 0 )
+    {
+      const std::size_t space = sink->writeSpace();
+      const std::size_t sent = space == 0 ? 0 :
+        sink->send( data, size < space ? size : space );
+      if ( sent == 0 )
+      {
+        if ( !progress && now - progressUs[ slot ] >= maxStallUs )
+        {
+          ++stats.stalledSinks;
+          detach( slot );
+          return false;
+        }
+        // Window's full.  Try again on a later flush.
+        backlog = true;
+        return progress;
+      }
+      ++stats.sends;
+      buffer.consume( slot, sent );
+      progress = true;
+    }
+    // Caught up
+    progressUs[ slot ] = now;
+    return progress;
+  }
+
+  ///
+  /// @brief Make room for n bytes if the policy allows
+  ///
+  /// Sends first; with BLOCK, then waits for the sinks to drain.  Any
+  /// shortfall left over makes the slowest sinks skip ahead in write().
+  ///
+  void makeRoom( std::size_t n )
+  {
+    if ( n <= buffer.getFreeSpace() ) {
+      return;
+    }
+    send();
+    if ( config.whenFull != StreamWriterConfig::WhenFull::BLOCK ) {
+      return;
+    }
+    const uint32_t start = clock->microsSinceDeviceStart();
+    uint32_t waited = 0;
+    while ( n > buffer.getFreeSpace() && waited < config.maxBlockUs )
+    {
+      const unsigned int left = config.maxBlockUs - waited;
+      waiter.waitUs( left < pollUs ? left : pollUs, false );
+      send();
+      waited = clock->microsSinceDeviceStart() - start;
+    }
+    stats.blockedUs += waited;
+  }
+
+  unsigned int totalSkipped() const
+  {
+    unsigned int skipped = 0;
+    for ( std::size_t slot = 0; slot < sinkCount; ++slot ) {
+      skipped += buffer.getSkipped( slot );
+    }
+    return skipped;
+  }
+
+  /// @brief How often a blocked write, or a backlog, checks the sinks
+  static constexpr unsigned int pollUs = 1000;
+  /// @brief Longest a backlog waits between checks
+  static constexpr unsigned int maxRetryUs = 64000;
+  /// @brief How long a sink with a backlog may take nothing before it's let go
+  static constexpr unsigned int maxStallUs = 10000000;
+
+  std::shared_ptr< ClockInterface > clock;
+  WakeInterface& waiter;
+  const StreamWriterConfig config;
+  StreamWriterStats stats;
+  BroadcastBuffer< segmentSize, segmentCount, sinkCount > buffer;
+  std::array< StreamSink*, sinkCount > sinks;
+  /// @brief Bytes written since the last send
+  std::size_t waiting;
+  /// @brief When the oldest of those was written
+  uint32_t oldestUs;
+  /// @brief Did a sink have more than its window at the last send?
+  bool backlog;
+  /// @brief When send() last ran
+  uint32_t lastSendUs;
+  /// @brief Time from lastSendUs to the next retry of a backlog
+  unsigned int retryUs;
+  /// @brief When each sink last took something, or was caught up
+  std::array< uint32_t, sinkCount > progressUs;
+};
+
+template< std::size_t segmentSize, std::size_t segmentCount, std::size_t sinkCount >
+constexpr unsigned int StreamWriter< segmentSize, segmentCount, sinkCount >::pollUs;
+template< std::size_t segmentSize, std::size_t segmentCount, std::size_t sinkCount >
+constexpr unsigned int StreamWriter< segmentSize, segmentCount, sinkCount >::maxRetryUs;
+template< std::size_t segmentSize, std::size_t segmentCount, std::size_t sinkCount >
+constexpr unsigned int StreamWriter< segmentSize, segmentCount, sinkCount >::maxStallUs;
+
+#endif
+
@@ -0,0 +1,143 @@
+#ifndef __STREAMING_STATS_H__
+#define __STREAMING_STATS_H__
+
+#include <algorithm>    // for std::min, std::max
+#include <array>
+#include <cstddef>
+#include <cstdint>      // for int64_t, uint64_t
+
+///
+/// @brief Single pass statistics over a stream of samples
+///
+/// Keeps the count, min, max, mean, variance and mean absolute deviation
+/// of a stream in bounded memory, so a sound window never has to be
+/// stored before it's analyzed.
+///
+/// The variance is exact (rounded down at the end).  Sums of the samples
+/// and their squares are kept relative to the first sample, in 64 bits,
+/// so 16 bit samples can be inserted for 2^32 samples before the sums
+/// could overflow.  Sound windows are 1 second long.
+///
+/// The absolute deviation is measured from the stream's own mean, like a
+/// two pass computation, which isn't known until the end.  So each
+/// sample value is counted in a table and the deviations are summed in
+/// a sweep of the table when asked for.  That's exact for samples below
+/// range and up to 65535 samples per reset; samples at or above range
+/// are counted as range - 1.
+///
+/// T       The sample type (i.e., unsigned short for ADC reads).  Must
+///         fit in 16 bits.
+/// range   Size of the absolute deviation table.  1024 for the 10 bit
+///         ADC; the table takes 2 bytes per entry.
+///
+template< class T, std::size_t range = 1024 >
+class StreamingStats
+{
+  public:
+
+  StreamingStats()
+  {
+    reset();
+  }
+
+  /// @brief Forget all samples
+  void reset()
+  {
+    count = 0;
+    sum = 0;
+    shift = 0;
+    shiftedSum = 0;
+    shiftedSumSq = 0;
+    minSample = T();
+    maxSample = T();
+    valueCounts.fill( 0 );
+  }
+
+  /// @brief Add a sample to the stream
+  void insert( T sample )
+  {
+    if ( count == 0 )
+    {
+      minSample = sample;
+      maxSample = sample;
+      shift = sample;
+    }
+    minSample = std::min( minSample, sample );
+    maxSample = std::max( maxSample, sample );
+
+    ++count;
+    sum += sample;
+    const int64_t d = static_cast<int64_t>( sample ) - shift;
+    shiftedSum += d;
+    shiftedSumSq += static_cast<uint64_t>( d * d );
+
+    ++valueCounts[ std::min< std::size_t >( sample, range - 1 ) ];
+  }
+
+  /// @brief Number of samples inserted since the last reset
+  unsigned int getCount() const { return count; }
+
+  /// @brief Smallest sample (0 if there are no samples)
+  T getMin() const { return minSample; }
+
+  /// @brief Largest sample (0 if there are no samples)
+  T getMax() const { return maxSample; }
+
+  /// @brief Integer mean, rounded down (0 if there are no samples)
+  unsigned int getMean() const
+  {
+    return count ? static_cast<unsigned int>( sum / count ) : 0;
+  }
+
+  /// @brief Population variance, rounded down (0 if there are no samples)
+  unsigned int getVariance() const
+  {
+    if ( !count ) {
+      return 0;
+    }
+    // n * variance = sumSq - sum^2 / n.  With sum = q n + r, sum^2 / n
+    // is q sum + q r + r^2 / n, which keeps every term in range.
+    const uint64_t n = count;
+    const uint64_t s = static_cast<uint64_t>(
+      shiftedSum < 0 ? -shiftedSum : shiftedSum );
+    const uint64_t q = s / n;
+    const uint64_t r = s % n;
+    const uint64_t rSqOverN = ( r * r + n - 1 ) / n;    // rounded up
+    const uint64_t m2 = shiftedSumSq - q * s - q * r - rSqOverN;
+    return static_cast<unsigned int>( m2 / n );
+  }
+
+  /// @brief Sum of the absolute deviations from getMean()
+  unsigned int getAbsTotal() const
+  {
+    const unsigned int mean = getMean();
+    uint64_t total = 0;
+    for ( std::size_t v = 0; v < range; ++v )
+    {
+      const unsigned int dev = v < mean ? mean - v : v - mean;
+      total += static_cast<uint64_t>( valueCounts[ v ] ) * dev;
+    }
+    return static_cast<unsigned int>( total );
+  }
+
+  /// @brief Mean absolute deviation from getMean(), rounded down
+  unsigned int getMeanAbsDev() const
+  {
+    return count ? getAbsTotal() / count : 0;
+  }
+
+  private:
+
+  unsigned int count;
+  uint64_t sum;
+  /// @brief The first sample; shiftedSum and shiftedSumSq are relative to it
+  T shift;
+  int64_t shiftedSum;
+  uint64_t shiftedSumSq;
+  T minSample;
+  T maxSample;
+  /// @brief How many times each sample value was inserted
+  std::array< uint16_t, range > valueCounts;
+};
+
+#endif
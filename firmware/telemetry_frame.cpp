@@ -0,0 +1,120 @@
+#include "telemetry_frame.h"
+
+constexpr uint8_t TelemetryFrame::magic0;
+constexpr uint8_t TelemetryFrame::magic1;
+constexpr uint8_t TelemetryFrame::version;
+constexpr std::size_t TelemetryFrame::headerSize;
+constexpr std::size_t TelemetryFrame::crcSize;
+constexpr uint8_t TelemetryFrame::maxReadings;
+constexpr std::size_t TelemetryFrame::maxChannels;
+constexpr std::size_t TelemetryFrame::blockSize;
+
+TelemetryFrame::TelemetryFrame( uint32_t deviceIdArg ) : deviceId{ deviceIdArg }
+{
+  reset();
+}
+
+void TelemetryFrame::reset()
+{
+  count = 0;
+  baseMs = 0;
+  channelsUsed = 0;
+}
+
+SeriesCoding TelemetryFrame::codingFor( Type type )
+{
+  switch ( type )
+  {
+    // Fixed point, and they move slowly
+    case Type::TEMPERATURE:
+    case Type::HUMIDITY:
+      return SeriesCoding::DELTA;
+  }
+  return SeriesCoding::XOR;
+}
+
+bool TelemetryFrame::add( Type type, uint8_t channel, uint64_t timeMs, int32_t value )
+{
+  if ( count == maxReadings ) {
+    return false;
+  }
+  if ( count == 0 ) {
+    baseMs = timeMs;
+  }
+
+  const uint8_t id = (uint8_t) (( (uint8_t) type << 4 ) | ( channel & 0xf ));
+  Channel* c = channels.data();
+  Channel* const end = c + channelsUsed;
+  for ( ; c != end && c->id != id; ++c );
+  if ( c == end )
+  {
+    if ( channelsUsed == maxChannels ) {
+      return false;
+    }
+    ++channelsUsed;
+    c->id = id;
+    c->series = SeriesEncoder( c->block.data(), c->block.size(), codingFor( type ), baseMs );
+  }
+  if ( !c->series.append( timeMs, value ))
+  {
+    return false;
+  }
+  ++count;
+  return true;
+}
+
+const std::vector< uint8_t >& TelemetryFrame::finish()
+{
+  bytes.assign( headerSize, 0 );
+  for ( std::size_t i = 0; i < channelsUsed; ++i )
+  {
+    const Channel& c = channels[i];
+    const std::size_t used = c.series.bytesUsed();
+    bytes.push_back( c.id );
+    bytes.push_back( (uint8_t) used );
+    bytes.insert( bytes.end(), c.block.begin(), c.block.begin() + used );
+  }
+
+  const std::size_t length = bytes.size() - headerSize;
+  bytes[0] = magic0;
+  bytes[1] = magic1;
+  bytes[2] = version;
+  bytes[3] = (uint8_t) count;
+  bytes[4] = (uint8_t) length;
+  bytes[5] = (uint8_t) ( length >> 8 );
+  for ( int i = 0; i < 4; ++i ) {
+    bytes[ 6 + i ] = (uint8_t) ( deviceId >> ( 8 * i ));
+  }
+  for ( int i = 0; i < 6; ++i ) {
+    bytes[ 10 + i ] = (uint8_t) ( baseMs >> ( 8 * i ));
+  }
+  const uint16_t crc = crc16( bytes.data(), bytes.size() );
+  bytes.push_back( (uint8_t) crc );
+  bytes.push_back( (uint8_t) ( crc >> 8 ));
+  return bytes;
+}
+
+uint32_t TelemetryFrame::deviceIdFor( const std::string& name )
+{
+  uint32_t hash = 2166136261u;
+  for ( char c : name )
+  {
+    hash ^= (uint8_t) c;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+uint16_t TelemetryFrame::crc16( const uint8_t* data, std::size_t size )
+{
+  uint16_t crc = 0xffff;
+  for ( std::size_t i = 0; i < size; ++i )
+  {
+    crc ^= (uint16_t) ( data[i] << 8 );
+    for ( int bit = 0; bit < 8; ++bit ) {
+      crc = ( crc & 0x8000 ) ? (uint16_t) (( crc << 1 ) ^ 0x1021 ) : (uint16_t) ( crc << 1 );
+    }
+  }
+  return crc;
+}
+
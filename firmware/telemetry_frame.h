@@ -0,0 +1,120 @@
+#ifndef __TELEMETRY_FRAME_H__
+#define __TELEMETRY_FRAME_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "series_codec.h"
+
+///
+/// @brief Compact binary frame of timestamped readings
+///
+/// A frame batches readings from one device:
+///
+/// @code
+///   offset  size  field
+///   0       2     magic, 0xb5 0xf0
+///   2       1     version
+///   3       1     number of readings
+///   4       2     length of the channel sections, in bytes
+///   6       4     device id (see deviceIdFor)
+///   10      6     base time, ms since 1970
+///   16      ...   channel sections
+///   ...     2     CRC-16/CCITT of everything before it
+/// @endcode
+///
+/// Each channel section is the channel byte (type << 4 | channel
+/// number), the series block's length (1 byte), and the channel's
+/// readings as a SeriesEncoder block relative to the base time.  Readings
+/// taken on a schedule with values that move slowly take about a byte
+/// each.  Multi-byte fields are little endian.
+///
+/// The magic, length and CRC let a decoder find frames in a stream that
+/// also carries text (see firmware_sim/telemetry_decode.h).
+///
+class TelemetryFrame
+{
+  public:
+
+  /// @brief What a channel measures, and in what units
+  enum class Type : uint8_t
+  {
+    TEMPERATURE = 1,  ///< Tenths of a degree C
+    HUMIDITY = 2      ///< Tenths of a percent
+  };
+
+  static constexpr uint8_t magic0 = 0xb5;
+  static constexpr uint8_t magic1 = 0xf0;
+  static constexpr uint8_t version = 2;
+  static constexpr std::size_t headerSize = 16;
+  static constexpr std::size_t crcSize = 2;
+  static constexpr uint8_t maxReadings = 255;
+  /// @brief Channels in one frame
+  static constexpr std::size_t maxChannels = 4;
+  /// @brief Series block size per channel
+  static constexpr std::size_t blockSize = 96;
+
+  ///
+  /// @brief Constructor
+  ///
+  /// @param[in] deviceIdArg - Goes in every frame's header
+  ///
+  TelemetryFrame( uint32_t deviceIdArg );
+
+  ///
+  /// @brief Add a reading
+  ///
+  /// @param[in] type    - What the reading is
+  /// @param[in] channel - Which one, if the device has several (0-15)
+  /// @param[in] timeMs  - When, in ms since 1970.  Each channel's
+  ///                      readings should be in time order.
+  /// @param[in] value   - The reading, in type's units
+  /// @return false if the frame is full.  The reading isn't added; send
+  ///         the frame and add it to the next one.
+  ///
+  bool add( Type type, uint8_t channel, uint64_t timeMs, int32_t value );
+
+  /// @brief Number of readings added since the last reset
+  std::size_t size() const { return count; }
+
+  ///
+  /// @brief Finish the frame and get its bytes
+  ///
+  /// Valid until the next finish or reset.
+  ///
+  const std::vector< uint8_t >& finish();
+
+  /// @brief Start a new frame
+  void reset();
+
+  /// @brief A device id from its name (32 bit FNV-1a)
+  static uint32_t deviceIdFor( const std::string& name );
+
+  /// @brief CRC-16/CCITT (polynomial 0x1021, initial value 0xffff)
+  static uint16_t crc16( const uint8_t* data, std::size_t size );
+
+  /// @brief How each type's values are coded
+  static SeriesCoding codingFor( Type type );
+
+  private:
+
+  /// @brief One channel's readings
+  struct Channel
+  {
+    uint8_t id;
+    std::array< uint8_t, blockSize > block;
+    SeriesEncoder series;
+  };
+
+  const uint32_t deviceId;
+  std::vector< uint8_t > bytes;
+  std::size_t count;
+  uint64_t baseMs;
+  std::array< Channel, maxChannels > channels;
+  std::size_t channelsUsed;
+};
+
+#endif
+
@@ -1,13 +1,69 @@
 #ifndef __TIME_INTERFACE_H__
 #define __TIME_INTERFACE_H__
 
+#include <cstdint>
+
+///
+/// @brief A wall clock reading, for disciplining the device clock
+///
+struct TimeSample {
+  ///
+  /// @brief msSinceDeviceStart() when the reading was good
+  ///
+  /// Base interfaces fill in the 32 bit value.  TimeManager widens it to
+  /// 64 bits (see WrapCounter) before ClockDiscipline sees it, so the
+  /// discipline's time doesn't wrap.
+  ///
+  uint64_t deviceMs;
+  /// @brief Wall clock time, in ms since 1970
+  uint64_t wallMs;
+  /// @brief How far off the reading might be (i.e., half the round trip)
+  unsigned int errorMs;
+};
+
 class TimeInterface {
   public:
 
   virtual unsigned int secondsSince1970() = 0;
   virtual unsigned int msSinceDeviceStart() = 0;
+
+  /// @brief Wall clock time in ms since 1970
+  virtual uint64_t msSince1970()
+  {
+    return uint64_t( secondsSince1970() ) * 1000;
+  }
+
+  ///
+  /// @brief Get a new wall clock reading
+  ///
+  /// By default a reading of secondsSince1970(), good to a second.
+  ///
+  /// @param[out] sample - The reading
+  /// @return false if there's no reading, or none since the last call
+  ///
+  virtual bool getSample( TimeSample& sample )
+  {
+    const unsigned int seconds = secondsSince1970();
+    if ( seconds == 0 ) {
+      return false;
+    }
+    sample = TimeSample{ msSinceDeviceStart(), uint64_t( seconds ) * 1000, 1000 };
+    return true;
+  }
+
+  /// @brief How long until the next reading is wanted
+  virtual void setSyncIntervalMs( unsigned int ) {}
+
+  ///
+  /// @brief Is the wall clock set from a time server?
+  ///
+  /// false while it's a guess, i.e., restored from a snapshot at boot.
+  ///
+  virtual bool isSynced()
+  {
+    return secondsSince1970() != 0;
+  }
 };
 
 #endif
 
-
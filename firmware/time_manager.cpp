@@ -1,22 +1,48 @@
 #include "time_manager.h"
 
-void TimeManager::baseInterfaceCheckForTimeSync( unsigned int msSinceDevStart )
+uint64_t TimeManager::deviceMs()
 {
-  if ( timeQueried && ( msSinceDevStart - timeQueriedAt ) < msBetweenTimeQueries ) 
+  return deviceWraps.extend( baseInterface->msSinceDeviceStart() );
+}
+
+void TimeManager::baseInterfaceCheckForTimeSync( uint64_t msSinceDevStart )
+{
+  if ( discipline.isSynced() && 
+       ( msSinceDevStart - lastSyncAt ) < discipline.getIntervalMs() ) 
   {
     return;
   }
-  timeQueried = true;
-  queryTime = baseInterface->secondsSince1970();
-  timeQueriedAt = msSinceDevStart;
+  // The base has no reading until it has heard from a time server.  It
+  // doesn't block (see NtpClient), so keep asking until it has.
+  TimeSample sample;
+  if ( !baseInterface->getSample( sample ) ) {
+    return;
+  }
+  // The reading's device time is the base's 32 bit one, from around now
+  sample.deviceMs = msSinceDevStart + 
+    int32_t( uint32_t( sample.deviceMs ) - uint32_t( msSinceDevStart ));
+  discipline.addSample( sample );
+  lastSyncAt = sample.deviceMs;
+  baseInterface->setSyncIntervalMs( discipline.getIntervalMs() );
 }
 
-unsigned int TimeManager::secondsSince1970()
+uint64_t TimeManager::msSince1970()
 {
-  unsigned int msSinceDevStart = baseInterface->msSinceDeviceStart();
+  const uint64_t msSinceDevStart = deviceMs();
   baseInterfaceCheckForTimeSync( msSinceDevStart );
 
-  return queryTime + ( msSinceDevStart - timeQueriedAt ) / 1000;
+  return discipline.wallMs( msSinceDevStart );
+}
+
+unsigned int TimeManager::secondsSince1970()
+{
+  return (unsigned int) ( msSince1970() / 1000 );
+}
+
+bool TimeManager::isSynced()
+{
+  baseInterfaceCheckForTimeSync( deviceMs() );
+  return discipline.isSynced();
 }
 
 unsigned int TimeManager::msSinceDeviceStart()
@@ -26,11 +52,27 @@ unsigned int TimeManager::msSinceDeviceStart()
 
 unsigned int TimeManager::loop()
 {
-  unsigned int msSinceDevStart = baseInterface->msSinceDeviceStart();
-  baseInterfaceCheckForTimeSync( msSinceDevStart );
+  baseInterfaceCheckForTimeSync( deviceMs() );
   return 5000000;
 }
 
+void TimeManager::save( SnapshotWriter& out )
+{
+  unsigned int now = secondsSince1970();
+  out.io( now );
+}
+
+bool TimeManager::restore( SnapshotReader& in )
+{
+  unsigned int savedTime = 0;
+  in.io( savedTime );
+  if ( !in.ok() || !in.atEnd() || savedTime == 0 ) {
+    return false;
+  }
+  discipline.setTime( deviceMs(), uint64_t( savedTime ) * 1000 );
+  return true;
+}
+
 void intTimeToString( std::string& outString, unsigned int secondsSince1970 )
 {
   constexpr unsigned int secondsPerMinute = 60;
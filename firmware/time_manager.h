@@ -2,35 +2,67 @@
 #define __TIME_MANAGER_H__
 
 #include <memory>
+#include <string>
 #include "time_interface.h"
 #include "action_interface.h"
+#include "clock_discipline.h"
+#include "monotonic_clock.h"
+#include "snapshot.h"
 
-class TimeManager: public TimeInterface, public ActionInterface {
+///
+/// @brief Wall clock time between readings from a base time interface
+///
+/// The base (i.e., NtpClient) is read when the ClockDiscipline wants
+/// another reading, and the discipline's fit fills in the time between.
+/// The base's device time wraps every 49.7 days, so it's widened to 64
+/// bits for the discipline.  That needs a call at least once per wrap;
+/// loop() runs every few seconds.
+///
+class TimeManager: public TimeInterface, public ActionInterface, 
+                   public PersistentInterface {
   public:
 
-  /// Query time every 8 hours.
-  static constexpr unsigned int msBetweenTimeQueries = 1000 * 60 * 60 * 8;
-
   TimeManager( std::shared_ptr< TimeInterface > baseInterfaceArg )
     : baseInterface{ baseInterfaceArg },
-      timeQueried{ false }
+      lastSyncAt{ 0 }
   {
   }
 
   virtual unsigned int secondsSince1970() override final;
   virtual unsigned int msSinceDeviceStart() override final;
+  /// @brief Wall clock time to the ms, drift included
+  virtual uint64_t msSince1970() override final;
+  /// @brief True once there's been a reading from the base interface
+  virtual bool isSynced() override final;
   virtual unsigned int loop() override final;
   virtual const char* debugName() override final { return "TimeManager"; }
 
+  /// @brief Save the current wall clock time
+  virtual void save( SnapshotWriter& out ) override final;
+
+  ///
+  /// @brief Use the saved wall clock time until a query succeeds
+  ///
+  /// The base interface is still queried on each use until it knows the
+  /// time.  Until then (i.e., the network isn't up yet) the restored time
+  /// is used, behind by however long the device was down.
+  ///
+  virtual bool restore( SnapshotReader& in ) override final;
+
+  const ClockDiscipline& getDiscipline() const { return discipline; }
+
   private:
 
   std::shared_ptr<TimeInterface> baseInterface;
-  bool timeQueried;
+  ClockDiscipline discipline;
+  WrapCounter deviceWraps;
+  /// @brief Device time of the last reading
+  uint64_t lastSyncAt;
 
-  unsigned int timeQueriedAt;
-  unsigned int queryTime;
+  /// @brief The base's msSinceDeviceStart(), widened to 64 bits
+  uint64_t deviceMs();
 
-  void baseInterfaceCheckForTimeSync( unsigned int msSinceDevStart );
+  void baseInterfaceCheckForTimeSync( uint64_t msSinceDevStart );
 
 };
 
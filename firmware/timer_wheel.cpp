@@ -0,0 +1,242 @@
+#include <algorithm>
+#include "timer_wheel.h"
+
+constexpr uint64_t TimerWheel::never;
+constexpr unsigned int TimerWheel::slotBits;
+constexpr unsigned int TimerWheel::slotsPerLevel;
+constexpr unsigned int TimerWheel::numLevels;
+constexpr uint16_t TimerWheel::idle;
+constexpr int TimerWheel::noTimer;
+
+namespace {
+
+constexpr unsigned int slotMask = TimerWheel::slotsPerLevel - 1;
+constexpr uint64_t allSlots = TimerWheel::slotsPerLevel == 64 ?
+  ~uint64_t( 0 ) : ( uint64_t( 1 ) << TimerWheel::slotsPerLevel ) - 1;
+
+/// @brief Index of the lowest set bit.  x must not be 0.
+inline unsigned int lowBit( uint64_t x )
+{
+#if defined( __GNUC__ )
+  return (unsigned int) __builtin_ctzll( x );
+#else
+  unsigned int result = 0;
+  while ( !( x & 1 ))
+  {
+    x >>= 1;
+    ++result;
+  }
+  return result;
+#endif
+}
+
+/// @brief Rotate a level's occupancy so bit 0 is slot pos
+inline uint64_t rotateDown( uint64_t bits, unsigned int pos )
+{
+  return pos ? (( bits >> pos ) | ( bits << ( TimerWheel::slotsPerLevel - pos ))) & allSlots : bits;
+}
+
+/// @brief Mask of count slots starting at first, wrapping around the level
+inline uint64_t slotRange( uint64_t first, uint64_t count )
+{
+  if ( count >= TimerWheel::slotsPerLevel )
+  {
+    return allSlots;
+  }
+  const uint64_t bits = ( uint64_t( 1 ) << count ) - 1;
+  const unsigned int r = (unsigned int) ( first & slotMask );
+  return r ? (( bits << r ) | ( bits >> ( TimerWheel::slotsPerLevel - r ))) & allSlots : bits;
+}
+
+}
+
+TimerWheel::TimerWheel( uint64_t startTime ) : now{ startTime }
+{
+  heads.fill( noTimer );
+  earliest.fill( never );
+  occupied.fill( 0 );
+}
+
+TimerWheel::TimerId TimerWheel::addTimer()
+{
+  timers.push_back( Timer{ 0, noTimer, noTimer, idle, 0 } );
+  expired.reserve( timers.size() );
+  return (TimerId) ( timers.size() - 1 );
+}
+
+void TimerWheel::schedule( TimerId id, uint64_t deadline )
+{
+  cancel( id );
+  timers[ id ].deadline = deadline;
+  insert( id );
+}
+
+void TimerWheel::cancel( TimerId id )
+{
+  if ( timers[ id ].level != idle )
+  {
+    unlink( id );
+  }
+}
+
+uint64_t TimerWheel::nextDeadline() const
+{
+  uint64_t best = never;
+  for ( unsigned int level = 0; level < numLevels; ++level )
+  {
+    const uint64_t bits = occupied[ level ];
+    if ( !bits ) {
+      continue;
+    }
+    // Slots run in time order from the level's current slot, so the first
+    // occupied one holds the level's earliest deadline.
+    const unsigned int pos = (unsigned int) ( now >> ( slotBits * level )) & slotMask;
+    const unsigned int slot = ( pos + lowBit( rotateDown( bits, pos ))) & slotMask;
+    best = std::min( best, earliest[ index( level, slot ) ] );
+  }
+  return best == never ? never : std::max( best, now );
+}
+
+const std::vector< TimerWheel::TimerId >& TimerWheel::advanceTo( uint64_t time )
+{
+  const uint64_t old = now;
+  now = std::max( time, now );
+  expired.clear();
+
+  // Cascade the slots each upper level moved into.  Their timers now fit
+  // a lower level, or have expired.
+  for ( unsigned int level = numLevels - 1; level > 0; --level )
+  {
+    const unsigned int shift = slotBits * level;
+    const uint64_t from = ( old >> shift ) + 1;
+    const uint64_t to = now >> shift;
+    if ( to < from ) {
+      continue;
+    }
+    uint64_t pending = occupied[ level ] & slotRange( from, to - from + 1 );
+    while ( pending )
+    {
+      processSlot( level, lowBit( pending ));
+      pending &= pending - 1;
+    }
+  }
+
+  // Every level 0 slot from the old time to the new one has expired
+  uint64_t pending = occupied[ 0 ] & slotRange( old, now - old + 1 );
+  while ( pending )
+  {
+    processSlot( 0, lowBit( pending ));
+    pending &= pending - 1;
+  }
+
+  std::sort( expired.begin(), expired.end(), [this]( TimerId a, TimerId b )
+  {
+    return timers[ a ].deadline != timers[ b ].deadline ?
+      timers[ a ].deadline < timers[ b ].deadline : a < b;
+  });
+  return expired;
+}
+
+void TimerWheel::insert( TimerId id )
+{
+  Timer& t = timers[ id ];
+  const uint64_t when = std::max( t.deadline, now );
+
+  unsigned int level = 0;
+  uint64_t slotNumber = when;
+  for ( ; level < numLevels; ++level )
+  {
+    const unsigned int shift = slotBits * level;
+    slotNumber = when >> shift;
+    if ( slotNumber - ( now >> shift ) < slotsPerLevel ) {
+      break;
+    }
+  }
+  if ( level == numLevels )
+  {
+    // Too far out.  Park it in the top level's last slot until it's in range.
+    level = numLevels - 1;
+    slotNumber = ( now >> ( slotBits * level )) + slotsPerLevel - 1;
+  }
+
+  const unsigned int slot = (unsigned int) slotNumber & slotMask;
+  const unsigned int i = index( level, slot );
+  t.level = (uint16_t) level;
+  t.slot = (uint16_t) slot;
+  t.prev = noTimer;
+  t.next = heads[ i ];
+  if ( heads[ i ] != noTimer )
+  {
+    timers[ heads[ i ] ].prev = (int) id;
+    earliest[ i ] = std::min( earliest[ i ], when );
+  }
+  else
+  {
+    earliest[ i ] = when;
+  }
+  heads[ i ] = (int) id;
+  occupied[ level ] |= uint64_t( 1 ) << slot;
+}
+
+void TimerWheel::unlink( TimerId id )
+{
+  Timer& t = timers[ id ];
+  const unsigned int i = index( t.level, t.slot );
+  if ( t.prev != noTimer )
+  {
+    timers[ t.prev ].next = t.next;
+  }
+  else
+  {
+    heads[ i ] = t.next;
+  }
+  if ( t.next != noTimer ) {
+    timers[ t.next ].prev = t.prev;
+  }
+
+  if ( heads[ i ] == noTimer )
+  {
+    occupied[ t.level ] &= ~( uint64_t( 1 ) << t.slot );
+    earliest[ i ] = never;
+  }
+  else if ( std::max( t.deadline, now ) <= earliest[ i ] )
+  {
+    // We took out the slot's earliest timer, so look for the new one.
+    // Only cancels get here; expiring timers leave a slot all at once.
+    earliest[ i ] = never;
+    for ( int j = heads[ i ]; j != noTimer; j = timers[ j ].next ) {
+      earliest[ i ] = std::min( earliest[ i ], std::max( timers[ j ].deadline, now ));
+    }
+  }
+  t.level = idle;
+  t.next = noTimer;
+  t.prev = noTimer;
+}
+
+void TimerWheel::processSlot( unsigned int level, unsigned int slot )
+{
+  const unsigned int s = index( level, slot );
+  int i = heads[ s ];
+  heads[ s ] = noTimer;
+  earliest[ s ] = never;
+  occupied[ level ] &= ~( uint64_t( 1 ) << slot );
+
+  while ( i != noTimer )
+  {
+    Timer& t = timers[ i ];
+    const int next = t.next;
+    t.level = idle;
+    t.next = noTimer;
+    t.prev = noTimer;
+    if ( t.deadline <= now )
+    {
+      expired.push_back( (TimerId) i );
+    }
+    else
+    {
+      insert( (TimerId) i );
+    }
+    i = next;
+  }
+}
+
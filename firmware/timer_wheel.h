@@ -0,0 +1,126 @@
+#ifndef __TIMER_WHEEL_H__
+#define __TIMER_WHEEL_H__
+
+#include <array>        // for std::array
+#include <cstddef>      // for std::size_t
+#include <cstdint>      // for uint64_t
+#include <vector>       // for std::vector
+
+///
+/// @brief Hierarchical timer wheel
+///
+/// Each level is a ring of 32 slots.  A level 0 slot is 1 tick wide, a
+/// level 1 slot 32 ticks, a level 2 slot 1024 ticks and so on, so 7 levels
+/// cover 2^35 ticks - about 9.5 hours of microseconds.  Deadlines further
+/// out wait in the top level until they come into range.
+///
+/// A timer lives in the lowest level that can hold its deadline.  As time
+/// moves on, timers in the slot a level has just reached are cascaded
+/// down a level, and timers in the level 0 slots that have been passed
+/// expire.  Scheduling and cancelling are O(1).  Finding the next deadline
+/// and advancing time are O(1) per level: an occupancy mask per level
+/// finds the slots that need work, and each slot remembers its earliest
+/// deadline.
+///
+/// Timers are numbered from 0 by addTimer().  Each one is either idle or
+/// scheduled for a single deadline.
+///
+class TimerWheel
+{
+  public:
+
+  using TimerId = unsigned int;
+
+  /// @brief The deadline of a wheel with no scheduled timers
+  static constexpr uint64_t never = ~uint64_t( 0 );
+
+  static constexpr unsigned int slotBits = 5;
+  static constexpr unsigned int slotsPerLevel = 1u << slotBits;
+  static constexpr unsigned int numLevels = 7;
+  static_assert( slotsPerLevel <= 64, "A level's occupancy must fit a uint64_t" );
+
+  ///
+  /// @brief Constructor
+  ///
+  /// @param[in] startTime - The wheel's starting time, in ticks
+  ///
+  explicit TimerWheel( uint64_t startTime = 0 );
+
+  /// @brief Add an idle timer
+  /// @return The timer's id
+  TimerId addTimer();
+
+  /// @brief Number of timers added
+  std::size_t size() const { return timers.size(); }
+
+  ///
+  /// @brief Schedule a timer, replacing any deadline it already had
+  ///
+  /// @param[in] id       - The timer
+  /// @param[in] deadline - When it expires.  Deadlines in the past expire
+  ///                       on the next advanceTo().
+  ///
+  void schedule( TimerId id, uint64_t deadline );
+
+  /// @brief Make a timer idle.  Does nothing if it already is.
+  void cancel( TimerId id );
+
+  /// @brief Is the timer waiting to expire?
+  bool isScheduled( TimerId id ) const { return timers[ id ].level != idle; }
+
+  /// @brief The timer's deadline, if it's scheduled
+  uint64_t getDeadline( TimerId id ) const { return timers[ id ].deadline; }
+
+  /// @brief The current time, in ticks
+  uint64_t getNow() const { return now; }
+
+  /// @brief The earliest deadline of any scheduled timer, or never
+  uint64_t nextDeadline() const;
+
+  ///
+  /// @brief Move time forward and collect the timers that expired
+  ///
+  /// @param[in] time - The new time.  Times in the past are ignored.
+  /// @return The expired timers, now idle, in deadline then id order.
+  ///         Valid until the next call.
+  ///
+  const std::vector< TimerId >& advanceTo( uint64_t time );
+
+  private:
+
+  static constexpr uint16_t idle = 0xffff;
+  static constexpr int noTimer = -1;
+
+  struct Timer
+  {
+    uint64_t deadline;
+    int next;
+    int prev;
+    uint16_t level;
+    uint16_t slot;
+  };
+
+  /// @brief Put a timer in the right slot for its deadline
+  void insert( TimerId id );
+
+  /// @brief Take a timer out of its slot
+  void unlink( TimerId id );
+
+  /// @brief Detach a slot's timers and re-insert or expire each one
+  void processSlot( unsigned int level, unsigned int slot );
+
+  static unsigned int index( unsigned int level, unsigned int slot )
+  {
+    return level * slotsPerLevel + slot;
+  }
+
+  uint64_t now;
+  std::vector< Timer > timers;
+  std::array< int, numLevels * slotsPerLevel > heads;
+  std::array< uint64_t, numLevels * slotsPerLevel > earliest;
+  std::array< uint64_t, numLevels > occupied;
+  std::vector< TimerId > expired;
+};
+
+#endif
+
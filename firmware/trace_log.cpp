@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <cstring>
+#include "trace_log.h"
+
+constexpr uint32_t TraceLog::magic;
+constexpr uint16_t TraceLog::version;
+
+TraceLog::TraceLog( std::size_t capacity ) :
+  ring( capacity ? capacity : 1 ), first{ 0 }, count{ 0 }, dropped{ 0 }
+{
+}
+
+void TraceLog::setName( uint16_t action, const char* name )
+{
+  if ( action >= names.size() ) {
+    names.resize( action + 1, "" );
+  }
+  names[ action ] = name;
+}
+
+void TraceLog::save( SnapshotWriter& out ) const
+{
+  out.io( magic );
+  out.io( version );
+  out.io( (uint16_t) names.size() );
+  for ( const char* name : names )
+  {
+    const uint8_t length = (uint8_t) std::min< std::size_t >( strlen( name ), 255 );
+    out.io( length );
+    for ( uint8_t i = 0; i < length; ++i ) {
+      out.io( name[i] );
+    }
+  }
+  out.io( (uint32_t) count );
+  out.io( (uint32_t) dropped );
+  for ( std::size_t i = 0; i < count; ++i )
+  {
+    const Event& e = (*this)[ i ];
+    out.io( e.timeUs );
+    out.io( e.delayUs );
+    out.io( e.action );
+    out.io( e.type );
+  }
+}
+
+bool TraceLog::load( SnapshotReader& in, std::vector< std::string >& names,
+  std::vector< Event >& events )
+{
+  uint32_t logMagic = 0;
+  uint16_t logVersion = 0;
+  uint16_t numNames = 0;
+  in.io( logMagic );
+  in.io( logVersion );
+  in.io( numNames );
+  if ( !in.ok() || logMagic != magic || logVersion != version ) {
+    return false;
+  }
+
+  names.clear();
+  for ( uint16_t n = 0; n < numNames && in.ok(); ++n )
+  {
+    uint8_t length = 0;
+    in.io( length );
+    std::string name;
+    for ( uint8_t i = 0; i < length; ++i )
+    {
+      char c = 0;
+      in.io( c );
+      name += c;
+    }
+    names.push_back( name );
+  }
+
+  uint32_t numEvents = 0;
+  uint32_t logDropped = 0;
+  in.io( numEvents );
+  in.io( logDropped );
+  events.clear();
+  for ( uint32_t i = 0; i < numEvents && in.ok(); ++i )
+  {
+    Event e{ 0, 0, 0, Type::BEGIN, 0 };
+    in.io( e.timeUs );
+    in.io( e.delayUs );
+    in.io( e.action );
+    in.io( e.type );
+    if ( e.type != Type::BEGIN && e.type != Type::END ) {
+      in.fail();
+    }
+    events.push_back( e );
+  }
+  return in.ok();
+}
+
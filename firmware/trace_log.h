@@ -0,0 +1,115 @@
+#ifndef __TRACE_LOG_H__
+#define __TRACE_LOG_H__
+
+#include <cstddef>      // for std::size_t
+#include <cstdint>      // for uint32_t
+#include <string>       // for std::string
+#include <vector>       // for std::vector
+#include "snapshot.h"
+
+///
+/// @brief Flight recorder of when each action ran
+///
+/// ActionManager writes a begin event before each action's loop() and an
+/// end event, with the delay the action asked for, after it.  Events are
+/// 12 bytes and go in a ring that's allocated once, so recording is a few
+/// stores; when the ring is full the oldest events are overwritten.
+///
+/// save() writes the ring as a compact binary log.  The simulator turns
+/// the log into a Chrome trace (see trace_json.h) to show how the actions
+/// interleave.  Times are the low 32 bits of ActionManager's clock; the
+/// log spans far less than the 71 minutes they take to wrap.
+///
+class TraceLog
+{
+  public:
+
+  enum class Type : uint8_t {
+    BEGIN,          ///< The action is about to run
+    END             ///< The action returned.  delayUs is what it asked for
+  };
+
+  struct Event {
+    uint32_t timeUs;
+    uint32_t delayUs;
+    uint16_t action;
+    Type type;
+    uint8_t reserved;
+  };
+
+  static constexpr uint32_t magic = 0x52544642;   // "BFTR"
+  static constexpr uint16_t version = 1;
+
+  ///
+  /// @brief Constructor
+  ///
+  /// @param[in] capacity - Number of events kept
+  ///
+  explicit TraceLog( std::size_t capacity );
+
+  /// @brief Name an action.  name must outlive the log.
+  void setName( uint16_t action, const char* name );
+
+  void begin( uint16_t action, uint64_t timeUs )
+  {
+    record( Event{ (uint32_t) timeUs, 0, action, Type::BEGIN, 0 } );
+  }
+
+  void end( uint16_t action, uint64_t timeUs, unsigned int delayUs )
+  {
+    record( Event{ (uint32_t) timeUs, delayUs, action, Type::END, 0 } );
+  }
+
+  /// @brief Forget every event
+  void clear() { first = 0; count = 0; }
+
+  /// @brief Number of events held
+  std::size_t size() const { return count; }
+
+  /// @brief Number of events overwritten since construction
+  unsigned int getDropped() const { return dropped; }
+
+  /// @brief An event, 0 being the oldest held
+  const Event& operator[]( std::size_t i ) const
+  {
+    return ring[ ( first + i ) % ring.size() ];
+  }
+
+  /// @brief Write the action names and events, oldest first
+  void save( SnapshotWriter& out ) const;
+
+  ///
+  /// @brief Read a log written by save()
+  ///
+  /// @param[in]  in     - The log
+  /// @param[out] names  - The name of each action, by action number
+  /// @param[out] events - The events, oldest first
+  /// @return false if the log is bad
+  ///
+  static bool load( SnapshotReader& in, std::vector< std::string >& names,
+    std::vector< Event >& events );
+
+  private:
+
+  void record( const Event& e )
+  {
+    if ( count < ring.size() )
+    {
+      ring[ ( first + count ) % ring.size() ] = e;
+      ++count;
+      return;
+    }
+    ring[ first ] = e;
+    first = ( first + 1 ) % ring.size();
+    ++dropped;
+  }
+
+  std::vector< Event > ring;
+  std::vector< const char* > names;
+  std::size_t first;
+  std::size_t count;
+  unsigned int dropped;
+};
+
+#endif
+
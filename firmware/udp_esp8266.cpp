@@ -0,0 +1,43 @@
+#include <ESP8266WiFi.h>
+#include "udp_esp8266.h"
+
+constexpr uint32_t UdpESP8266::lookupTimeoutMs;
+
+UdpESP8266::UdpESP8266( uint16_t localPortArg )
+{
+  udp.begin( localPortArg );
+}
+
+bool UdpESP8266::resolve( const char* host, BeeFocus::IpAddress& address )
+{
+  IPAddress ip;
+  if ( !WiFi.hostByName( host, ip, lookupTimeoutMs ) ) {
+    return false;
+  }
+  for ( unsigned int i = 0; i < address.size(); ++i ) {
+    address[i] = ip[i];
+  }
+  return true;
+}
+
+bool UdpESP8266::send( const BeeFocus::IpAddress& address, uint16_t port,
+  const uint8_t* data, std::size_t size )
+{
+  const IPAddress ip( address[0], address[1], address[2], address[3] );
+  return udp.beginPacket( ip, port ) &&
+         udp.write( data, size ) == size &&
+         udp.endPacket();
+}
+
+std::size_t UdpESP8266::receive( uint8_t* data, std::size_t capacity )
+{
+  const int size = udp.parsePacket();
+  if ( size <= 0 ) {
+    return 0;
+  }
+  // Whatever doesn't fit is dropped with the packet
+  const int read = udp.read( data, capacity );
+  udp.flush();
+  return read > 0 ? read : 0;
+}
+
@@ -0,0 +1,33 @@
+#ifndef __UDP_ESP8266_H__
+#define __UDP_ESP8266_H__
+
+#include <WiFiUdp.h>
+#include "udp_interface.h"
+
+///
+/// @brief UDP over the ESP8266's Wifi
+///
+/// WiFiUDP only ever looks at packets that have already arrived, so send
+/// and receive don't wait.  resolve waits for DNS, but at most
+/// lookupTimeoutMs.
+///
+class UdpESP8266: public UdpInterface {
+  public:
+
+  /// @brief Longest resolve() waits for a DNS reply
+  static constexpr uint32_t lookupTimeoutMs = 250;
+
+  UdpESP8266( uint16_t localPortArg );
+
+  bool resolve( const char* host, BeeFocus::IpAddress& address ) override;
+  bool send( const BeeFocus::IpAddress& address, uint16_t port,
+    const uint8_t* data, std::size_t size ) override;
+  std::size_t receive( uint8_t* data, std::size_t capacity ) override;
+
+  private:
+
+  WiFiUDP udp;
+};
+
+#endif
+
@@ -0,0 +1,43 @@
+#ifndef __UDP_INTERFACE_H__
+#define __UDP_INTERFACE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include "basic_types.h"
+
+///
+/// @brief A UDP socket that never waits for the network
+///
+/// On the device this is a WiFiUDP; on the host, a non-blocking socket.
+///
+class UdpInterface
+{
+  public:
+
+  virtual ~UdpInterface() {}
+
+  ///
+  /// @brief Look up a host name
+  ///
+  /// The one call that may wait (briefly, on the device), so callers
+  /// cache the answer.
+  ///
+  /// @return false if the name couldn't be found
+  ///
+  virtual bool resolve( const char* host, BeeFocus::IpAddress& address ) = 0;
+
+  /// @brief Send a datagram.  @return false if it couldn't be sent
+  virtual bool send( const BeeFocus::IpAddress& address, uint16_t port,
+    const uint8_t* data, std::size_t size ) = 0;
+
+  ///
+  /// @brief Read a datagram that has arrived
+  ///
+  /// @return The datagram's size, or 0 if nothing is waiting.  Datagrams
+  ///         longer than capacity are truncated.
+  ///
+  virtual std::size_t receive( uint8_t* data, std::size_t capacity ) = 0;
+};
+
+#endif
+
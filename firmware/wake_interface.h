@@ -0,0 +1,33 @@
+#ifndef __WAKE_INTERFACE_H__
+#define __WAKE_INTERFACE_H__
+
+///
+/// @brief Sleeps until input arrives or a timeout passes
+///
+/// ActionManager::waitUs uses this between loop() calls, so actions
+/// waiting on the network run as soon as a command comes in rather than
+/// on their next poll.  In the simulator it's select() on stdin; on the
+/// device it watches the Wifi server and clients.
+///
+class WakeInterface
+{
+  public:
+
+  virtual ~WakeInterface() {}
+
+  /// @brief Is there input that hasn't been read yet?
+  virtual bool hasInput() = 0;
+
+  ///
+  /// @brief Sleep for timeoutUs, or until there's input
+  ///
+  /// @param[in] timeoutUs   - Longest sleep
+  /// @param[in] wakeOnInput - If false, ignore input and sleep the
+  ///                          whole time
+  /// @return true if woken by input, false if the timeout passed
+  ///
+  virtual bool waitUs( unsigned int timeoutUs, bool wakeOnInput ) = 0;
+};
+
+#endif
+
@@ -1,9 +1,16 @@
 
 #include <iostream>
+#include <fstream>
 #include <memory>
+#include <string.h>
 #include <unistd.h>
 #include <time.h>
 #include <math.h>   // for adding variation to simulated temperature.
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <iterator>
+#include <vector>
 
 #include "temperature_interface.h"
 #include "data_mover.h"
@@ -12,6 +19,17 @@
 #include "action_manager.h"
 #include "time_interface.h"
 #include "time_manager.h"
+#include "clock_interface.h"
+#include "sample_timer_interface.h"
+#include "sound_sampler.h"
+#include "state_saver.h"
+#include "storage_file.h"
+#include "trace_json.h"
+#include "telemetry_decode.h"
+#include "idle_policy.h"
+#include "power_sim.h"
+#include "wake_interface.h"
+#include "line_framer.h"
 
 std::shared_ptr<ActionManager> action_manager;
 
@@ -24,11 +42,33 @@ class TimeInterfaceSim: public TimeInterface {
 
   unsigned int msSinceDeviceStart() override {
     timespec t;
-    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t );
+    clock_gettime(CLOCK_MONOTONIC, &t );
     const unsigned int msFromS  = t.tv_sec * 1000;
     const unsigned int msFromNs = t.tv_nsec / 1000000;
     return msFromS + msFromNs; 
   }
+
+  uint64_t msSince1970() override {
+    timespec t;
+    clock_gettime(CLOCK_REALTIME, &t );
+    return uint64_t( t.tv_sec ) * 1000 + t.tv_nsec / 1000000;
+  }
+
+  // The host's clock is already disciplined, so it's good to a ms
+  bool getSample( TimeSample& sample ) override {
+    sample = TimeSample{ msSinceDeviceStart(), msSince1970(), 1 };
+    return true;
+  }
+};
+
+class ClockSim: public ClockInterface {
+  public:
+
+  uint32_t microsSinceDeviceStart() override {
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return (uint32_t) duration_cast<microseconds>( steady_clock::now() - start ).count();
+  }
 };
 
 class NetConnectionSim: public NetConnection {
@@ -54,34 +94,50 @@ class NetConnectionSim: public NetConnection {
   }
 };
 
-class NetInterfaceSim: public NetInterface {
+///
+/// @brief Commands come from stdin
+///
+/// waitUs() blocks in select() until a line is typed, so commands are
+/// answered at once.  At the end of piped input stdin reads as ready
+/// forever, so from then on it's ignored.
+///
+class NetInterfaceSim: public NetInterface, public WakeInterface {
   public:
 
   struct category: virtual beefocus_tag {};
   using char_type = char;
 
-  NetInterfaceSim( std::shared_ptr<DebugInterface> debugLog )
+  NetInterfaceSim( std::shared_ptr<DebugInterface> debugLog ) : stdinOpen{ true }
   {
     (*debugLog) << "Simulator Net Interface Init\n";
   }
   bool getString( std::string& input ) override
   {
-    fd_set readfds;
-    FD_ZERO(&readfds);
-
-    struct timeval timeout;
-    timeout.tv_sec = 0;
-    timeout.tv_usec = 0;
-
-    FD_SET(STDIN_FILENO, &readfds );
-    if ( select(1, &readfds, nullptr, nullptr, &timeout ))
+    readStdin();
+    LineView line;
+    if ( incoming.nextLine( line ) )
     {
-      std::cin >> input;
+      input.assign( line.data, line.size );
       return true;
     }
     input = "";
     return false;
   }
+  bool hasInput() override
+  {
+    return incoming.hasLine() || stdinReady( 0 );
+  }
+  bool waitUs( unsigned int timeoutUs, bool wakeOnInput ) override
+  {
+    if ( wakeOnInput && incoming.hasLine() ) {
+      return true;
+    }
+    if ( wakeOnInput && stdinOpen ) {
+      return stdinReady( timeoutUs );
+    }
+    usleep( timeoutUs );
+    return false;
+  }
   std::streamsize write( const char_type* s, std::streamsize n ) override
   {
     for ( std::streamsize i = 0; i < n; ++i ) {
@@ -100,6 +156,48 @@ class NetInterfaceSim: public NetInterface {
   {
     return std::unique_ptr<NetConnection>(new NetConnectionSim());  
   }
+
+  private:
+
+  /// @brief Read whatever stdin has, without blocking, into the framer
+  void readStdin()
+  {
+    while ( stdinReady( 0 ) )
+    {
+      std::size_t space;
+      char* to = incoming.writeSpace( space );
+      if ( space == 0 ) {
+        return;
+      }
+      const ssize_t got = read( STDIN_FILENO, to, space );
+      if ( got <= 0 )
+      {
+        stdinOpen = false;
+        return;
+      }
+      incoming.commit( got );
+    }
+  }
+
+  /// @brief Wait up to timeoutUs for stdin to have something to read
+  bool stdinReady( unsigned int timeoutUs )
+  {
+    if ( !stdinOpen ) {
+      return false;
+    }
+    fd_set readfds;
+    FD_ZERO(&readfds);
+    FD_SET(STDIN_FILENO, &readfds );
+
+    struct timeval timeout;
+    timeout.tv_sec = timeoutUs / 1000000;
+    timeout.tv_usec = timeoutUs % 1000000;
+    return select( STDIN_FILENO + 1, &readfds, nullptr, nullptr, &timeout ) > 0;
+  }
+
+  LineFramer< 256 > incoming;
+  /// @brief False once stdin reaches end of file
+  bool stdinOpen;
 };
 
 class HWISim: public HWI
@@ -108,18 +206,18 @@ class HWISim: public HWI
 
   void PinMode( Pin pin, PinIOMode mode ) override
   {
-    std::cout << "PM (" << HWI::pinNames.at(pin) << ") = " << HWI::pinIOModeNames.at(mode) << "\n";
+    std::cout << "PM (" << HWI::pinNames[ pin ] << ") = " << HWI::pinIOModeNames[ mode ] << "\n";
   }
   void DigitalWrite( Pin pin, PinState state ) override
   {
-    const std::string name = HWI::pinNames.at(pin);
-    std::cout << "DW (" << HWI::pinNames.at(pin) 
-              << ") = " << HWI::pinStateNames.at( state ) 
+    const std::string name = HWI::pinNames[ pin ];
+    std::cout << "DW (" << HWI::pinNames[ pin ] 
+              << ") = " << HWI::pinStateNames[ state ] 
               << "\n";
   }
   PinState DigitalRead( Pin pin ) override
   {
-    std::cout << "DR " << HWI::pinNames.at(pin) << " returning HOME_INACTIVE";
+    std::cout << "DR " << HWI::pinNames[ pin ] << " returning HOME_INACTIVE";
     return HWI::PinState::DUMMY_INACTIVE;
   }
   unsigned AnalogRead( Pin pin ) override
@@ -131,6 +229,65 @@ class HWISim: public HWI
 
     return 200 + count_amp;
   }
+  void AnalogReadBurst( Pin pin, unsigned short* buffer,
+    std::size_t count, unsigned int intervalUs ) override
+  {
+    for ( std::size_t i = 0; i < count; ++i ) {
+      buffer[i] = AnalogRead( pin );
+    }
+    // The device blocks for the whole burst, so do the same here.
+    usleep( count * intervalUs );
+  }
+};
+
+///
+/// @brief Fixed rate timer using a dedicated thread
+///
+/// Stands in for the device's timer interrupt.  The thread sleeps until
+/// an absolute deadline each time, so the rate doesn't drift, and then
+/// reads the microphone into the ring.
+///
+class SampleTimerSim: public SampleTimerInterface
+{
+  public:
+
+  explicit SampleTimerSim( std::shared_ptr<HWI> hardwareArg ) :
+    hardware{ hardwareArg }
+  {
+  }
+
+  ~SampleTimerSim()
+  {
+    stop();
+  }
+
+  void start( unsigned int intervalUs, SampleRing& ring ) override
+  {
+    stop();
+    running = true;
+    thread = std::thread( [=, &ring] {
+      auto next = std::chrono::steady_clock::now();
+      while ( running )
+      {
+        ring.push( hardware->AnalogRead( HWI::Pin::MICROPHONE ));
+        next += std::chrono::microseconds( intervalUs );
+        std::this_thread::sleep_until( next );
+      }
+    });
+  }
+
+  void stop() override
+  {
+    running = false;
+    if ( thread.joinable() ) {
+      thread.join();
+    }
+  }
+
+  private:
+  std::shared_ptr<HWI> hardware;
+  std::atomic<bool> running{ false };
+  std::thread thread;
 };
 
 class TempSim: public TempInterface {
@@ -174,23 +331,96 @@ void setup() {
   auto timeSim   = std::make_shared<TimeInterfaceSim>();
   auto time      = std::make_shared<TimeManager>( timeSim );
   auto temp      = std::make_shared<TempSim>();
-  //auto sound     = std::make_shared<FS::SSound>( wifi, hardware, debug, time );
-  auto datamover = std::make_shared<DataMover>( "sim", temp, wifi );
+  auto timer     = std::make_shared<SampleTimerSim>( hardware );
+  auto sampler   = std::make_shared<SoundSampler>( timer );
+  auto sound     = std::make_shared<FS::SSound>( wifi, hardware, debug, time,
+                      FS::SampleMode::TIMER, sampler );
+  // Small frames, so a short run has some to decode (see --telemetry)
+  auto datamover = std::make_shared<DataMover>( "sim", temp, wifi, time, 5 );
+  auto storage   = std::make_shared<StorageFile>( "firmware_sim_snapshot.bin" );
+  auto saver     = std::make_shared<StateSaver>( storage, debug,
+                      std::vector<std::shared_ptr<PersistentInterface>>{ time, sound } );
 
-  action_manager = std::make_shared<ActionManager>( wifi, hardware, debug );
-  //action_manager->addAction( sound );
-  action_manager->addAction( time );
-  action_manager->addAction( datamover );
+  // Pick up where we left off before the last reboot.
+  saver->restore();
+
+  auto clock     = std::make_shared<ClockSim>();
+  action_manager = std::make_shared<ActionManager>( wifi, hardware, debug, clock );
+  const auto soundId = action_manager->addAction( sound );
+  action_manager->addAction( time, ActionManager::Schedule::FIXED_RATE );
+  action_manager->addAction( datamover, ActionManager::Schedule::FIXED_RATE );
   action_manager->addAction( wifi );
+  action_manager->addAction( saver );
+  action_manager->setTraceLog( std::make_shared<TraceLog>( 4096 ));
+  action_manager->setWakeSource( wifi );
+  action_manager->wakeOnInput( soundId );
+  action_manager->setIdlePolicy(
+    std::make_shared<BreakEvenPolicy>( BreakEvenPolicy::esp8266, 5000 ),
+    std::make_shared<PowerSim>( BreakEvenPolicy::esp8266, clock ));
+  sound->setStatsReporter( action_manager );
+}
+
+///
+/// @brief Convert a trace command's output to Chrome trace JSON
+///
+/// @param[in] capturePath - Saved output of the device or the simulator
+/// @param[in] jsonPath    - Where the JSON goes
+/// @return The exit status
+///
+int convertTrace( const char* capturePath, const char* jsonPath )
+{
+  std::ifstream capture( capturePath );
+  std::vector< uint8_t > bytes;
+  if ( !readTraceDump( capture, bytes ))
+  {
+    std::cerr << "No trace dump in " << capturePath << "\n";
+    return 1;
+  }
+  SnapshotReader reader( bytes.data(), bytes.size() );
+  std::vector< std::string > names;
+  std::vector< TraceLog::Event > events;
+  if ( !TraceLog::load( reader, names, events ))
+  {
+    std::cerr << "Bad trace dump in " << capturePath << "\n";
+    return 1;
+  }
+  std::ofstream json( jsonPath );
+  writeChromeTrace( json, names, events );
+  std::cout << events.size() << " events written to " << jsonPath << "\n";
+  return json ? 0 : 1;
+}
+
+///
+/// @brief Print the telemetry frames in the device's or simulator's output
+///
+/// @param[in] capturePath - Saved output
+/// @return The exit status; 1 if there were no frames, or bad ones
+///
+int decodeTelemetry( const char* capturePath )
+{
+  std::ifstream in( capturePath, std::ios::binary );
+  const std::vector< uint8_t > capture{ std::istreambuf_iterator< char >( in ),
+    std::istreambuf_iterator< char >() };
+  std::vector< TelemetryReading > readings;
+  const TelemetryScan scan = findTelemetryFrames( capture, readings );
+  writeTelemetry( std::cout, readings );
+  std::cerr << scan.frames << " frames, " << readings.size() << " readings, "
+            << scan.badFrames << " bad frames in " << capturePath << "\n";
+  return scan.frames && !scan.badFrames ? 0 : 1;
 }
 
 int main(int argc, char* argv[])
 {
+  if ( argc == 4 && strcmp( argv[1], "--trace-json" ) == 0 ) {
+    return convertTrace( argv[2], argv[3] );
+  }
+  if ( argc == 3 && strcmp( argv[1], "--telemetry" ) == 0 ) {
+    return decodeTelemetry( argv[2] );
+  }
   setup();
   for ( ;; ) 
   {
-    unsigned int delay = loop();
-    usleep( delay );
+    action_manager->waitUs( loop() );
   }
 }
 
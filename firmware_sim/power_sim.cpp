@@ -0,0 +1,60 @@
+#include "power_sim.h"
+#include "net_interface.h"
+
+PowerSim::PowerSim( const SleepStates& statesArg,
+  std::shared_ptr<ClockInterface> clockArg ) :
+  states{ statesArg }, clock{ clockArg }, depth{ SleepDepth::AWAKE },
+  since{ clock.nowUs() }, energyNj{ 0 }
+{
+  timeUs.fill( 0 );
+}
+
+void PowerSim::account()
+{
+  const uint64_t now = clock.nowUs();
+  const uint64_t elapsed = now - since;
+  since = now;
+  timeUs[ (std::size_t) depth ] += elapsed;
+  // uW * us is pJ
+  energyNj += elapsed * states[ (std::size_t) depth ].powerUw / 1000;
+}
+
+void PowerSim::setSleepDepth( SleepDepth newDepth )
+{
+  account();
+  if ( newDepth != depth && newDepth != SleepDepth::AWAKE ) {
+    energyNj += uint64_t( states[ (std::size_t) newDepth ].transitionUj ) * 1000;
+  }
+  depth = newDepth;
+}
+
+uint64_t PowerSim::getEnergyUj()
+{
+  account();
+  return energyNj / 1000;
+}
+
+uint64_t PowerSim::getAwakeEnergyUj()
+{
+  account();
+  uint64_t total = 0;
+  for ( auto t : timeUs ) {
+    total += t;
+  }
+  return total * states[ (std::size_t) SleepDepth::AWAKE ].powerUw / 1000000;
+}
+
+uint64_t PowerSim::getTimeUs( SleepDepth d )
+{
+  account();
+  return timeUs[ (std::size_t) d ];
+}
+
+void PowerSim::reportEnergy( NetInterface& out )
+{
+  const uint64_t used = getEnergyUj();
+  const uint64_t awake = getAwakeEnergyUj();
+  out << "energy mJ      " << (unsigned int) ( used / 1000 )
+      << " (always awake " << (unsigned int) ( awake / 1000 ) << ")\n";
+}
+
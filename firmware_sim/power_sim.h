@@ -0,0 +1,57 @@
+#ifndef __POWER_SIM_H__
+#define __POWER_SIM_H__
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include "clock_interface.h"
+#include "monotonic_clock.h"
+#include "power_interface.h"
+
+///
+/// @brief Pretends to sleep and adds up the energy it would have used
+///
+/// Time in each depth is charged at that depth's power, and every trip
+/// out of AWAKE costs its transition energy.  The report compares the
+/// total with staying awake the whole time.
+///
+class PowerSim : public PowerInterface
+{
+  public:
+
+  ///
+  /// @brief Constructor
+  ///
+  /// @param[in] statesArg - The cost of each depth
+  /// @param[in] clockArg  - The clock time is measured with
+  ///
+  PowerSim( const SleepStates& statesArg, std::shared_ptr<ClockInterface> clockArg );
+
+  void setSleepDepth( SleepDepth depth ) override;
+  void reportEnergy( NetInterface& out ) override;
+
+  /// @brief Energy used so far, in uJ
+  uint64_t getEnergyUj();
+
+  /// @brief Energy staying awake would have used, in uJ
+  uint64_t getAwakeEnergyUj();
+
+  /// @brief Time spent in a depth so far
+  uint64_t getTimeUs( SleepDepth depth );
+
+  private:
+
+  /// @brief Charge for the time since the last call
+  void account();
+
+  const SleepStates states;
+  MonotonicClock clock;
+  SleepDepth depth;
+  uint64_t since;
+  /// @brief Energy in nJ, so short stays aren't rounded away
+  uint64_t energyNj;
+  std::array< uint64_t, (std::size_t) SleepDepth::END_OF_DEPTHS > timeUs;
+};
+
+#endif
+
@@ -0,0 +1,56 @@
+#include "storage_file.h"
+
+StorageFile::StorageFile( const std::string& pathArg ) : path{ pathArg }
+{
+}
+
+bool StorageFile::open()
+{
+  if ( file.is_open() ) {
+    return true;
+  }
+  const auto mode = std::ios::in | std::ios::out | std::ios::binary;
+  file.open( path, mode );
+  if ( !file.is_open() )
+  {
+    // Doesn't exist yet.  Create it, then reopen for update.
+    std::ofstream create( path, std::ios::binary );
+    create.close();
+    file.open( path, mode );
+  }
+  return file.is_open();
+}
+
+bool StorageFile::read( std::size_t offset, uint8_t* data, std::size_t count )
+{
+  if ( !open() ) {
+    return false;
+  }
+  file.clear();
+  file.seekg( offset );
+  file.read( reinterpret_cast< char* >( data ), count );
+  const bool ok = (std::size_t) file.gcount() == count;
+  file.clear();
+  return ok;
+}
+
+bool StorageFile::write( std::size_t offset, const uint8_t* data, std::size_t count )
+{
+  if ( !open() ) {
+    return false;
+  }
+  file.clear();
+  file.seekp( offset );
+  file.write( reinterpret_cast< const char* >( data ), count );
+  return file.good();
+}
+
+bool StorageFile::commit()
+{
+  if ( !open() ) {
+    return false;
+  }
+  file.flush();
+  return file.good();
+}
+
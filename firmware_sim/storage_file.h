@@ -0,0 +1,34 @@
+#ifndef __STORAGE_FILE_H__
+#define __STORAGE_FILE_H__
+
+#include <fstream>
+#include <string>
+#include "storage_interface.h"
+
+///
+/// @brief Storage in a file on the host, for the simulator and unit tests
+///
+/// The file is created on the first write.  Reads past the end of the
+/// file fail, the same as reading a snapshot that was never written.
+///
+class StorageFile : public StorageInterface
+{
+  public:
+
+  StorageFile( const std::string& pathArg );
+
+  bool read( std::size_t offset, uint8_t* data, std::size_t count ) override;
+  bool write( std::size_t offset, const uint8_t* data, std::size_t count ) override;
+  bool commit() override;
+
+  private:
+
+  /// @brief Open the file for reading and writing, creating it if needed
+  bool open();
+
+  const std::string path;
+  std::fstream file;
+};
+
+#endif
+
@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <iomanip>
+#include "telemetry_decode.h"
+
+namespace {
+
+const char* typeName( TelemetryFrame::Type type )
+{
+  switch ( type )
+  {
+    case TelemetryFrame::Type::TEMPERATURE: return "temperature";
+    case TelemetryFrame::Type::HUMIDITY: return "humidity";
+  }
+  return "unknown";
+}
+
+}
+
+std::size_t decodeTelemetryFrame( const uint8_t* data, std::size_t size,
+  std::vector< TelemetryReading >& readings )
+{
+  constexpr std::size_t overhead = TelemetryFrame::headerSize + TelemetryFrame::crcSize;
+  if ( size < overhead ||
+       data[0] != TelemetryFrame::magic0 || data[1] != TelemetryFrame::magic1 ||
+       data[2] != TelemetryFrame::version ) {
+    return 0;
+  }
+  const std::size_t length = data[4] | ( data[5] << 8 );
+  const std::size_t frameSize = overhead + length;
+  if ( frameSize > size ) {
+    return 0;
+  }
+  const std::size_t crcAt = frameSize - TelemetryFrame::crcSize;
+  const uint16_t crc = (uint16_t) ( data[ crcAt ] | ( data[ crcAt + 1 ] << 8 ));
+  if ( crc != TelemetryFrame::crc16( data, crcAt )) {
+    return 0;
+  }
+
+  const unsigned int count = data[3];
+  uint32_t deviceId = 0;
+  for ( int i = 0; i < 4; ++i ) {
+    deviceId |= (uint32_t) data[ 6 + i ] << ( 8 * i );
+  }
+  uint64_t baseMs = 0;
+  for ( int i = 0; i < 6; ++i ) {
+    baseMs |= (uint64_t) data[ 10 + i ] << ( 8 * i );
+  }
+
+  std::vector< TelemetryReading > frame;
+  std::size_t pos = TelemetryFrame::headerSize;
+  while ( pos < crcAt )
+  {
+    if ( pos + 2 > crcAt || pos + 2 + data[ pos + 1 ] > crcAt ) {
+      return 0;
+    }
+    const uint8_t channelByte = data[ pos ];
+    const std::size_t blockSize = data[ pos + 1 ];
+    SeriesDecoder series( data + pos + 2, blockSize, baseMs );
+    TelemetryReading r{ deviceId, (TelemetryFrame::Type) ( channelByte >> 4 ),
+      (uint8_t) ( channelByte & 0xf ), 0, 0 };
+    for ( std::size_t i = 0; i < series.size(); ++i )
+    {
+      if ( !series.next( r.timeMs, r.value )) {
+        return 0;
+      }
+      frame.push_back( r );
+    }
+    pos += 2 + blockSize;
+  }
+  if ( frame.size() != count ) {
+    return 0;
+  }
+  // Channels are stored one after another; put the readings back in
+  // time order
+  std::stable_sort( frame.begin(), frame.end(),
+    [] ( const TelemetryReading& a, const TelemetryReading& b )
+    {
+      return a.timeMs < b.timeMs;
+    });
+  readings.insert( readings.end(), frame.begin(), frame.end() );
+  return frameSize;
+}
+
+TelemetryScan findTelemetryFrames( const std::vector< uint8_t >& capture,
+  std::vector< TelemetryReading >& readings )
+{
+  TelemetryScan scan{ 0, 0 };
+  std::size_t pos = 0;
+  while ( pos + 1 < capture.size() )
+  {
+    if ( capture[ pos ] != TelemetryFrame::magic0 ||
+         capture[ pos + 1 ] != TelemetryFrame::magic1 )
+    {
+      ++pos;
+      continue;
+    }
+    const std::size_t used = decodeTelemetryFrame( capture.data() + pos,
+      capture.size() - pos, readings );
+    if ( used )
+    {
+      ++scan.frames;
+      pos += used;
+    }
+    else
+    {
+      ++scan.badFrames;
+      ++pos;
+    }
+  }
+  return scan;
+}
+
+void writeTelemetry( std::ostream& out, const std::vector< TelemetryReading >& readings )
+{
+  for ( const TelemetryReading& r : readings )
+  {
+    out << std::hex << std::setw( 8 ) << std::setfill( '0' ) << r.deviceId
+        << std::dec << std::setfill( ' ' )
+        << " " << r.timeMs << " " << typeName( r.type )
+        << " " << (unsigned int) r.channel << " " << r.value << "\n";
+  }
+}
+
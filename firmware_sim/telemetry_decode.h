@@ -0,0 +1,53 @@
+#ifndef __TELEMETRY_DECODE_H__
+#define __TELEMETRY_DECODE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "telemetry_frame.h"
+
+/// @brief One reading from a TelemetryFrame
+struct TelemetryReading
+{
+  uint32_t deviceId;
+  TelemetryFrame::Type type;
+  uint8_t channel;
+  uint64_t timeMs;
+  int32_t value;
+};
+
+///
+/// @brief Decode the frame at the start of data
+///
+/// @param[in]  data     - Where the frame should start
+/// @param[in]  size     - Bytes available at data
+/// @param[out] readings - The frame's readings are added here
+/// @return The frame's size, or 0 if data doesn't start with a whole,
+///         valid frame.  Nothing is added to readings then.
+///
+std::size_t decodeTelemetryFrame( const uint8_t* data, std::size_t size,
+  std::vector< TelemetryReading >& readings );
+
+/// @brief What findTelemetryFrames found
+struct TelemetryScan
+{
+  unsigned int frames;
+  /// @brief Frame headers whose frame was cut short or failed the CRC
+  unsigned int badFrames;
+};
+
+///
+/// @brief Find and decode every frame in captured output
+///
+/// The capture can be anything the device or the simulator printed;
+/// text and damaged frames are skipped.
+///
+TelemetryScan findTelemetryFrames( const std::vector< uint8_t >& capture,
+  std::vector< TelemetryReading >& readings );
+
+/// @brief Print readings, one per line: device, time (ms), type, channel, value
+void writeTelemetry( std::ostream& out, const std::vector< TelemetryReading >& readings );
+
+#endif
+
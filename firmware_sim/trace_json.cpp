@@ -0,0 +1,114 @@
+#include "trace_json.h"
+
+namespace {
+
+int hexDigit( char c )
+{
+  if ( c >= '0' && c <= '9' ) return c - '0';
+  if ( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+  if ( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+  return -1;
+}
+
+/// @brief Write a string as a JSON string literal
+void writeString( std::ostream& out, const std::string& s )
+{
+  out << '"';
+  for ( char c : s )
+  {
+    if ( c == '"' || c == '\\' ) {
+      out << '\\' << c;
+    }
+    else if ( (unsigned char) c < 0x20 ) {
+      out << ' ';
+    }
+    else {
+      out << c;
+    }
+  }
+  out << '"';
+}
+
+}
+
+bool readTraceDump( std::istream& in, std::vector< uint8_t >& bytes )
+{
+  bool found = false;
+  bool inDump = false;
+  std::vector< uint8_t > current;
+  std::string line;
+  while ( std::getline( in, line ))
+  {
+    if ( !line.empty() && line.back() == '\r' ) {
+      line.pop_back();
+    }
+    if ( !inDump )
+    {
+      if ( line.compare( 0, 6, "trace " ) == 0 )
+      {
+        inDump = true;
+        current.clear();
+      }
+      continue;
+    }
+    if ( line == "end trace" )
+    {
+      bytes = current;
+      found = true;
+      inDump = false;
+      continue;
+    }
+    for ( std::size_t i = 0; i + 1 < line.size(); i += 2 )
+    {
+      const int high = hexDigit( line[i] );
+      const int low = hexDigit( line[i + 1] );
+      if ( high < 0 || low < 0 )
+      {
+        // Not part of a dump after all
+        inDump = false;
+        break;
+      }
+      current.push_back( (uint8_t) ( high * 16 + low ));
+    }
+  }
+  return found;
+}
+
+void writeChromeTrace( std::ostream& out,
+  const std::vector< std::string >& names,
+  const std::vector< TraceLog::Event >& events )
+{
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  std::vector< bool > open( names.size(), false );
+  uint64_t time = 0;
+  uint32_t last = events.empty() ? 0 : events.front().timeUs;
+  bool first = true;
+  for ( const TraceLog::Event& e : events )
+  {
+    // Times are 32 bit and may wrap, but only go forward
+    time += (uint32_t) ( e.timeUs - last );
+    last = e.timeUs;
+
+    if ( e.action >= open.size() ) {
+      open.resize( e.action + 1, false );
+    }
+    const bool begin = e.type == TraceLog::Type::BEGIN;
+    if ( !begin && !open[ e.action ] ) {
+      continue;
+    }
+    open[ e.action ] = begin;
+
+    out << ( first ? "\n" : ",\n" ) << "{\"name\":";
+    first = false;
+    writeString( out, e.action < names.size() ? names[ e.action ] :
+      "action " + std::to_string( e.action ));
+    out << ",\"ph\":\"" << ( begin ? "B" : "E" ) << "\",\"ts\":" << time
+        << ",\"pid\":1,\"tid\":1";
+    if ( !begin ) {
+      out << ",\"args\":{\"delayUs\":" << e.delayUs << "}";
+    }
+    out << "}";
+  }
+  out << "\n]}\n";
+}
+
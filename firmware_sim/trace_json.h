@@ -0,0 +1,39 @@
+#ifndef __TRACE_JSON_H__
+#define __TRACE_JSON_H__
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "trace_log.h"
+
+///
+/// @brief Find a trace dump in captured output and decode the hex
+///
+/// The dump is what the trace command prints (see
+/// ActionManager::dumpTrace), so a capture of the device's or the
+/// simulator's output can be read as is.  The last dump in the capture
+/// is used.
+///
+/// @param[in]  in    - The captured output
+/// @param[out] bytes - The binary trace log
+/// @return false if there's no complete dump
+///
+bool readTraceDump( std::istream& in, std::vector< uint8_t >& bytes );
+
+///
+/// @brief Write a trace log as Chrome trace JSON
+///
+/// Each action run is a begin/end pair on one thread, so chrome://tracing
+/// or Perfetto shows the actions interleaving.  End events carry the
+/// delay the action asked for.  Times are relative to the first event.
+/// Ends with no begin, left when the ring overwrote the begin, are
+/// dropped.
+///
+void writeChromeTrace( std::ostream& out,
+  const std::vector< std::string >& names,
+  const std::vector< TraceLog::Event >& events );
+
+#endif
+
@@ -0,0 +1,78 @@
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstring>
+#include "udp_posix.h"
+
+UdpPosix::UdpPosix( uint16_t localPort ) :
+  fd{ socket( AF_INET, SOCK_DGRAM, 0 ) }
+{
+  if ( fd < 0 ) {
+    return;
+  }
+  sockaddr_in local;
+  memset( &local, 0, sizeof( local ));
+  local.sin_family = AF_INET;
+  local.sin_addr.s_addr = htonl( INADDR_ANY );
+  local.sin_port = htons( localPort );
+  if ( bind( fd, (sockaddr*) &local, sizeof( local )) != 0 ||
+       fcntl( fd, F_SETFL, fcntl( fd, F_GETFL ) | O_NONBLOCK ) != 0 )
+  {
+    close( fd );
+    fd = -1;
+  }
+}
+
+UdpPosix::~UdpPosix()
+{
+  if ( fd >= 0 ) {
+    close( fd );
+  }
+}
+
+bool UdpPosix::resolve( const char* host, BeeFocus::IpAddress& address )
+{
+  addrinfo hints;
+  memset( &hints, 0, sizeof( hints ));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  addrinfo* found = nullptr;
+  if ( getaddrinfo( host, nullptr, &hints, &found ) != 0 || !found ) {
+    return false;
+  }
+  const uint32_t ip = ntohl( ((sockaddr_in*) found->ai_addr)->sin_addr.s_addr );
+  freeaddrinfo( found );
+  for ( unsigned int i = 0; i < address.size(); ++i ) {
+    address[i] = ( ip >> ( 24 - 8 * i )) & 0xff;
+  }
+  return true;
+}
+
+bool UdpPosix::send( const BeeFocus::IpAddress& address, uint16_t port,
+  const uint8_t* data, std::size_t size )
+{
+  if ( fd < 0 ) {
+    return false;
+  }
+  sockaddr_in to;
+  memset( &to, 0, sizeof( to ));
+  to.sin_family = AF_INET;
+  to.sin_port = htons( port );
+  to.sin_addr.s_addr = htonl(
+    ( uint32_t( address[0] ) << 24 ) | ( uint32_t( address[1] ) << 16 ) |
+    ( uint32_t( address[2] ) << 8 ) | uint32_t( address[3] ));
+  return sendto( fd, data, size, 0, (sockaddr*) &to, sizeof( to )) == (ssize_t) size;
+}
+
+std::size_t UdpPosix::receive( uint8_t* data, std::size_t capacity )
+{
+  if ( fd < 0 ) {
+    return 0;
+  }
+  const ssize_t size = recv( fd, data, capacity, MSG_DONTWAIT );
+  return size > 0 ? (std::size_t) size : 0;
+}
+
@@ -0,0 +1,38 @@
+#ifndef __UDP_POSIX_H__
+#define __UDP_POSIX_H__
+
+#include "udp_interface.h"
+
+///
+/// @brief A non-blocking UDP socket on the host
+///
+/// For the simulator and the unit tests.  resolve uses getaddrinfo, so
+/// unlike the device it may wait for DNS; names like "localhost" or an
+/// address in dotted form don't.
+///
+class UdpPosix : public UdpInterface
+{
+  public:
+
+  /// @brief Bind to localPort, or to any free port if it's 0
+  explicit UdpPosix( uint16_t localPort = 0 );
+  ~UdpPosix();
+
+  UdpPosix( const UdpPosix& ) = delete;
+  UdpPosix& operator=( const UdpPosix& ) = delete;
+
+  bool resolve( const char* host, BeeFocus::IpAddress& address ) override;
+  bool send( const BeeFocus::IpAddress& address, uint16_t port,
+    const uint8_t* data, std::size_t size ) override;
+  std::size_t receive( uint8_t* data, std::size_t capacity ) override;
+
+  /// @brief false if the socket couldn't be opened
+  bool ok() const { return fd >= 0; }
+
+  private:
+
+  int fd;
+};
+
+#endif
+
@@ -0,0 +1,495 @@
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+
+#include "action_manager.h"
+#include "idle_policy.h"
+#include "wake_interface.h"
+#include "test_mock_clock.h"
+#include "test_mock_debug.h"
+#include "test_mock_hardware.h"
+#include "test_mock_net.h"
+
+namespace {
+
+/// @brief Action that counts its runs and asks for a fixed delay
+class CountingAction : public ActionInterface
+{
+  public:
+  CountingAction( const char* nameArg, unsigned int delayArg ) :
+    name{ nameArg }, delay{ delayArg }, runs{ 0 } {}
+  unsigned int loop() override { ++runs; return delay; }
+  const char* debugName() override { return name; }
+
+  const char* name;
+  unsigned int delay;
+  unsigned int runs;
+};
+
+/// @brief Counting action that does something else each time it runs
+class HookAction : public CountingAction
+{
+  public:
+  HookAction( const char* nameArg, unsigned int delayArg ) :
+    CountingAction( nameArg, delayArg ) {}
+  unsigned int loop() override
+  {
+    if ( hook ) {
+      hook();
+    }
+    return CountingAction::loop();
+  }
+
+  std::function< void() > hook;
+};
+
+std::shared_ptr< ActionManager > makeManager( 
+  std::shared_ptr< ClockInterface > clock = nullptr )
+{
+  return std::make_shared< ActionManager >(
+    std::make_shared< NetMockSimpleTimed >( TimedStringEvents() ),
+    std::make_shared< HWMockTimed >( HWTimedEvents() ),
+    std::make_shared< DebugInterfaceIgnoreMock >(),
+    clock );
+}
+
+/// @brief Action that takes a while to run and asks for a fixed delay
+class BusyAction : public ActionInterface
+{
+  public:
+  BusyAction( std::shared_ptr< ClockMock > clockArg, unsigned int busyArg,
+    unsigned int delayArg ) :
+    clock{ clockArg }, busyUs{ busyArg }, delay{ delayArg } {}
+  unsigned int loop() override
+  {
+    ranAt.push_back( clock->microsSinceDeviceStart() );
+    clock->advanceTime( busyUs );
+    return delay;
+  }
+  const char* debugName() override { return "busy"; }
+
+  std::shared_ptr< ClockMock > clock;
+  unsigned int busyUs;
+  unsigned int delay;
+  std::vector< uint32_t > ranAt;
+};
+
+/// @brief Action that remembers how much of its sleep was cut short
+class WaitingAction : public BusyAction
+{
+  public:
+  using BusyAction::BusyAction;
+  void wokenEarly( unsigned int unusedUs ) override { unused.push_back( unusedUs ); }
+  std::vector< unsigned int > unused;
+};
+
+/// @brief Input arrives at set times on the mock clock
+class WakeMock : public WakeInterface
+{
+  public:
+  WakeMock( std::shared_ptr< ClockMock > clockArg, std::vector< uint32_t > arrivalsArg ) :
+    clock{ clockArg }, arrivals{ arrivalsArg }, waits{ 0 } {}
+
+  bool hasInput() override
+  {
+    return !arrivals.empty() && arrivals.front() <= clock->microsSinceDeviceStart();
+  }
+  bool waitUs( unsigned int timeoutUs, bool wakeOnInput ) override
+  {
+    ++waits;
+    const uint32_t now = clock->microsSinceDeviceStart();
+    if ( wakeOnInput && !arrivals.empty() && arrivals.front() < now + timeoutUs )
+    {
+      clock->advanceTime( arrivals.front() > now ? arrivals.front() - now : 0 );
+      return true;
+    }
+    clock->advanceTime( timeoutUs );
+    return false;
+  }
+  /// @brief An action read the oldest input
+  void consume() { arrivals.erase( arrivals.begin() ); }
+
+  std::shared_ptr< ClockMock > clock;
+  std::vector< uint32_t > arrivals;
+  unsigned int waits;
+};
+
+/// @brief Remembers the sleep depths it was asked for
+class PowerMock : public PowerInterface
+{
+  public:
+  void setSleepDepth( SleepDepth depth ) override { depths.push_back( depth ); }
+  std::vector< SleepDepth > depths;
+};
+
+/// @brief Sleep for as long as the manager asks, like the device's loop
+void runFor( ActionManager& manager, ClockMock& clock, unsigned int loops )
+{
+  for ( unsigned int i = 0; i < loops; ++i ) {
+    clock.advanceTime( manager.loop() );
+  }
+}
+
+/// @brief Loop until a time, oversleeping every wait by oversleepUs
+void runUntil( ActionManager& manager, ClockMock& clock, uint32_t endUs,
+  unsigned int oversleepUs )
+{
+  while ( clock.microsSinceDeviceStart() < endUs ) {
+    clock.advanceTime( manager.loop() + oversleepUs );
+  }
+}
+
+
+}
+
+/// @brief Actions due at the same time run in one loop() call
+TEST( ACTION_MANAGER, should_run_due_actions_as_a_batch )
+{
+  auto manager = makeManager();
+  auto fast = std::make_shared< CountingAction >( "fast", 100 );
+  auto slow = std::make_shared< CountingAction >( "slow", 300 );
+  manager->addAction( fast );
+  manager->addAction( slow );
+
+  ASSERT_EQ( 100u, manager->loop() );
+  ASSERT_EQ( 1u, fast->runs );
+  ASSERT_EQ( 1u, slow->runs );
+  ASSERT_EQ( 100u, manager->loop() );
+  ASSERT_EQ( 100u, manager->loop() );
+  ASSERT_EQ( 100u, manager->loop() );
+  ASSERT_EQ( 4u, fast->runs );
+  ASSERT_EQ( 2u, slow->runs );
+}
+
+/// @brief Cancelled actions stop until they're rescheduled
+TEST( ACTION_MANAGER, should_cancel_and_reschedule_actions )
+{
+  auto manager = makeManager();
+  auto a = std::make_shared< CountingAction >( "a", 100 );
+  auto b = std::make_shared< CountingAction >( "b", 1000 );
+  const auto idA = manager->addAction( a );
+  manager->addAction( b );
+  manager->loop();
+  manager->cancel( idA );
+  ASSERT_EQ( 1000u, manager->loop() );
+  ASSERT_EQ( 1u, a->runs );
+  ASSERT_EQ( 2u, b->runs );
+
+  manager->reschedule( idA, 10 );
+  ASSERT_EQ( 100u, manager->loop() );
+  ASSERT_EQ( 2u, a->runs );
+  ASSERT_EQ( 2u, b->runs );
+}
+
+/// @brief Actions that cancel or reschedule themselves keep that
+TEST( ACTION_MANAGER, should_keep_changes_made_by_the_running_action )
+{
+  auto manager = makeManager();
+  auto a = std::make_shared< HookAction >( "a", 100 );
+  auto b = std::make_shared< CountingAction >( "b", 1000 );
+  const auto idA = manager->addAction( a );
+  manager->addAction( b );
+
+  a->hook = [&] { manager->cancel( idA ); };
+  ASSERT_EQ( 1000u, manager->loop() );
+  ASSERT_EQ( 1000u, manager->loop() );
+  ASSERT_EQ( 1u, a->runs );
+  ASSERT_EQ( 2u, b->runs );
+
+  a->hook = [&] { manager->reschedule( idA, 50 ); };
+  manager->reschedule( idA, 0 );
+  ASSERT_EQ( 50u, manager->loop() );
+  ASSERT_EQ( 2u, a->runs );
+  ASSERT_EQ( 50u, manager->loop() );
+  ASSERT_EQ( 3u, a->runs );
+}
+
+/// @brief An action cancelled or rescheduled earlier in its batch doesn't run
+TEST( ACTION_MANAGER, should_skip_actions_changed_earlier_in_the_batch )
+{
+  auto manager = makeManager();
+  auto a = std::make_shared< HookAction >( "a", 100 );
+  auto b = std::make_shared< CountingAction >( "b", 100 );
+  auto c = std::make_shared< CountingAction >( "c", 100 );
+  manager->addAction( a );
+  const auto idB = manager->addAction( b );
+  const auto idC = manager->addAction( c );
+
+  a->hook = [&] 
+  {
+    manager->cancel( idB );
+    manager->reschedule( idC, 30 );
+  };
+  ASSERT_EQ( 30u, manager->loop() );
+  ASSERT_EQ( 1u, a->runs );
+  ASSERT_EQ( 0u, b->runs );
+  ASSERT_EQ( 0u, c->runs );
+
+  a->hook = nullptr;
+  ASSERT_EQ( 70u, manager->loop() );
+  ASSERT_EQ( 1u, c->runs );
+  ASSERT_EQ( 30u, manager->loop() );
+  ASSERT_EQ( 2u, a->runs );
+  ASSERT_EQ( 0u, b->runs );
+}
+
+/// @brief Actions added from an action run on the next loop()
+TEST( ACTION_MANAGER, should_defer_actions_added_during_a_batch )
+{
+  auto manager = makeManager();
+  auto a = std::make_shared< HookAction >( "a", 100 );
+  auto b = std::make_shared< CountingAction >( "b", 100 );
+  std::vector< std::shared_ptr< CountingAction >> added;
+  manager->addAction( a );
+  manager->addAction( b );
+
+  // Enough to make the manager's list of actions move
+  a->hook = [&] 
+  {
+    for ( int i = 0; i < 20; ++i )
+    {
+      added.push_back( std::make_shared< CountingAction >( "added", 100 ));
+      manager->addAction( added.back() );
+    }
+  };
+  ASSERT_EQ( 0u, manager->loop() );
+  ASSERT_EQ( 1u, a->runs );
+  ASSERT_EQ( 1u, b->runs );
+  ASSERT_EQ( 0u, added.front()->runs );
+  ASSERT_EQ( 1u, manager->getTiming( 0 ).runs );
+
+  a->hook = nullptr;
+  ASSERT_EQ( 100u, manager->loop() );
+  ASSERT_EQ( 1u, added.front()->runs );
+  ASSERT_EQ( 1u, added.back()->runs );
+}
+
+/// @brief Hours of microseconds don't wrap the schedule
+TEST( ACTION_MANAGER, should_not_wrap_after_71_minutes )
+{
+  auto manager = makeManager();
+  const unsigned int hourUs = 3600u * 1000u * 1000u;
+  auto hourly = std::make_shared< CountingAction >( "hourly", hourUs );
+  auto often = std::make_shared< CountingAction >( "often", hourUs / 4 );
+  manager->addAction( hourly );
+  manager->addAction( often );
+  unsigned long long total = 0;
+  while ( total < 3ULL * hourUs )
+  {
+    total += manager->loop();
+  }
+  ASSERT_EQ( 3u, hourly->runs );
+  ASSERT_EQ( 12u, often->runs );
+}
+
+/// @brief Fixed rate actions stay on their grid when wakeups run late
+TEST( ACTION_MANAGER, fixed_rate_should_not_drift )
+{
+  // The device's delay() always oversleeps by 50 us
+  auto rateClock = std::make_shared< ClockMock >();
+  auto rateManager = makeManager( rateClock );
+  auto rate = std::make_shared< BusyAction >( rateClock, 0, 1000000 );
+  const auto rateId = rateManager->addAction( rate, ActionManager::Schedule::FIXED_RATE );
+  runUntil( *rateManager, *rateClock, 99500000, 50 );
+
+  auto delayClock = std::make_shared< ClockMock >();
+  auto delayManager = makeManager( delayClock );
+  auto delay = std::make_shared< BusyAction >( delayClock, 0, 1000000 );
+  delayManager->addAction( delay );
+  runUntil( *delayManager, *delayClock, 99500000, 50 );
+
+  ASSERT_EQ( 100u, rate->ranAt.size() );
+  ASSERT_EQ( 99000050u, rate->ranAt.back() );
+  ASSERT_EQ( 50u, rateManager->getTiming( rateId ).maxLateUs );
+  ASSERT_EQ( 0u, rateManager->getTiming( rateId ).skipped );
+
+  // Fixed delay loses the 50 us every period
+  ASSERT_EQ( 100u, delay->ranAt.size() );
+  ASSERT_EQ( 99u * 1000050u, delay->ranAt.back() );
+}
+
+/// @brief A busy action makes the actions due behind it late
+TEST( ACTION_MANAGER, should_record_lateness )
+{
+  auto clock = std::make_shared< ClockMock >();
+  auto manager = makeManager( clock );
+  auto hog = std::make_shared< BusyAction >( clock, 5000, 10000 );
+  auto victim = std::make_shared< BusyAction >( clock, 0, 10000 );
+  const auto hogId = manager->addAction( hog );
+  const auto victimId = manager->addAction( victim, ActionManager::Schedule::FIXED_RATE );
+
+  runFor( *manager, *clock, 10 );
+  const auto& late = manager->getTiming( victimId );
+  ASSERT_GE( late.runs, 5u );
+  ASSERT_EQ( 5000u, late.lastLateUs );
+  ASSERT_EQ( 5000u, late.maxLateUs );
+  ASSERT_EQ( 5000u * late.runs, late.totalLateUs );
+  ASSERT_EQ( 0u, manager->getTiming( hogId ).maxLateUs );
+}
+
+/// @brief A fixed rate action that falls behind skips, not bursts
+TEST( ACTION_MANAGER, fixed_rate_should_skip_missed_periods )
+{
+  auto clock = std::make_shared< ClockMock >();
+  auto manager = makeManager( clock );
+  auto periodic = std::make_shared< BusyAction >( clock, 0, 1000 );
+  auto stall = std::make_shared< BusyAction >( clock, 3500, 1000000 );
+  const auto id = manager->addAction( periodic, ActionManager::Schedule::FIXED_RATE );
+  manager->addAction( stall );
+
+  manager->loop();
+  runFor( *manager, *clock, 3 );
+  ASSERT_EQ( 2u, manager->getTiming( id ).skipped );
+  const std::vector< uint32_t > golden{ 0, 3500, 4000, 5000 };
+  ASSERT_EQ( golden, periodic->ranAt );
+}
+
+/// @brief Deadlines keep working when the 32 bit counter wraps
+TEST( ACTION_MANAGER, should_run_across_a_clock_wrap )
+{
+  auto clock = std::make_shared< ClockMock >( 0xffffffffu - 2500 );
+  auto manager = makeManager( clock );
+  auto periodic = std::make_shared< BusyAction >( clock, 0, 1000 );
+  const auto id = manager->addAction( periodic, ActionManager::Schedule::FIXED_RATE );
+
+  runFor( *manager, *clock, 6 );
+  const std::vector< uint32_t > golden{ 
+    0xffffffffu - 2500, 0xffffffffu - 1500, 0xffffffffu - 500, 499, 1499, 2499 };
+  ASSERT_EQ( golden, periodic->ranAt );
+  ASSERT_EQ( 0u, manager->getTiming( id ).maxLateUs );
+  ASSERT_GT( manager->getTimeUs(), 0xffffffffULL );
+}
+
+/// @brief A profile keeps the count, extremes and a histogram of run times
+TEST( ACTION_PROFILE, should_track_run_times )
+{
+  ActionProfile< true > p;
+  ASSERT_EQ( 0u, p.getPercentileUs( 50 ));
+  p.record( 10 );
+  p.record( 3 );
+  p.record( 500 );
+  ASSERT_EQ( 3u, p.getCalls() );
+  ASSERT_EQ( 513u, p.getTotalUs() );
+  ASSERT_EQ( 3u, p.getMinUs() );
+  ASSERT_EQ( 500u, p.getMaxUs() );
+  ASSERT_EQ( 8u, p.getPercentileUs( 50 ));
+  ASSERT_EQ( 256u, p.getPercentileUs( 99 ));
+
+  static_assert( std::is_empty< ActionProfile< false >>::value, 
+    "A disabled profile should take no space" );
+  ActionProfile< false > off;
+  off.record( 10 );
+  ASSERT_EQ( 0u, off.getCalls() );
+}
+
+/// @brief The manager profiles each action and its own overhead
+TEST( ACTION_MANAGER, should_profile_actions )
+{
+  auto clock = std::make_shared< ClockMock >();
+  auto manager = makeManager( clock );
+  auto busy = std::make_shared< BusyAction >( clock, 300, 1000 );
+  const auto id = manager->addAction( busy );
+
+  runFor( *manager, *clock, 4 );
+  const auto& p = manager->getProfile( id );
+  ASSERT_EQ( 4u, p.getCalls() );
+  ASSERT_EQ( 1200u, p.getTotalUs() );
+  ASSERT_EQ( 300u, p.getMinUs() );
+  ASSERT_EQ( 300u, p.getMaxUs() );
+  ASSERT_EQ( 4u, manager->getOverhead().getCalls() );
+  ASSERT_EQ( 0u, manager->getOverhead().getMaxUs() );
+
+  NetMockSimpleTimed out( TimedStringEvents{} );
+  manager->reportStats( out );
+  const auto& lines = out.getOutput();
+  ASSERT_EQ( 6u, lines.size() );
+  ASSERT_EQ( 0u, lines[0].event.find( "action" ));
+  ASSERT_EQ( 
+    "busy                  4         1     300     256     256     300         0",
+    lines[1].event );
+  ASSERT_EQ( 0u, lines[2].event.find( "(scheduler)" ));
+  ASSERT_EQ( 0u, lines[3].event.find( "idle awake" ));
+}
+
+/// @brief Input runs a waiting action at once, and it's told what it missed
+TEST( ACTION_MANAGER, should_wake_actions_on_input )
+{
+  auto clock = std::make_shared< ClockMock >();
+  auto manager = makeManager( clock );
+  auto wake = std::make_shared< WakeMock >( clock, std::vector< uint32_t >{ 2500 } );
+  auto listener = std::make_shared< WaitingAction >( clock, 0, 1000000 );
+  auto other = std::make_shared< WaitingAction >( clock, 0, 1000000 );
+  manager->setWakeSource( wake );
+  manager->wakeOnInput( manager->addAction( listener ));
+  manager->addAction( other );
+
+  manager->waitUs( manager->loop() );
+  manager->waitUs( manager->loop() );
+  const std::vector< uint32_t > golden{ 0, 2500 };
+  ASSERT_EQ( golden, listener->ranAt );
+  ASSERT_EQ( std::vector< unsigned int >{ 997500 }, listener->unused );
+  ASSERT_EQ( std::vector< uint32_t >{ 0 }, other->ranAt );
+  ASSERT_TRUE( other->unused.empty() );
+}
+
+/// @brief Input nobody has read yet doesn't wake anyone a second time
+TEST( ACTION_MANAGER, should_wake_once_per_input )
+{
+  auto clock = std::make_shared< ClockMock >();
+  auto manager = makeManager( clock );
+  auto wake = std::make_shared< WakeMock >( clock, std::vector< uint32_t >{ 100, 5000 } );
+  auto listener = std::make_shared< WaitingAction >( clock, 0, 1000 );
+  manager->setWakeSource( wake );
+  manager->wakeOnInput( manager->addAction( listener ));
+
+  // The listener ignores the input at 100 for a while; it gets its
+  // normal 1 ms runs, not a spin.
+  for ( unsigned int i = 0; i < 4; ++i ) {
+    manager->waitUs( manager->loop() );
+  }
+  const std::vector< uint32_t > golden{ 0, 100, 1100, 2100 };
+  ASSERT_EQ( golden, listener->ranAt );
+
+  // Once it's read, the next input wakes the listener again
+  wake->consume();
+  while ( clock->microsSinceDeviceStart() < 5000 ) {
+    manager->waitUs( manager->loop() );
+  }
+  manager->loop();
+  ASSERT_EQ( 5000u, listener->ranAt.back() );
+}
+
+/// @brief Long waits sleep deeply and end in time for the next action
+TEST( ACTION_MANAGER, should_sleep_through_idle_windows )
+{
+  auto clock = std::make_shared< ClockMock >();
+  auto manager = makeManager( clock );
+  auto power = std::make_shared< PowerMock >();
+  manager->setWakeSource( std::make_shared< WakeMock >( clock, std::vector< uint32_t >{} ));
+  manager->setIdlePolicy(
+    std::make_shared< BreakEvenPolicy >( BreakEvenPolicy::esp8266, 5000 ), power );
+  auto pause = std::make_shared< BusyAction >( clock, 0, 3000000 );
+  manager->addAction( pause );
+
+  manager->waitUs( manager->loop() );
+  // Up 3 ms early, light sleep being 3 ms to wake from.  Waking takes no
+  // time on the mock clock, so the rest is slept off less deeply.
+  ASSERT_EQ( 2997000u, clock->microsSinceDeviceStart() );
+  for ( unsigned int i = 0; i < 2; ++i ) {
+    manager->waitUs( manager->loop() );
+  }
+  manager->loop();
+  ASSERT_EQ( ( std::vector< uint32_t >{ 0, 3000000 } ), pause->ranAt );
+  ASSERT_EQ( 0u, manager->getTiming( 0 ).maxLateUs );
+
+  const std::vector< SleepDepth > golden{ SleepDepth::LIGHT, SleepDepth::AWAKE,
+    SleepDepth::MODEM, SleepDepth::AWAKE };
+  ASSERT_EQ( golden, power->depths );
+  ASSERT_EQ( 1u, manager->getIdleTime( SleepDepth::LIGHT ).waits );
+  ASSERT_EQ( 2997000u, manager->getIdleTime( SleepDepth::LIGHT ).totalUs );
+  ASSERT_EQ( 1u, manager->getIdleTime( SleepDepth::MODEM ).waits );
+  ASSERT_EQ( 2000u, manager->getIdleTime( SleepDepth::MODEM ).totalUs );
+  ASSERT_EQ( 1u, manager->getIdleTime( SleepDepth::AWAKE ).waits );
+}
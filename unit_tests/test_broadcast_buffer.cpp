@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "broadcast_buffer.h"
+
+namespace {
+
+using Buffer = BroadcastBuffer< 8, 4, 3 >;
+
+/// @brief Read everything the reader has, up to max bytes
+std::string drain( Buffer& buffer, std::size_t reader, std::size_t max = 1000 )
+{
+  std::string out;
+  const char* data;
+  std::size_t size;
+  while ( out.size() < max && ( size = buffer.peek( reader, data )) > 0 )
+  {
+    size = std::min( size, max - out.size() );
+    out.append( data, size );
+    buffer.consume( reader, size );
+  }
+  return out;
+}
+
+void write( Buffer& buffer, const std::string& s )
+{
+  buffer.write( s.data(), s.size() );
+}
+
+}
+
+/// @brief Nothing is kept with no readers attached
+TEST( BROADCAST_BUFFER, should_drop_output_with_no_readers )
+{
+  Buffer buffer;
+  write( buffer, "nobody is listening" );
+  ASSERT_EQ( 4u, buffer.getFreeSegments() );
+  buffer.attach( 1 );
+  ASSERT_EQ( 0u, buffer.getPending( 1 ));
+  ASSERT_EQ( "", drain( buffer, 1 ));
+  ASSERT_EQ( 4u, buffer.getFreeSegments() );
+}
+
+/// @brief Each reader gets every byte written once it's attached
+TEST( BROADCAST_BUFFER, should_give_every_reader_the_output )
+{
+  Buffer buffer;
+  buffer.attach( 0 );
+  buffer.attach( 2 );
+  write( buffer, "hello " );
+  buffer.attach( 1 );
+  write( buffer, "world" );
+  ASSERT_EQ( 2u, buffer.getFreeSegments() );
+
+  ASSERT_EQ( "hello world", drain( buffer, 0 ));
+  ASSERT_EQ( "world", drain( buffer, 1, 2 ) + drain( buffer, 1 ));
+  ASSERT_EQ( 0u, buffer.getPending( 1 ));
+  ASSERT_EQ( 11u, buffer.getPending( 2 ));
+
+  // The first segment goes back once the last reader is past it
+  ASSERT_EQ( 2u, buffer.getFreeSegments() );
+  ASSERT_EQ( "hello world", drain( buffer, 2 ));
+  ASSERT_EQ( 3u, buffer.getFreeSegments() );
+
+  // Once everyone has caught up the last segment is reused
+  write( buffer, "again" );
+  ASSERT_EQ( 3u, buffer.getFreeSegments() );
+  ASSERT_EQ( "again", drain( buffer, 1 ));
+
+  buffer.detach( 0 );
+  buffer.detach( 1 );
+  buffer.detach( 2 );
+  ASSERT_EQ( 4u, buffer.getFreeSegments() );
+}
+
+/// @brief A reader that falls behind skips ahead; the others don't notice
+TEST( BROADCAST_BUFFER, should_skip_a_slow_reader )
+{
+  Buffer buffer;
+  buffer.attach( 0 );
+  buffer.attach( 1 );
+  const std::string first = "0123456789abcdefghijklmnopqrstu";  // 31 bytes
+  write( buffer, first );
+  ASSERT_EQ( first, drain( buffer, 0 ));
+  ASSERT_EQ( 1u, buffer.getFreeSpace() );
+
+  // Reader 1 hasn't read anything, so once the "v" fills the pool it's
+  // moved to the end
+  write( buffer, "vwxyz" );
+  ASSERT_EQ( "vwxyz", drain( buffer, 0 ));
+  ASSERT_EQ( 32u, buffer.getSkipped( 1 ));
+  ASSERT_EQ( 0u, buffer.getSkipped( 0 ));
+  ASSERT_EQ( "wxyz", drain( buffer, 1 ));
+
+  // Skipped segments went back to the pool; only "wxyz" is left
+  ASSERT_EQ( 3u, buffer.getFreeSegments() );
+}
+
+/// @brief Only readers on the oldest segment skip, not ones just behind
+TEST( BROADCAST_BUFFER, should_only_skip_readers_on_the_oldest_segment )
+{
+  Buffer buffer;
+  buffer.attach( 0 );
+  buffer.attach( 1 );
+  buffer.attach( 2 );
+  write( buffer, "0123456789abcdef" );
+  ASSERT_EQ( "01234567", drain( buffer, 1, 8 ));
+  ASSERT_EQ( "0123456789abcdef", drain( buffer, 2 ));
+  write( buffer, "ghijklmnopqrstuv" );
+  ASSERT_EQ( 0u, buffer.getFreeSegments() );
+
+  // Reader 0 holds the oldest segment and reader 1 the next one.  Once
+  // reader 0 is moved off, the next one is the oldest, but reader 1 
+  // still mustn't skip.
+  write( buffer, "w" );
+  ASSERT_EQ( 32u, buffer.getSkipped( 0 ));
+  ASSERT_EQ( 0u, buffer.getSkipped( 1 ));
+  ASSERT_EQ( 0u, buffer.getSkipped( 2 ));
+  ASSERT_EQ( "w", drain( buffer, 0 ));
+  ASSERT_EQ( "89abcdefghijklmnopqrstuvw", drain( buffer, 1 ));
+  ASSERT_EQ( "ghijklmnopqrstuvw", drain( buffer, 2 ));
+}
+
+/// @brief Detaching a reader frees what only it was holding
+TEST( BROADCAST_BUFFER, should_free_on_detach )
+{
+  Buffer buffer;
+  buffer.attach( 0 );
+  buffer.attach( 1 );
+  write( buffer, "0123456789abcdefghij" );
+  ASSERT_EQ( "0123456789abcdefghij", drain( buffer, 0 ));
+  ASSERT_EQ( 1u, buffer.getFreeSegments() );
+  buffer.detach( 1 );
+  ASSERT_EQ( 3u, buffer.getFreeSegments() );
+  ASSERT_EQ( 0u, buffer.getPending( 1 ));
+  const char* data;
+  ASSERT_EQ( 0u, buffer.peek( 1, data ));
+}
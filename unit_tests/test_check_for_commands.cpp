@@ -42,6 +42,9 @@ TEST( COMMAND_PARSER, checkForCommands)
 
   NetMockSimpleTimed status2("Status with training garbage");
   ASSERT_EQ( checkForCommands(dbgmock, status2), CommandPacket( Command::Status ));
+
+  NetMockSimpleTimed stats("stats");
+  ASSERT_EQ( checkForCommands(dbgmock, stats), CommandPacket( Command::Stats ));
 }
 
 TEST( COMMAND_PARSER, testGot)
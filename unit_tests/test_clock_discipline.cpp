@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+
+#include "clock_discipline.h"
+#include "time_manager.h"
+
+namespace {
+
+constexpr uint64_t startWallMs = 1700000000000ULL;
+
+/// @brief Wall clock time on a device clock that's 100 ppm fast
+uint64_t slowWall( uint64_t deviceMs )
+{
+  return startWallMs + deviceMs - deviceMs / 10000;
+}
+
+/// @brief Time source with 32 bit ms readings, that records what it was asked
+class TimeSampleMock : public TimeInterface
+{
+  public:
+
+  unsigned int secondsSince1970() override { return (unsigned int) ( msSince1970() / 1000 ); }
+  unsigned int msSinceDeviceStart() override { return uint32_t( ms ); }
+  uint64_t msSince1970() override { return slowWall( ms ); }
+
+  bool getSample( TimeSample& sample ) override
+  {
+    ++readings;
+    sample = TimeSample{ uint32_t( ms ), msSince1970(), 5 };
+    return true;
+  }
+
+  void setSyncIntervalMs( unsigned int intervalMs ) override { interval = intervalMs; }
+
+  /// @brief Device time, which the readings wrap every 2^32 ms
+  uint64_t ms = 0;
+  unsigned int readings = 0;
+  unsigned int interval = 0;
+};
+
+}
+
+/// @brief Drift is fitted once the readings span long enough
+TEST( CLOCK_DISCIPLINE, should_estimate_drift )
+{
+  ClockDiscipline discipline;
+  ASSERT_FALSE( discipline.isSynced() );
+  unsigned int deviceMs = 1000;
+  for ( unsigned int i = 0; i < 12; ++i )
+  {
+    // Readings are off by up to 4 ms either way
+    const int noiseMs = ( i % 3 ) * 4 - 4;
+    ASSERT_TRUE( discipline.addSample(
+      TimeSample{ deviceMs, slowWall( deviceMs ) + noiseMs, 10 } ));
+    deviceMs += discipline.getIntervalMs();
+  }
+  ASSERT_NEAR( -100000, discipline.getDriftPpb(), 3000 );
+  // The prediction kept within the target, so readings got further apart
+  ASSERT_GT( discipline.getIntervalMs(), 8 * ClockDiscipline::minIntervalMs );
+
+  // A day on, the time is still within the target
+  const unsigned int later = deviceMs + 24 * 60 * 60 * 1000;
+  ASSERT_NEAR( double( slowWall( later )), double( discipline.wallMs( later )),
+    ClockDiscipline::targetErrorMs );
+}
+
+/// @brief Readings with much slower round trips than the best are dropped
+TEST( CLOCK_DISCIPLINE, should_reject_slow_round_trips )
+{
+  ClockDiscipline discipline;
+  ASSERT_TRUE( discipline.addSample( TimeSample{ 0, startWallMs, 10 } ));
+  ASSERT_TRUE( discipline.addSample( TimeSample{ 64000, startWallMs + 64000, 20 } ));
+  ASSERT_EQ( 2 * ClockDiscipline::minIntervalMs, discipline.getIntervalMs() );
+
+  for ( unsigned int i = 0; i < ClockDiscipline::maxRejectedInARow; ++i )
+  {
+    ASSERT_FALSE( discipline.addSample(
+      TimeSample{ 128000, startWallMs + 128400, 400 } ));
+    // Try again soon
+    ASSERT_EQ( ClockDiscipline::minIntervalMs, discipline.getIntervalMs() );
+  }
+  ASSERT_EQ( startWallMs + 128000, discipline.wallMs( 128000 ));
+
+  // The network may just have got slower, so one gets through in the end
+  ASSERT_TRUE( discipline.addSample( TimeSample{ 128000, startWallMs + 128400, 400 } ));
+  ASSERT_EQ( startWallMs + 128400, discipline.wallMs( 128000 ));
+  ASSERT_EQ( 3u, discipline.getSamples() );
+}
+
+/// @brief Readings to the second leave the drift alone
+TEST( CLOCK_DISCIPLINE, should_not_fit_whole_seconds )
+{
+  ClockDiscipline discipline;
+  unsigned int deviceMs = 0;
+  for ( unsigned int i = 0; i < 12; ++i )
+  {
+    ASSERT_TRUE( discipline.addSample(
+      TimeSample{ deviceMs, slowWall( deviceMs ) / 1000 * 1000, 1000 } ));
+    deviceMs += discipline.getIntervalMs();
+  }
+  ASSERT_EQ( 0, discipline.getDriftPpb() );
+  // Nor do they count as misses until the drift adds up to a second
+  ASSERT_GT( discipline.getIntervalMs(), 32 * ClockDiscipline::minIntervalMs );
+}
+
+/// @brief Device time past 24.8 days is still ahead of the last reading
+TEST( CLOCK_DISCIPLINE, should_keep_time_past_int32_ms )
+{
+  ClockDiscipline discipline;
+  ASSERT_TRUE( discipline.addSample( TimeSample{ 1000, startWallMs, 10 } ));
+  const uint64_t later = 1000 + 30ULL * 24 * 60 * 60 * 1000;
+  ASSERT_EQ( startWallMs + later - 1000, discipline.wallMs( later ));
+}
+
+/// @brief TimeManager reads the base when the discipline wants it to
+TEST( TIME_MANAGER, should_keep_ms_time_between_readings )
+{
+  auto base = std::make_shared< TimeSampleMock >();
+  TimeManager time( base );
+  base->ms = 1500;
+  ASSERT_EQ( slowWall( 1500 ), time.msSince1970() );
+  ASSERT_EQ( 1u, base->readings );
+  ASSERT_EQ( ClockDiscipline::minIntervalMs, base->interval );
+
+  base->ms = 1500 + ClockDiscipline::minIntervalMs - 1;
+  ASSERT_EQ( (unsigned int) ( startWallMs / 1000 ) + 65, time.secondsSince1970() );
+  ASSERT_EQ( 1u, base->readings );
+  base->ms += 1;
+  time.loop();
+  ASSERT_EQ( 2u, base->readings );
+  ASSERT_EQ( 2 * ClockDiscipline::minIntervalMs, base->interval );
+}
+
+
+/// @brief TimeManager keeps time across the base's 49.7 day wrap
+TEST( TIME_MANAGER, should_keep_time_across_device_ms_wrap )
+{
+  auto base = std::make_shared< TimeSampleMock >();
+  TimeManager time( base );
+  base->ms = 1500;
+  time.loop();
+  const uint64_t end = ( 1ULL << 32 ) + 2 * ClockDiscipline::minIntervalMs;
+  while ( base->ms < end )
+  {
+    base->ms += 60 * 60 * 1000;
+    time.loop();
+    ASSERT_NEAR( double( slowWall( base->ms )), double( time.msSince1970() ),
+      ClockDiscipline::targetErrorMs );
+  }
+  ASSERT_LT( base->ms, ( 1ULL << 32 ) * 2 );
+}
@@ -17,7 +17,7 @@ TEST( DEVICE, should_have_complete_pin_names )
        pin < HWI::Pin::END_OF_PINS;
        ++pin )
   {
-    ASSERT_NE(HWI::pinNames.find( pin ), HWI::pinNames.end() );
+    ASSERT_NE( nullptr, HWI::pinNames[ pin ] );
   }
 }
 
@@ -28,7 +28,7 @@ TEST( DEVICE, should_have_complete_pin_state_names )
        pinState < HWI::PinState::END_OF_PIN_STATES;
        ++pinState )
   {
-    ASSERT_NE(HWI::pinStateNames.find( pinState ), HWI::pinStateNames.end() );
+    ASSERT_NE( nullptr, HWI::pinStateNames[ pinState ] );
   }
 }
 
@@ -39,7 +39,7 @@ TEST( DEVICE, should_have_complete_pin_io_modes )
        i < HWI::PinIOMode::END_OF_IO_MODES;
        ++i )
   {
-    ASSERT_NE(HWI::pinIOModeNames.find( i ), HWI::pinIOModeNames.end() );
+    ASSERT_NE( nullptr, HWI::pinIOModeNames[ i ] );
   }
 }
 
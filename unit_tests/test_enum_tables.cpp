@@ -0,0 +1,125 @@
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "hardware_interface.h"
+#include "sample_sound.h"
+
+///
+/// Count what the heap hands out while countBytes is set, so we can see
+/// what building the old unordered_map tables at startup used to cost.
+///
+namespace {
+  bool countBytes = false;
+  std::size_t bytesAllocated = 0;
+  std::size_t allocations = 0;
+}
+
+void* operator new( std::size_t size )
+{
+  if ( countBytes )
+  {
+    bytesAllocated += size;
+    ++allocations;
+  }
+  void* p = std::malloc( size ? size : 1 );
+  if ( !p ) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete( void* p ) noexcept
+{
+  std::free( p );
+}
+
+namespace {
+
+/// @brief Copy an EnumTable into the kind of map it replaced
+template< class E, class T >
+std::unordered_map< E, std::string, EnumHash > asMap( const T& table )
+{
+  std::unordered_map< E, std::string, EnumHash > map;
+  for ( std::size_t i = 0; i < table.size(); ++i )
+  {
+    map.insert( { table.entries[i].key, table.entries[i].value } );
+  }
+  return map;
+}
+
+struct OldCommandTemplate
+{
+  const std::string inputCommand;
+  CommandParser::Command outputCommand;
+};
+
+}
+
+/// @brief The tables are built by the compiler, not by static initializers
+TEST( ENUM_TABLES, should_need_no_static_initialization )
+{
+  static_assert( std::is_trivially_destructible<
+    std::remove_const< decltype( HWI::pinNames ) >::type >::value,
+    "name tables should need no cleanup" );
+  static_assert( std::is_trivially_destructible<
+    std::remove_const< decltype( FS::stateNames ) >::type >::value,
+    "name tables should need no cleanup" );
+  static_assert( std::is_pod<
+    std::remove_const< decltype( HWI::pinNames ) >::type >::value,
+    "name tables should be plain data" );
+}
+
+/// @brief Looking names up never touches the heap
+TEST( ENUM_TABLES, should_not_allocate_on_lookup )
+{
+  bytesAllocated = 0;
+  countBytes = true;
+  const char* name = FS::stateNames[ FS::State::DO_PAUSE ];
+  const char* pin = HWI::pinNames[ HWI::Pin::MICROPHONE ];
+  countBytes = false;
+
+  ASSERT_STREQ( "Collect Sound Histogram Idle", name );
+  ASSERT_STREQ( "Microphone", pin );
+  ASSERT_EQ( 0u, bytesAllocated );
+}
+
+/// @brief Report the startup heap the old unordered_map tables used
+TEST( ENUM_TABLES, should_report_startup_heap_saved )
+{
+  bytesAllocated = 0;
+  allocations = 0;
+  countBytes = true;
+  {
+    auto pins = asMap< HWI::Pin >( HWI::pinNames );
+    auto pinStates = asMap< HWI::PinState >( HWI::pinStateNames );
+    auto pinIOModes = asMap< HWI::PinIOMode >( HWI::pinIOModeNames );
+    auto states = asMap< FS::State >( FS::stateNames );
+    const std::vector< OldCommandTemplate > commands =
+    {
+      { "abort",      CommandParser::Command::Abort },
+      { "status",     CommandParser::Command::Status },
+      { "hreset",     CommandParser::Command::HReset },
+    };
+    std::unordered_map< HWI::Pin, int, EnumHash > pinMap = {
+      { HWI::Pin::MICROPHONE, 17 }
+    };
+    std::unordered_map< HWI::PinState, int, EnumHash > pinStateMap = {
+      { HWI::PinState::DUMMY_INACTIVE, 0 }
+    };
+    countBytes = false;
+    ASSERT_EQ( (std::size_t) FS::State::END_OF_STATES, states.size() );
+  }
+
+  std::cout << "Startup heap saved by constexpr tables: " << bytesAllocated
+            << " bytes in " << allocations << " allocations\n";
+  RecordProperty( "startup_heap_bytes_saved", (int) bytesAllocated );
+  ASSERT_GT( bytesAllocated, 0u );
+}
+
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <vector>
+
 #include "histogram.h"
 
 /// @brief Unsigned integers 
@@ -86,3 +89,155 @@ TEST( HISTOGRAM, should_work_for_floats_2 )
 }
 
 
+/// @brief Power of 2 bins pick the smallest width that covers the range
+TEST( HISTOGRAM, shift_bins )
+{
+  using TestH = Histogram< unsigned int, 10, ShiftBins< unsigned int, 10 >>;
+  TestH h( 100, 200 );
+
+  ASSERT_EQ( 100u, h.getLowerEdge( 0 ));
+  ASSERT_EQ( 116u, h.getLowerEdge( 1 ));   // 16 wide covers 100 in 10 bins
+
+  h.insert( 0 );
+  h.insert( 115 );
+  h.insert( 116 );
+  h.insert( 1000 );
+
+  ASSERT_EQ( 2u, h.getCount( 0 ));
+  ASSERT_EQ( 1u, h.getCount( 1 ));
+  ASSERT_EQ( 1u, h.getCount( 9 ));
+}
+
+/// @brief HDR bins keep the relative width fixed
+TEST( HISTOGRAM, log2_bins )
+{
+  using Bins = Log2Bins< unsigned int, 32, 2 >;
+  Bins bins( 0, 0 );
+
+  // 0-3 are 1 wide, then 4 bins per power of 2
+  ASSERT_EQ( 3u, bins.bin( 3 ));
+  ASSERT_EQ( 4u, bins.bin( 4 ));
+  ASSERT_EQ( 7u, bins.bin( 7 ));
+  ASSERT_EQ( 8u, bins.bin( 8 ));
+  ASSERT_EQ( 8u, bins.bin( 9 ));
+  ASSERT_EQ( 9u, bins.bin( 10 ));
+  ASSERT_EQ( 31u, bins.bin( 1000000 ));
+
+  // Edges round trip, and every bin is at most 1/4 of its lower edge wide
+  for ( unsigned int b = 0; b < 31; ++b )
+  {
+    const unsigned int lo = bins.lowerEdge( b );
+    const unsigned int hi = bins.lowerEdge( b + 1 );
+    ASSERT_EQ( b, bins.bin( lo ));
+    ASSERT_EQ( b, bins.bin( hi - 1 ));
+    ASSERT_LE( hi - lo, lo < 4 ? 1 : lo / 4 );
+  }
+}
+
+/// @brief Edge tables put each sample at or above an edge in the next bin
+TEST( HISTOGRAM, edge_table_bins )
+{
+  using Bins = EdgeTableBins< int, 10, 20, 40, 80 >;
+  using TestH = Histogram< int, 5, Bins >;
+  TestH h;
+
+  for ( int i : { -5, 9, 10, 19, 20, 79, 80, 1000 } )
+  {
+    h.insert( i );
+  }
+
+  TestH::array_t golden = { 25, 25, 12, 12, 26 };
+  TestH::array_t actual;
+  h.get_histogram( actual ); 
+  ASSERT_EQ( golden, actual );
+  ASSERT_EQ( 40, h.getLowerEdge( 3 ));
+}
+
+/// @brief Auto ranging widens the bins instead of clipping
+TEST( HISTOGRAM, auto_range_keeps_counts )
+{
+  using TestH = Histogram< unsigned int, 10, AutoRangeBins< unsigned int, 10 >>;
+  TestH h( 0, 9 );
+
+  for ( unsigned int i = 0; i < 10; ++i )
+  {
+    h.insert( i );
+  }
+  ASSERT_EQ( 1u, h.getLowerEdge( 1 ));
+
+  // Twice the range, so the bins are twice as wide
+  h.insert( 19 );
+  ASSERT_EQ( 2u, h.getLowerEdge( 1 ));
+  for ( unsigned int b = 0; b < 5; ++b )
+  {
+    ASSERT_EQ( 2u, h.getCount( b ));
+  }
+  ASSERT_EQ( 1u, h.getCount( 9 ));
+
+  // Way past the range
+  h.insert( 300 );
+  ASSERT_EQ( 32u, h.getLowerEdge( 1 ));
+  ASSERT_EQ( 11u, h.getCount( 0 ));
+  ASSERT_EQ( 1u, h.getCount( 9 ));
+
+  unsigned int total = 0;
+  for ( unsigned int b = 0; b < 10; ++b )
+  {
+    total += h.getCount( b );
+  }
+  ASSERT_EQ( 12u, total );
+
+  // Reset goes back to the original range
+  h.reset();
+  ASSERT_EQ( 1u, h.getLowerEdge( 1 ));
+}
+
+namespace {
+
+/// @brief ns per insert for a histogram type, on the same pseudo random data
+template< class H >
+double insertNs( H& h, const std::vector< unsigned int >& data )
+{
+  using clock = std::chrono::steady_clock;
+  const unsigned int passes = 50;
+  const auto start = clock::now();
+  for ( unsigned int p = 0; p < passes; ++p )
+  {
+    for ( auto d : data )
+    {
+      h.insert( d );
+    }
+  }
+  return std::chrono::duration<double, std::nano>( 
+    clock::now() - start ).count() / ( passes * data.size() );
+}
+
+}
+
+/// @brief Compare insert cost across bin policies
+TEST( HISTOGRAM_BENCH, insert_cost )
+{
+  std::vector< unsigned int > data;
+  unsigned int lfsr = 0xace1u;
+  for ( unsigned int i = 0; i < 10000; ++i )
+  {
+    lfsr = lfsr * 1103515245u + 12345u;
+    data.push_back(( lfsr >> 16 ) % 64 );
+  }
+
+  Histogram< unsigned int, 32 > linear( 0, 63 );
+  Histogram< unsigned int, 32, ShiftBins< unsigned int, 32 >> shift( 0, 63 );
+  Histogram< unsigned int, 32, Log2Bins< unsigned int, 32 >> log2( 0, 63 );
+  Histogram< unsigned int, 32, AutoRangeBins< unsigned int, 32 >> autoRange( 0, 63 );
+  Histogram< unsigned int, 8, 
+    EdgeTableBins< unsigned int, 2, 4, 8, 16, 24, 32, 48 >> edges;
+
+  std::cout << "linear:     " << insertNs( linear, data ) << " ns/insert\n";
+  std::cout << "shift:      " << insertNs( shift, data ) << " ns/insert\n";
+  std::cout << "log2:       " << insertNs( log2, data ) << " ns/insert\n";
+  std::cout << "auto range: " << insertNs( autoRange, data ) << " ns/insert\n";
+  std::cout << "edge table: " << insertNs( edges, data ) << " ns/insert\n";
+
+  ASSERT_EQ( linear.getCount( 0 ), shift.getCount( 0 ));
+  ASSERT_EQ( shift.getCount( 31 ), autoRange.getCount( 31 ));
+}
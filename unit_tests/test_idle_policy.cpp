@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "idle_policy.h"
+#include "power_sim.h"
+#include "test_mock_clock.h"
+
+/// @brief Each depth is used once the window pays for it
+TEST( IDLE_POLICY, should_pick_the_deepest_depth_that_pays )
+{
+  BreakEvenPolicy policy( BreakEvenPolicy::esp8266, 10000 );
+  // 100 uJ at 181.5 mW saved is 551 us, but waking takes 1 ms
+  ASSERT_EQ( 1000u, policy.getMinWindowUs( SleepDepth::MODEM ));
+  // 1000 uJ at 228.03 mW saved
+  ASSERT_EQ( 4385u, policy.getMinWindowUs( SleepDepth::LIGHT ));
+
+  ASSERT_EQ( SleepDepth::AWAKE, policy.choose( 0 ));
+  ASSERT_EQ( SleepDepth::AWAKE, policy.choose( 999 ));
+  ASSERT_EQ( SleepDepth::MODEM, policy.choose( 1000 ));
+  ASSERT_EQ( SleepDepth::MODEM, policy.choose( 4384 ));
+  ASSERT_EQ( SleepDepth::LIGHT, policy.choose( 4385 ));
+  ASSERT_EQ( SleepDepth::LIGHT, policy.choose( 3000000 ));
+}
+
+/// @brief Depths that are slow to wake from are left alone
+TEST( IDLE_POLICY, should_respect_the_latency_limit )
+{
+  BreakEvenPolicy policy( BreakEvenPolicy::esp8266, 2000 );
+  ASSERT_EQ( SleepDepth::MODEM, policy.choose( 3000000 ));
+
+  BreakEvenPolicy awakeOnly( BreakEvenPolicy::esp8266, 0 );
+  ASSERT_EQ( SleepDepth::AWAKE, awakeOnly.choose( 3000000 ));
+}
+
+/// @brief The simulator charges time at each depth's power
+TEST( POWER_SIM, should_account_energy )
+{
+  auto clock = std::make_shared< ClockMock >();
+  PowerSim power( BreakEvenPolicy::esp8266, clock );
+
+  clock->advanceTime( 1000000 );              // 1 s awake: 231000 uJ
+  power.setSleepDepth( SleepDepth::LIGHT );   // 1000 uJ to go in
+  clock->advanceTime( 2000000 );              // 2 s light: 5940 uJ
+  power.setSleepDepth( SleepDepth::AWAKE );
+
+  ASSERT_EQ( 1000000u, power.getTimeUs( SleepDepth::AWAKE ));
+  ASSERT_EQ( 2000000u, power.getTimeUs( SleepDepth::LIGHT ));
+  ASSERT_EQ( 231000u + 1000u + 5940u, power.getEnergyUj() );
+  ASSERT_EQ( 3u * 231000u, power.getAwakeEnergyUj() );
+}
+
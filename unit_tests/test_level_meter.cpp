@@ -0,0 +1,121 @@
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+#include "level_meter.h"
+
+namespace {
+
+constexpr double pi = 3.14159265358979323846;
+constexpr unsigned int sampleRate = 10000;
+
+/// @brief Feed a sine wave on a 512 DC bias into a meter
+void feedTone( LevelMeter& meter, double hz, double amplitude, std::size_t n )
+{
+  for ( std::size_t i = 0; i < n; ++i )
+  {
+    meter.insert( (unsigned short) std::lround( 
+      512.0 + amplitude * std::sin( 2.0 * pi * hz * i / sampleRate )));
+  }
+}
+
+}
+
+/// @brief A sine wave's mean square is amplitude^2 / 2
+TEST( LEVEL_METER, should_measure_rms )
+{
+  LevelMeter meter( sampleRate );
+  feedTone( meter, 440.0, 100.0, sampleRate );
+  meter.reset();
+  feedTone( meter, 440.0, 100.0, sampleRate );
+
+  ASSERT_NEAR( 5000.0, meter.getLeqMeanSquare(), 100.0 );
+  ASSERT_NEAR( 5000.0, meter.getMeanSquare(), 250.0 );
+  ASSERT_EQ( 37u, meter.getLeqDb() );   // 10 * log10( 5000 )
+  ASSERT_EQ( sampleRate, meter.getCount() );
+}
+
+/// @brief Silence on a DC bias reads as nothing
+TEST( LEVEL_METER, should_ignore_dc )
+{
+  LevelMeter meter( sampleRate );
+  for ( unsigned int i = 0; i < sampleRate; ++i )
+  {
+    meter.insert( 700 );
+  }
+  ASSERT_EQ( 0u, meter.getLeqMeanSquare() );
+  ASSERT_EQ( 0u, meter.getMeanSquare() );
+}
+
+/// @brief The calibration offset is added to levels
+TEST( LEVEL_METER, should_calibrate )
+{
+  LevelMeter meter( sampleRate, LevelMeter::fastMs, false, 50 );
+  feedTone( meter, 440.0, 100.0, sampleRate );
+  ASSERT_EQ( 87u, meter.getLeqDb() );
+}
+
+/// @brief Levels below 0 dB read as 0
+TEST( LEVEL_METER, should_not_go_below_0_db )
+{
+  LevelMeter meter( sampleRate, LevelMeter::fastMs, false, -50 );
+  ASSERT_EQ( 0u, meter.getLeqDb() );
+  feedTone( meter, 440.0, 100.0, sampleRate );
+  ASSERT_EQ( 0u, meter.getLeqDb() );
+  ASSERT_EQ( 0u, meter.getMaxDb() );
+}
+
+/// @brief Fast follows a step within a few time constants, slow lags
+TEST( LEVEL_METER, should_time_weight )
+{
+  LevelMeter fast( sampleRate, LevelMeter::fastMs );
+  LevelMeter slow( sampleRate, LevelMeter::slowMs );
+
+  feedTone( fast, 440.0, 10.0, sampleRate );
+  feedTone( slow, 440.0, 10.0, sampleRate );
+
+  // 500 ms of a much louder tone.  4 time constants for fast, 1/2 for slow
+  feedTone( fast, 440.0, 100.0, sampleRate / 2 );
+  feedTone( slow, 440.0, 100.0, sampleRate / 2 );
+
+  ASSERT_GT( fast.getMeanSquare(), 4500u );
+  ASSERT_LT( slow.getMeanSquare(), 2500u );
+  ASSERT_GT( slow.getMeanSquare(), 1500u );
+}
+
+/// @brief A single spike barely moves the Leq, unlike peak to peak
+TEST( LEVEL_METER, spike_does_not_skew_leq )
+{
+  LevelMeter meter( sampleRate );
+  feedTone( meter, 300.0, 20.0, sampleRate );
+  meter.reset();
+  feedTone( meter, 300.0, 20.0, sampleRate / 2 );
+  meter.insert( 1023 );
+  feedTone( meter, 300.0, 20.0, sampleRate / 2 );
+  ASSERT_NEAR( 200.0, meter.getLeqMeanSquare(), 40.0 );
+}
+
+/// @brief A-weighting follows the standard curve
+TEST( LEVEL_METER, should_a_weight )
+{
+  // Reference values from IEC 61672, in dB
+  const std::vector< std::pair< double, double >> curve = {
+    { 100.0, -19.1 }, { 250.0, -8.6 }, { 1000.0, 0.0 }, { 2000.0, 1.2 } 
+  };
+  for ( const auto& point : curve )
+  {
+    LevelMeter flat( sampleRate, LevelMeter::fastMs, false );
+    LevelMeter weighted( sampleRate, LevelMeter::fastMs, true );
+    feedTone( flat, point.first, 200.0, sampleRate );
+    feedTone( weighted, point.first, 200.0, sampleRate );
+    flat.reset();
+    weighted.reset();
+    feedTone( flat, point.first, 200.0, sampleRate );
+    feedTone( weighted, point.first, 200.0, sampleRate );
+
+    const double gainDb = 10.0 * std::log10( 
+      (double) weighted.getLeqMeanSquare() / flat.getLeqMeanSquare() );
+    EXPECT_NEAR( point.second, gainDb, 1.0 ) << point.first << " Hz";
+  }
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "line_framer.h"
+
+namespace {
+
+std::string str( const LineView& line )
+{
+  return std::string( line.data, line.size );
+}
+
+/// @brief Write a string, through writeSpace/commit like a socket read
+std::size_t readInto( LineFramer< 16 >& framer, const std::string& data )
+{
+  std::size_t space;
+  char* to = framer.writeSpace( space );
+  const std::size_t n = std::min( space, data.size() );
+  memcpy( to, data.data(), n );
+  framer.commit( n );
+  return n;
+}
+
+}
+
+/// @brief Lines split across reads come out whole, "\r\n" or "\n"
+TEST( LINE_FRAMER, should_join_split_lines )
+{
+  LineFramer< 16 > framer;
+  LineView line;
+  ASSERT_EQ( 4u, readInto( framer, "stat" ));
+  ASSERT_FALSE( framer.hasLine() );
+  ASSERT_FALSE( framer.nextLine( line ));
+  ASSERT_EQ( 9u, readInto( framer, "us\r\nhelp\n" ));
+  ASSERT_TRUE( framer.hasLine() );
+  ASSERT_TRUE( framer.nextLine( line ));
+  ASSERT_EQ( "status", str( line ));
+  ASSERT_TRUE( framer.nextLine( line ));
+  ASSERT_EQ( "help", str( line ));
+  ASSERT_FALSE( framer.nextLine( line ));
+
+  // Reaching the end of the buffer moves the unread bytes to the front
+  ASSERT_EQ( 3u, readInto( framer, "\nxy" ));
+  ASSERT_EQ( 13u, readInto( framer, "z\n" ) + readInto( framer, "0123456789a" ));
+  ASSERT_TRUE( framer.nextLine( line ));
+  ASSERT_EQ( "", str( line ));
+  ASSERT_TRUE( framer.nextLine( line ));
+  ASSERT_EQ( "xyz", str( line ));
+  ASSERT_EQ( 4u, framer.write( "bc\nd", 4 ));
+  ASSERT_TRUE( framer.nextLine( line ));
+  ASSERT_EQ( "0123456789abc", str( line ));
+  ASSERT_EQ( 0u, framer.getDroppedLines() );
+}
+
+/// @brief Lines are views into the buffer, not copies
+TEST( LINE_FRAMER, should_return_views_into_the_buffer )
+{
+  LineFramer< 16 > framer;
+  std::size_t space;
+  char* start = framer.writeSpace( space );
+  ASSERT_EQ( 16u, space );
+  ASSERT_EQ( 6u, framer.write( "ab\ncd\n", 6 ));
+  LineView line;
+  ASSERT_TRUE( framer.nextLine( line ));
+  ASSERT_EQ( start, line.data );
+  ASSERT_TRUE( framer.nextLine( line ));
+  ASSERT_EQ( start + 3, line.data );
+  ASSERT_EQ( 2u, line.size );
+}
+
+/// @brief A line too long for the buffer is dropped, up to its newline
+TEST( LINE_FRAMER, should_drop_long_lines )
+{
+  LineFramer< 16 > framer;
+  LineView line;
+  const std::string longLine( 40, 'x' );
+  ASSERT_EQ( 40u, framer.write( longLine.data(), longLine.size() ));
+  ASSERT_FALSE( framer.hasLine() );
+  ASSERT_EQ( 1u, framer.getDroppedLines() );
+  ASSERT_EQ( 7u, framer.write( "xxx\nok\n", 7 ));
+  ASSERT_TRUE( framer.hasLine() );
+  ASSERT_TRUE( framer.nextLine( line ));
+  ASSERT_EQ( "ok", str( line ));
+  ASSERT_FALSE( framer.nextLine( line ));
+  ASSERT_EQ( 1u, framer.getDroppedLines() );
+
+  // The dropped line's end alone isn't a line
+  ASSERT_EQ( 16u, framer.write( longLine.data(), 16 ));
+  ASSERT_EQ( 3u, framer.write( "xx\n", 3 ));
+  ASSERT_FALSE( framer.hasLine() );
+  ASSERT_FALSE( framer.nextLine( line ));
+  ASSERT_EQ( 2u, framer.getDroppedLines() );
+}
+
+/// @brief A buffer full of unread lines takes no more
+TEST( LINE_FRAMER, should_push_back_when_full_of_lines )
+{
+  LineFramer< 16 > framer;
+  const std::string lines = "aaa\nbbb\nccc\nddd\neee\n";
+  ASSERT_EQ( 16u, framer.write( lines.data(), lines.size() ));
+  std::size_t space;
+  framer.writeSpace( space );
+  ASSERT_EQ( 0u, space );
+
+  LineView line;
+  ASSERT_TRUE( framer.nextLine( line ));
+  ASSERT_EQ( "aaa", str( line ));
+  ASSERT_EQ( 4u, framer.write( lines.data() + 16, 4 ));
+  for ( const char* expected : { "bbb", "ccc", "ddd", "eee" } )
+  {
+    ASSERT_TRUE( framer.nextLine( line ));
+    ASSERT_EQ( expected, str( line ));
+  }
+  ASSERT_FALSE( framer.nextLine( line ));
+  ASSERT_EQ( 0u, framer.getDroppedLines() );
+}
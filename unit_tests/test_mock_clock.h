@@ -0,0 +1,47 @@
+///
+/// @brief Testing Mock for the microsecond clock
+/// 
+
+#ifndef __TEST_MOCK_CLOCK_H__
+#define __TEST_MOCK_CLOCK_H__
+
+#include "clock_interface.h"
+
+///
+/// @brief Testing Mock for the microsecond clock
+///
+/// Like the other timed mocks, time only moves when advanceTime is 
+/// called.  The counter wraps at 2^32 like the real one.
+///
+class ClockMock: public ClockInterface
+{
+  public:
+
+  ///
+  /// @brief Constructor
+  ///
+  /// @param[in] startUs - The counter's starting value
+  ///
+  ClockMock( uint32_t startUs = 0 ) : time{ startUs }
+  {
+  }
+
+  uint32_t microsSinceDeviceStart() override
+  {
+    return time;
+  }
+
+  ///
+  /// @brief      Advance time mock by us
+  /// @param[in]  The amount of time by, in us
+  ///
+  void advanceTime( uint32_t us )
+  {
+    time += us;
+  }
+
+  private:
+  uint32_t time;
+};
+
+#endif
@@ -126,14 +126,14 @@ inline std::ostream& operator<<(
   std::ostream& stream, 
   const HWEvent& event) 
 {
-  stream << "{ PIN: " << HWI::pinNames.at( event.getPin() );
+  stream << "{ PIN: " << HWI::pinNames[ event.getPin() ];
   if ( event.isIO() )
   {
-    stream << " IO:    " << HWI::pinStateNames.at(event.getIO() ); 
+    stream << " IO:    " << HWI::pinStateNames[ event.getIO() ]; 
   }
   else
   {
-    stream << " MODE:  " << HWI::pinIOModeNames.at(event.getMode() ); 
+    stream << " MODE:  " << HWI::pinIOModeNames[ event.getMode() ]; 
   }
   stream << " }";
   return stream;
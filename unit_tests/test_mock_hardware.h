@@ -37,11 +37,18 @@ class HWMockTimed: public HWI
   /// @param[in] HWTimedEvents - Simulated Input Events.  A vector of
   ///   input events and they time they take place at.  See 
   ///   HWTimedEvents for examples. 
+  /// @param[in] analogInArg - Simulated analog input.  Each AnalogRead
+  ///   returns the next value, wrapping around at the end.  
   ///
-  HWMockTimed( const HWTimedEvents& hwIn ) : 
+  HWMockTimed( const HWTimedEvents& hwIn,
+               const std::vector<unsigned short>& analogInArg = {} ) : 
       time{ 0 }, 
       inEvents{ hwIn },
-      nextInputEvent{inEvents.begin()}
+      nextInputEvent{inEvents.begin()},
+      analogIn{ analogInArg },
+      nextAnalogIn{ 0 },
+      analogReads{ 0 },
+      burstUs{ 0 }
   {
     // Advance time by 0.  This causes any input events at "time 0"
     // to be processed and recorded in the inputStates map.
@@ -110,6 +117,47 @@ class HWMockTimed: public HWI
     return inputStates.at( pin );
   }
 
+  ///
+  /// @brief Mock AnalogRead hardware interface
+  ///
+  /// @param[in] pin  - The pin being read from (ignored)
+  /// @return         - The next value from the analog input vector, or 0
+  ///                   if no analog input was given.
+  ///
+  unsigned AnalogRead( Pin pin ) override
+  {
+    ++analogReads;
+    if ( analogIn.empty() ) 
+    {
+      return 0;
+    }
+    const unsigned short result = analogIn[ nextAnalogIn ];
+    nextAnalogIn = ( nextAnalogIn + 1 ) % analogIn.size();
+    return result;
+  }
+
+  ///
+  /// @brief Mock AnalogReadBurst hardware interface
+  ///
+  /// Reads count values using AnalogRead.  Time isn't advanced, but the
+  /// time the burst would have taken is added to getBurstUs()
+  ///
+  void AnalogReadBurst( Pin pin, unsigned short* buffer, 
+    std::size_t count, unsigned int intervalUs ) override
+  {
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+      buffer[i] = AnalogRead( pin );
+    }
+    burstUs += count * intervalUs;
+  }
+
+  /// @brief Number of analog reads done, including reads within bursts
+  unsigned int getAnalogReads() const { return analogReads; }
+
+  /// @brief Total time spent in AnalogReadBurst, in us
+  unsigned long long getBurstUs() const { return burstUs; }
+
   ///
   /// @brief Advance simulated time
   ///
@@ -182,6 +230,14 @@ class HWMockTimed: public HWI
   HWTimedEvents::const_iterator nextInputEvent;
   /// @brief  The current state of each input pin.
   std::unordered_map<Pin,PinState,EnumHash> inputStates;
+  /// @brief  Simulated analog input
+  const std::vector<unsigned short> analogIn;
+  /// @brief  Next analog input value to return
+  std::size_t nextAnalogIn;
+  /// @brief  Number of analog reads done
+  unsigned int analogReads;
+  /// @brief  Time spent in bursts
+  unsigned long long burstUs;
 };
 
 #endif
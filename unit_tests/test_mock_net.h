@@ -5,7 +5,9 @@
 #ifndef __TEST_MOCK_NET_H__
 #define __TEST_MOCK_NET_H__
 
+#include <algorithm>
 #include "net_interface.h"
+#include "line_framer.h"
 #include "test_mock_event.h"
 
 /// @brief Dummy mock for net connectins
@@ -117,14 +119,23 @@ class NetMockSimpleTimed: public NetInterface
     // Set the string to a default.
     returnString = "";
 
-    if ( nextInputEvent == inputEvents.end() )
-      return false;   // No more events to process
-    if ( nextInputEvent->time > time )
-      return false;   // Still events, but they haven't occurred yet
+    // Events arrive through the same framer the real interfaces use, one
+    // line at a time.
+    if ( !incoming.hasLine() &&
+         nextInputEvent != inputEvents.end() &&
+         nextInputEvent->time <= time )
+    {
+      incoming.write( nextInputEvent->event.data(), nextInputEvent->event.size() );
+      incoming.write( "\n", 1 );
+      nextInputEvent++;                     // Go to the next input event.
+    }
+
+    LineView line;
+    if ( !incoming.nextLine( line ) )
+      return false;   // No events, or they haven't occurred yet
 
     // Got one.
-    returnString = nextInputEvent->event;   // Populate Return String
-    nextInputEvent++;                       // Go to the next input event.
+    returnString.assign( line.data, line.size );
     return true;
   }
 
@@ -227,6 +238,8 @@ class NetMockSimpleTimed: public NetInterface
   int time;
   /// @brief  The next input event that needs to be processed.
   TimedStringEvents::const_iterator nextInputEvent;
+  /// @brief  Input that's arrived, split into lines
+  LineFramer< 256 > incoming;
   /// @brief  The current string that's being written to 
   std::string currentOutput;
   /// @brief  Recorded output events
@@ -0,0 +1,74 @@
+///
+/// @brief Testing Mock for the fixed rate sample timer
+/// 
+
+#ifndef __TEST_MOCK_SAMPLE_TIMER_H__
+#define __TEST_MOCK_SAMPLE_TIMER_H__
+
+#include <memory>
+#include "hardware_interface.h"
+#include "sample_timer_interface.h"
+
+///
+/// @brief Testing Mock for the fixed rate sample timer
+///
+/// Instead of reading from an interrupt, the mock reads the microphone
+/// into the ring once per interval as advanceTime moves time forward.
+///
+class SampleTimerMock: public SampleTimerInterface
+{
+  public:
+
+  explicit SampleTimerMock( std::shared_ptr<HWI> hardwareArg ) : 
+    hardware{ hardwareArg }, running{ false }, intervalUs{ 0 }, ring{ nullptr },
+    elapsedUs{ 0 }, fired{ 0 }
+  {
+  }
+
+  void start( unsigned int intervalUsArg, SampleRing& ringArg ) override
+  {
+    running = true;
+    intervalUs = intervalUsArg;
+    ring = &ringArg;
+    elapsedUs = 0;
+  }
+
+  void stop() override
+  {
+    running = false;
+  }
+
+  ///
+  /// @brief      Advance timer mock time by "us" microseconds
+  ///
+  /// Pushes a reading for every full interval that passes.
+  ///
+  void advanceTime( unsigned long long us )
+  {
+    if ( !running ) 
+    {
+      return;
+    }
+    elapsedUs += us;
+    while ( running && elapsedUs >= intervalUs )
+    {
+      elapsedUs -= intervalUs;
+      ++fired;
+      ring->push( hardware->AnalogRead( HWI::Pin::MICROPHONE ));
+    }
+  }
+
+  bool isRunning() const { return running; }
+  unsigned int getIntervalUs() const { return intervalUs; }
+  unsigned int getFired() const { return fired; }
+
+  private:
+  std::shared_ptr<HWI> hardware;
+  bool running;
+  unsigned int intervalUs;
+  SampleRing* ring;
+  unsigned long long elapsedUs;
+  unsigned int fired;
+};
+
+#endif
@@ -0,0 +1,78 @@
+///
+/// @brief Testing Mock for time
+/// 
+
+#ifndef __TEST_MOCK_TIME_H__
+#define __TEST_MOCK_TIME_H__
+
+#include "time_interface.h"
+
+///
+/// @brief Testing Mock for time
+///
+/// TimeMockTimed implements a mock Time Interface (TimeInterface) that's
+/// used in unit testing.  Like the other timed mocks, time only moves
+/// when advanceTime is called.
+///
+class TimeMockTimed: public TimeInterface
+{
+  public:
+
+  ///
+  /// @brief Constructor
+  ///
+  /// @param[in] secondsArg - Wall clock time at device start
+  ///
+  TimeMockTimed( unsigned int secondsArg = 0 ) : 
+    startSeconds{ secondsArg }, 
+    time{ 0 },
+    synced{ true }
+  {
+  }
+
+  unsigned int secondsSince1970() override
+  {
+    return startSeconds + time / 1000;
+  }
+
+  uint64_t msSince1970() override
+  {
+    return startSeconds * 1000ULL + time;
+  }
+
+  unsigned int msSinceDeviceStart() override
+  {
+    return time;
+  }
+
+  bool isSynced() override
+  {
+    return synced;
+  }
+
+  /// @brief Pretend the wall clock is (or isn't) from a time server
+  void setSynced( bool syncedArg )
+  {
+    synced = syncedArg;
+  }
+
+  ///
+  /// @brief      Advance time mock by "ticks" ms
+  /// @param[in]  The amount of time by, in ms
+  ///
+  void advanceTime( int ticks )
+  {
+    time += ticks;
+  }
+
+  private:
+  /// @brief  Wall clock time at device start
+  const unsigned int startSeconds;
+  /// @brief  Current Time (ms)
+  unsigned int time;
+  /// @brief  What isSynced reports
+  bool synced;
+};
+
+#endif
+
@@ -0,0 +1,242 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstring>
+#include <memory>
+
+#include "ntp_client.h"
+#include "time_manager.h"
+#include "udp_posix.h"
+#include "test_mock_clock.h"
+#include "test_mock_debug.h"
+
+namespace {
+
+constexpr uint32_t secondsFrom1900To1970 = 2208988800U;
+
+///
+/// @brief An NTP server on the loopback interface
+///
+/// Answers one request each time answer() is called, so the test decides
+/// when (and whether) the reply arrives.
+///
+class FakeNtpServer
+{
+  public:
+
+  FakeNtpServer() : fd{ socket( AF_INET, SOCK_DGRAM, 0 ) }, port{ 0 }
+  {
+    sockaddr_in local;
+    memset( &local, 0, sizeof( local ));
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    bind( fd, (sockaddr*) &local, sizeof( local ));
+    socklen_t size = sizeof( local );
+    getsockname( fd, (sockaddr*) &local, &size );
+    port = ntohs( local.sin_port );
+  }
+
+  ~FakeNtpServer() { close( fd ); }
+
+  /// @brief How to spoil a reply
+  enum class Fault { NONE, SHORT, WRONG_ORIGIN, KISS_OF_DEATH, CLIENT_MODE };
+
+  ///
+  /// @brief Answer the oldest request
+  ///
+  /// @param[in] seconds - Time to reply with, since 1970
+  /// @param[in] ms      - Fraction of a second to reply with
+  /// @param[in] fault   - How to spoil the reply
+  /// @return false if there was no request
+  ///
+  bool answer( uint32_t seconds, uint32_t ms, Fault fault = Fault::NONE )
+  {
+    fd_set readable;
+    FD_ZERO( &readable );
+    FD_SET( fd, &readable );
+    timeval timeout{ 1, 0 };
+    if ( select( fd + 1, &readable, nullptr, nullptr, &timeout ) != 1 ) {
+      return false;
+    }
+    uint8_t packet[ NtpClient::packetSize ];
+    sockaddr_in from;
+    socklen_t fromSize = sizeof( from );
+    if ( recvfrom( fd, packet, sizeof( packet ), 0, (sockaddr*) &from, &fromSize )
+         != (ssize_t) sizeof( packet ))
+    {
+      return false;
+    }
+    ++requests;
+
+    uint8_t reply[ NtpClient::packetSize ] = {};
+    reply[0] = fault == Fault::CLIENT_MODE ? 0x23 : 0x24;
+    reply[1] = fault == Fault::KISS_OF_DEATH ? 0 : 2;
+    // The origin timestamp is the request's transmit timestamp
+    memcpy( &reply[24], &packet[40], 8 );
+    if ( fault == Fault::WRONG_ORIGIN ) {
+      reply[31] ^= 1;
+    }
+    writeWord( &reply[40], seconds + secondsFrom1900To1970 );
+    writeWord( &reply[44], (uint32_t) (( uint64_t( ms ) << 32 ) / 1000 ));
+    const std::size_t size = fault == Fault::SHORT ? 40 : sizeof( reply );
+    return sendto( fd, reply, size, 0, (sockaddr*) &from, fromSize ) == (ssize_t) size;
+  }
+
+  uint16_t getPort() const { return port; }
+
+  unsigned int requests = 0;
+
+  private:
+
+  static void writeWord( uint8_t* bytes, uint32_t value )
+  {
+    for ( int i = 3; i >= 0; --i, value >>= 8 ) {
+      bytes[i] = (uint8_t) value;
+    }
+  }
+
+  int fd;
+  uint16_t port;
+};
+
+/// @brief An NtpClient talking to a FakeNtpServer, on a mock clock
+class NtpClientTest : public ::testing::Test
+{
+  protected:
+
+  NtpClientTest() :
+    clock{ std::make_shared< ClockMock >() },
+    udp{ std::make_shared< UdpPosix >() },
+    client{ udp, clock, std::make_shared< DebugInterfaceIgnoreMock >(),
+            "127.0.0.1", server.getPort() },
+    delay{ 0 }
+  {
+  }
+
+  /// @brief Wait for the delay loop() last asked for, then run it again
+  void step()
+  {
+    clock->advanceTime( delay );
+    delay = client.loop();
+  }
+
+  /// @brief Run until the client has sent a request
+  void stepUntilSent()
+  {
+    for ( unsigned int i = 0; i < 10 && client.getState() != NtpClient::State::WAIT_REPLY; ++i ) {
+      step();
+    }
+    ASSERT_EQ( NtpClient::State::WAIT_REPLY, client.getState() );
+  }
+
+  FakeNtpServer server;
+  std::shared_ptr< ClockMock > clock;
+  std::shared_ptr< UdpPosix > udp;
+  NtpClient client;
+  unsigned int delay;
+};
+
+}
+
+/// @brief The reply is picked up on a later loop, never waited for
+TEST_F( NtpClientTest, should_sync_from_server )
+{
+  ASSERT_TRUE( udp->ok() );
+  ASSERT_EQ( 0u, client.secondsSince1970() );
+  stepUntilSent();
+  ASSERT_EQ( NtpClient::pollUs, delay );
+
+  // Nothing yet, so the client just asks to be run again soon
+  step();
+  ASSERT_EQ( NtpClient::State::WAIT_REPLY, client.getState() );
+  ASSERT_EQ( NtpClient::pollUs, delay );
+
+  ASSERT_TRUE( server.answer( 1700000000, 900 ));
+  step();
+  ASSERT_EQ( NtpClient::State::SYNCED, client.getState() );
+  ASSERT_EQ( 20u, client.getRoundTripMs() );
+  ASSERT_EQ( NtpClient::resyncMs * 1000, delay );
+  // 900 ms plus half the round trip is past the second
+  ASSERT_EQ( 1700000000u, client.secondsSince1970() );
+  clock->advanceTime( 100000 );
+  ASSERT_EQ( 1700000001u, client.secondsSince1970() );
+
+  // Asks again an hour later, without looking the server up again
+  step();
+  stepUntilSent();
+  ASSERT_EQ( 1u, client.getLookups() );
+  ASSERT_TRUE( server.answer( 1700003600, 0 ));
+  step();
+  ASSERT_EQ( NtpClient::State::SYNCED, client.getState() );
+  ASSERT_EQ( 2u, server.requests );
+}
+
+/// @brief Unanswered requests back off, and the server is looked up again
+TEST_F( NtpClientTest, should_back_off_without_a_reply )
+{
+  unsigned int expectedBackOffMs = NtpClient::minRetryMs;
+  for ( unsigned int failure = 1; failure <= 4; ++failure )
+  {
+    stepUntilSent();
+    while ( client.getState() == NtpClient::State::WAIT_REPLY ) {
+      step();
+    }
+    ASSERT_EQ( failure, client.getFailures() );
+    ASSERT_EQ( expectedBackOffMs * 1000, delay );
+    expectedBackOffMs *= 2;
+  }
+  ASSERT_EQ( 0u, client.secondsSince1970() );
+  // The address was dropped after the third failure
+  ASSERT_EQ( 2u, client.getLookups() );
+
+  // Late replies to old requests are thrown away before the next one
+  for ( unsigned int request = 0; request < 4; ++request ) {
+    ASSERT_TRUE( server.answer( 1600000000, 0 ));
+  }
+  stepUntilSent();
+  step();
+  ASSERT_EQ( NtpClient::State::WAIT_REPLY, client.getState() );
+  ASSERT_TRUE( server.answer( 1700000000, 0 ));
+  step();
+  ASSERT_EQ( NtpClient::State::SYNCED, client.getState() );
+  ASSERT_EQ( 1700000000u, client.secondsSince1970() );
+  ASSERT_EQ( 0u, client.getFailures() );
+}
+
+/// @brief Replies that don't answer our request are ignored
+TEST_F( NtpClientTest, should_reject_bad_replies )
+{
+  using Fault = FakeNtpServer::Fault;
+  for ( Fault fault : { Fault::SHORT, Fault::WRONG_ORIGIN, Fault::KISS_OF_DEATH, Fault::CLIENT_MODE } )
+  {
+    stepUntilSent();
+    ASSERT_TRUE( server.answer( 1700000000, 0, fault ));
+    step();
+    ASSERT_EQ( NtpClient::State::WAIT_REPLY, client.getState() );
+    ASSERT_EQ( 0u, client.secondsSince1970() );
+    while ( client.getState() == NtpClient::State::WAIT_REPLY ) {
+      step();
+    }
+  }
+  ASSERT_EQ( 4u, client.getFailures() );
+}
+
+/// @brief TimeManager keeps asking until the client has synced
+TEST_F( NtpClientTest, should_feed_time_manager )
+{
+  auto ntp = std::shared_ptr< NtpClient >( &client, []( NtpClient* ) {} );
+  TimeManager time( ntp );
+  ASSERT_EQ( 0u, time.secondsSince1970() );
+
+  stepUntilSent();
+  ASSERT_TRUE( server.answer( 1700000000, 0 ));
+  step();
+  ASSERT_EQ( 1700000000u, time.secondsSince1970() );
+  clock->advanceTime( 2000000 );
+  ASSERT_EQ( 1700000002u, time.secondsSince1970() );
+}
+
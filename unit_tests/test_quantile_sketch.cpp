@@ -0,0 +1,117 @@
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
+
+#include "quantile_sketch.h"
+
+namespace {
+
+using Sketch = QuantileSketch< unsigned int, 128 >;
+
+/// @brief Exact quantile, with the same rank rule as the sketch
+unsigned int exactQuantile( std::vector< unsigned int > data, unsigned int percent )
+{
+  std::sort( data.begin(), data.end() );
+  return data[ (( data.size() - 1 ) * percent ) / 100 ];
+}
+
+/// @brief Roughly log normal data, like per second energies
+std::vector< unsigned int > levelData( unsigned int n, unsigned int seed )
+{
+  std::vector< unsigned int > data;
+  unsigned int lfsr = seed;
+  for ( unsigned int i = 0; i < n; ++i )
+  {
+    lfsr = lfsr * 1103515245u + 12345u;
+    const unsigned int octaves = ( lfsr >> 16 ) % 12;
+    data.push_back(( 100u << octaves ) + (( lfsr >> 8 ) & 0xff ) * ( 1u << octaves ));
+  }
+  return data;
+}
+
+}
+
+/// @brief An empty sketch reports zeros
+TEST( QUANTILE_SKETCH, should_be_empty_after_reset )
+{
+  Sketch s;
+  s.insert( 1000 );
+  s.reset();
+  ASSERT_EQ( 0u, s.getCount() );
+  ASSERT_EQ( 0u, s.getQuantile( 50 ));
+}
+
+/// @brief Small values get exact buckets
+TEST( QUANTILE_SKETCH, should_be_exact_for_small_values )
+{
+  Sketch s;
+  for ( unsigned int i = 0; i <= 7; ++i ) 
+  {
+    s.insert( i );
+  }
+  ASSERT_EQ( 0u, s.getQuantile( 0 ));
+  ASSERT_EQ( 3u, s.getQuantile( 50 ));
+  ASSERT_EQ( 7u, s.getQuantile( 100 ));
+}
+
+/// @brief Quantiles are within the relative error of a bucket
+TEST( QUANTILE_SKETCH, should_have_bounded_relative_error )
+{
+  const auto data = levelData( 50000, 0xbee );
+  Sketch s;
+  for ( auto d : data ) 
+  {
+    s.insert( d );
+  }
+
+  ASSERT_EQ( data.size(), s.getCount() );
+  for ( unsigned int p : { 1, 10, 50, 90, 99 } )
+  {
+    const double exact = exactQuantile( data, p );
+    EXPECT_NEAR( exact, s.getQuantile( p ), exact / 8 ) << "p" << p;
+  }
+  ASSERT_EQ( *std::max_element( data.begin(), data.end() ), s.getQuantile( 100 ));
+}
+
+/// @brief Merging two sketches is the same as sketching both streams
+TEST( QUANTILE_SKETCH, merge_matches_union )
+{
+  const auto a = levelData( 10000, 1 );
+  const auto b = levelData( 10000, 2 );
+
+  Sketch sa, sb, both;
+  for ( auto d : a ) { sa.insert( d ); both.insert( d ); }
+  for ( auto d : b ) { sb.insert( d * 4 ); both.insert( d * 4 ); }
+
+  sa.merge( sb );
+  ASSERT_EQ( both.getCount(), sa.getCount() );
+  ASSERT_EQ( both.getOffset(), sa.getOffset() );
+  ASSERT_EQ( both.getCounts(), sa.getCounts() );
+  for ( unsigned int p : { 0, 50, 90, 99, 100 } )
+  {
+    ASSERT_EQ( both.getQuantile( p ), sa.getQuantile( p ));
+  }
+}
+
+/// @brief A small window collapses the bottom but keeps high quantiles
+TEST( QUANTILE_SKETCH, small_window_keeps_high_quantiles )
+{
+  const auto data = levelData( 20000, 3 );
+  QuantileSketch< unsigned int, 16 > s;
+  for ( auto d : data ) 
+  {
+    s.insert( d );
+  }
+
+  static_assert( sizeof( s ) <= 16 * sizeof( unsigned int ) + 32, 
+    "memory should not grow with the samples" );
+  ASSERT_GT( s.getOffset(), 0u );
+  for ( unsigned int p : { 90, 99 } )
+  {
+    const double exact = exactQuantile( data, p );
+    EXPECT_NEAR( exact, s.getQuantile( p ), exact / 8 ) << "p" << p;
+  }
+  // Everything below the window piles into the lowest bucket
+  ASSERT_LT( s.getQuantile( 10 ), BeeFocus::log2BucketLowerEdge( s.getOffset() + 1, 3 ));
+}
@@ -0,0 +1,108 @@
+
+#include <gtest/gtest.h>
+
+#include "rolling_histogram.h"
+#include "histogram.h"
+
+namespace {
+
+using Linear = Histogram< unsigned int, 10 >;
+using Rolling = RollingHistogram< Linear, 4 >;
+
+}
+
+/// @brief The footprint is the slots plus a few counters
+TEST( ROLLING_HISTOGRAM, memory_is_fixed )
+{
+  static_assert( sizeof( Rolling ) <= 4 * sizeof( Linear ) + 4 * sizeof( unsigned int ),
+    "RollingHistogram should only hold its slots and counters" );
+  ASSERT_EQ( 4u, Rolling::numSlots );
+}
+
+/// @brief Views merge the most recent slots
+TEST( ROLLING_HISTOGRAM, views_merge_recent_slots )
+{
+  Rolling r( 0u, 100u );
+  r.advanceTo( 1000 );
+  r.insert( 5u );           // slot 1000
+  r.advanceTo( 1001 );
+  r.insert( 15u );          // slot 1001
+  r.insert( 15u );
+  r.advanceTo( 1002 );
+  r.insert( 25u );          // slot 1002
+
+  ASSERT_EQ( 1002u, r.getSlotNumber() );
+  ASSERT_EQ( 3u, r.getSlotsFilled() );
+  ASSERT_EQ( 1u, r.getSlot( 0 ).getCount( 2 ));
+  ASSERT_EQ( 2u, r.getSlot( 1 ).getCount( 1 ));
+
+  const Linear last2 = r.getView( 2 );
+  ASSERT_EQ( 3u, last2.getTotal() );
+  ASSERT_EQ( 0u, last2.getCount( 0 ));
+
+  const Linear all = r.getView( 100 );
+  ASSERT_EQ( 4u, all.getTotal() );
+  ASSERT_EQ( 1u, all.getCount( 0 ));
+  ASSERT_EQ( 10u, all.getPercentile( 50 ));
+}
+
+/// @brief Old slots are reused once the ring wraps
+TEST( ROLLING_HISTOGRAM, rotation_drops_oldest )
+{
+  Rolling r( 0u, 100u );
+  for ( unsigned int slot = 0; slot < 6; ++slot )
+  {
+    r.advanceTo( slot );
+    r.insert( slot * 10 );
+  }
+
+  ASSERT_EQ( 4u, r.getSlotsFilled() );
+  const Linear all = r.getView( 4 );
+  ASSERT_EQ( 4u, all.getTotal() );
+  ASSERT_EQ( 0u, all.getCount( 0 ));
+  ASSERT_EQ( 0u, all.getCount( 1 ));
+  ASSERT_EQ( 1u, all.getCount( 2 ));
+  ASSERT_EQ( 1u, all.getCount( 5 ));
+}
+
+/// @brief Gaps leave empty slots, and long gaps clear everything
+TEST( ROLLING_HISTOGRAM, gaps_clear_slots )
+{
+  Rolling r( 0u, 100u );
+  r.advanceTo( 10 );
+  r.insert( 50u );
+  r.advanceTo( 12 );
+  ASSERT_EQ( 1u, r.getView( 3 ).getTotal() );
+  ASSERT_EQ( 0u, r.getView( 2 ).getTotal() );
+
+  // Going backwards stays in the current slot
+  r.advanceTo( 11 );
+  ASSERT_EQ( 12u, r.getSlotNumber() );
+
+  r.advanceTo( 1000000 );
+  ASSERT_EQ( 1000000u, r.getSlotNumber() );
+  ASSERT_EQ( 0u, r.getView( 4 ).getTotal() );
+
+  r.insert( 1u );
+  r.reset();
+  ASSERT_EQ( 0u, r.getView( 4 ).getTotal() );
+  ASSERT_EQ( 1u, r.getSlotsFilled() );
+}
+
+/// @brief Auto ranging slots that grew differently still merge
+TEST( ROLLING_HISTOGRAM, auto_range_slots_merge )
+{
+  using Auto = Histogram< unsigned int, 10, AutoRangeBins< unsigned int, 10 >>;
+  RollingHistogram< Auto, 3 > r( 0u, 9u );
+  r.advanceTo( 0 );
+  r.insert( 1u );
+  r.insert( 3u );
+  r.advanceTo( 1 );
+  r.insert( 35u );          // This slot is now 4 wide
+
+  const Auto all = r.getView( 3 );
+  ASSERT_EQ( 4u, all.getLowerEdge( 1 ));
+  ASSERT_EQ( 2u, all.getCount( 0 ));
+  ASSERT_EQ( 1u, all.getCount( 8 ));
+  ASSERT_EQ( 3u, all.getTotal() );
+}
@@ -0,0 +1,112 @@
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <memory>
+
+#include "test_sound_harness.h"
+
+/// @brief Polled mode reads one sample per loop call
+TEST( SSOUND, polled_mode_collects_a_window )
+{
+  SoundHarness h( FS::SampleMode::POLLED, {{ 2500, "status" }} );
+  h.runFor( 3500 );
+
+  const int samples = h.statusValue( "absSamples" );
+  ASSERT_GT( samples, 9900 );
+  ASSERT_LT( samples, 10100 );
+  ASSERT_EQ( 200, h.statusValue( "absmean" ));
+  ASSERT_EQ( 195, h.statusValue( "min 1sec sample" ));
+  ASSERT_EQ( 205, h.statusValue( "max 1sec sample" ));
+  // A +/- 5 square wave has a mean square of 25, or 14 dB
+  ASSERT_NEAR( 25, h.statusValue( "leq ms" ), 1 );
+  ASSERT_EQ( 14, h.statusValue( "leq dB" ));
+  ASSERT_EQ( 7, h.statusValue( "histogram_slot" ));
+  ASSERT_EQ( 2, h.statusValue( "histogram_width" ));
+  ASSERT_EQ( 1, h.statusValue( "last hour n" ));
+  ASSERT_EQ( 1, h.statusValue( "today n" ));
+  ASSERT_EQ( 14, h.statusValue( "leq p50 dB" ));
+  ASSERT_EQ( 14, h.statusValue( "leq p99 dB" ));
+  // The spectrum is averaged over every full 256 sample frame
+  ASSERT_EQ( samples / 256, h.statusValue( "fft frames" ));
+  ASSERT_EQ( 0ULL, h.hw->getBurstUs() );
+}
+
+/// @brief Burst mode reads a block of samples per loop call
+TEST( SSOUND, burst_mode_collects_a_window )
+{
+  SoundHarness h( FS::SampleMode::BURST, {{ 2500, "status" }} );
+  h.runFor( 3500 );
+
+  const int samples = h.statusValue( "absSamples" );
+  ASSERT_GT( samples, 9900 );
+  ASSERT_LT( samples, 10100 );
+  ASSERT_EQ( 0, samples % (int) FS::SSound::burstSize );
+  ASSERT_EQ( 200, h.statusValue( "absmean" ));
+  ASSERT_EQ( 5, h.statusValue( "absAvg" ));
+  ASSERT_EQ( (unsigned) samples, h.hw->getAnalogReads() );
+}
+
+/// @brief Timer mode drains the sampler in bulk
+TEST( SSOUND, timer_mode_collects_a_window )
+{
+  SoundHarness h( FS::SampleMode::TIMER, {{ 2500, "status" }} );
+  h.runFor( 3500 );
+
+  const int samples = h.statusValue( "absSamples" );
+  ASSERT_GT( samples, 9900 );
+  ASSERT_LE( samples, 10100 );
+  ASSERT_EQ( 200, h.statusValue( "absmean" ));
+  ASSERT_EQ( 0, h.statusValue( "overruns" ));
+  ASSERT_EQ( (unsigned) samples, h.hw->getAnalogReads() );
+  // The timer only runs during the 1 second window
+  ASSERT_FALSE( h.timer->isRunning() );
+  ASSERT_EQ( (unsigned) samples, h.timer->getFired() );
+}
+
+namespace {
+
+///
+/// @brief Run a restored SSound with its clock moved on by shiftMs
+///
+/// Patches the snapshot's time, dayEnd, windowEnd and pauseEnd, which
+/// follow the wall time, the start time and the cycle's resume point.
+///
+std::unique_ptr< SoundHarness > runShifted( const SnapshotWriter& saved, uint64_t shiftMs )
+{
+  std::vector< uint8_t > data = saved.getData();
+  for ( std::size_t offset : { 4, 17, 25, 33 } )
+  {
+    uint64_t ms;
+    std::memcpy( &ms, data.data() + offset, sizeof( ms ));
+    ms += shiftMs;
+    std::memcpy( data.data() + offset, &ms, sizeof( ms ));
+  }
+  std::unique_ptr< SoundHarness > h( new SoundHarness( FS::SampleMode::POLLED, {{ 9000, "status" }} ));
+  SnapshotReader in( data.data(), data.size() );
+  EXPECT_TRUE( h->sound.restore( in ));
+  h->runFor( 10000 );
+  return h;
+}
+
+}
+
+/// @brief SSound's clock carries on past 2^32 ms (49.7 days of uptime)
+TEST( SSOUND, should_keep_time_past_32_bit_ms )
+{
+  SoundHarness before( FS::SampleMode::POLLED, {} );
+  before.runFor( 7000 );
+  SnapshotWriter saved;
+  before.sound.save( saved );
+
+  uint64_t savedMs;
+  std::memcpy( &savedMs, saved.getData().data() + 4, sizeof( savedMs ));
+  ASSERT_EQ( 7000u, savedMs );
+
+  // The same run, with the clock about to pass 2^32 ms
+  auto unshifted = runShifted( saved, 0 );
+  auto shifted = runShifted( saved, ( 1ULL << 32 ) - savedMs - 500 );
+  ASSERT_EQ( 3, unshifted->statusValue( "last hour n" ));
+  for ( const char* name : { "last hour n", "today n", "absSamples" } ) {
+    ASSERT_EQ( unshifted->statusValue( name ), shifted->statusValue( name )) << name;
+  }
+}
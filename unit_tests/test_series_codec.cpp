@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <vector>
+
+#include "series_codec.h"
+#include "telemetry_decode.h"
+
+namespace {
+
+/// @brief Small, repeatable pseudo random numbers
+class Lcg
+{
+  public:
+  explicit Lcg( uint64_t seed ) : state{ seed } {}
+  uint64_t next()
+  {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return state >> 17;
+  }
+  private:
+  uint64_t state;
+};
+
+struct Sample
+{
+  uint64_t timeMs;
+  int32_t value;
+};
+
+/// @brief Encode as much of samples as fits; check it decodes the same
+std::size_t roundTrip( const std::vector< Sample >& samples, SeriesCoding coding,
+  std::size_t blockSize, uint64_t baseMs )
+{
+  std::vector< uint8_t > block( blockSize, 0xff );
+  SeriesEncoder encoder( block.data(), block.size(), coding, baseMs );
+  std::size_t added = 0;
+  while ( added < samples.size() &&
+          encoder.append( samples[ added ].timeMs, samples[ added ].value )) {
+    ++added;
+  }
+  EXPECT_EQ( added, encoder.size() );
+  EXPECT_LE( encoder.bytesUsed(), blockSize );
+
+  SeriesDecoder decoder( block.data(), encoder.bytesUsed(), baseMs );
+  EXPECT_EQ( added, decoder.size() );
+  for ( std::size_t i = 0; i < added; ++i )
+  {
+    uint64_t timeMs = 0;
+    int32_t value = 0;
+    EXPECT_TRUE( decoder.next( timeMs, value ));
+    EXPECT_EQ( samples[i].timeMs, timeMs ) << i;
+    EXPECT_EQ( samples[i].value, value ) << i;
+  }
+  uint64_t timeMs;
+  int32_t value;
+  EXPECT_FALSE( decoder.next( timeMs, value ));
+  return added;
+}
+
+std::vector< Sample > randomSeries( uint64_t seed, std::size_t n )
+{
+  Lcg rng( seed );
+  std::vector< Sample > samples;
+  uint64_t timeMs = 1760000000000ULL;
+  int32_t value = 0;
+  for ( std::size_t i = 0; i < n; ++i )
+  {
+    // Mostly regular, sometimes jittered or far apart; values that step
+    // by small and large amounts
+    const uint64_t r = rng.next();
+    timeMs += r % 4 == 0 ? r % 100000000 : 1000 + r % 8;
+    value = r % 16 == 0 ? (int32_t) rng.next() : value + (int32_t) ( r % 7 ) - 3;
+    samples.push_back( Sample{ timeMs, value });
+  }
+  return samples;
+}
+
+/// @brief Every reading in a firmware_sim capture, by channel
+std::map< uint8_t, std::vector< Sample >> recordedSeries()
+{
+  std::ifstream in( BEEFOCUS_TEST_DATA "/firmware_sim_capture.bin", std::ios::binary );
+  const std::vector< uint8_t > capture{ std::istreambuf_iterator< char >( in ),
+    std::istreambuf_iterator< char >() };
+  std::vector< TelemetryReading > readings;
+  findTelemetryFrames( capture, readings );
+  std::map< uint8_t, std::vector< Sample >> series;
+  for ( const TelemetryReading& r : readings ) {
+    series[ (uint8_t) r.type << 4 | r.channel ].push_back( Sample{ r.timeMs, r.value });
+  }
+  return series;
+}
+
+}
+
+/// @brief Bits go in and come out in order, whatever the alignment
+TEST( SERIES_CODEC, should_pack_bits )
+{
+  std::array< uint8_t, 16 > buffer;
+  buffer.fill( 0xff );
+  BitWriter out( buffer.data(), buffer.size() );
+  ASSERT_TRUE( out.put( 1, 1 ));
+  ASSERT_TRUE( out.put( 0x5a, 7 ));
+  ASSERT_TRUE( out.put( 0x123456789abcdef0ULL, 64 ));
+  ASSERT_TRUE( out.put( 0, 3 ));
+  ASSERT_FALSE( out.put( 0, 54 ));
+  ASSERT_EQ( 75u, out.getBits() );
+
+  BitReader in( buffer.data(), buffer.size() );
+  uint64_t value;
+  ASSERT_TRUE( in.get( value, 1 ));
+  ASSERT_EQ( 1u, value );
+  ASSERT_TRUE( in.get( value, 7 ));
+  ASSERT_EQ( 0x5au, value );
+  ASSERT_TRUE( in.get( value, 64 ));
+  ASSERT_EQ( 0x123456789abcdef0ULL, value );
+  ASSERT_TRUE( in.get( value, 3 ));
+  ASSERT_EQ( 0u, value );
+}
+
+/// @brief Both codings give back what went in, extremes included
+TEST( SERIES_CODEC, should_round_trip )
+{
+  const std::vector< Sample > edges{
+    { 0, 0 }, { 0, -2147483647 - 1 }, { 1, 2147483647 }, { 0xffffffffffffULL, -1 },
+    { 0xffffffffffffULL, 0 }, { 5, 1 }, { 6, 1 }, { 7, 1 } };
+  for ( SeriesCoding coding : { SeriesCoding::DELTA, SeriesCoding::XOR } )
+  {
+    ASSERT_EQ( edges.size(), roundTrip( edges, coding, 256, 0 ));
+    const std::vector< Sample > samples = randomSeries( 1 + (int) coding, 5000 );
+    ASSERT_EQ( samples.size(), roundTrip( samples, coding, 65536, 1760000000000ULL ));
+  }
+}
+
+/// @brief A full block takes no more, and what's in it is still good
+TEST( SERIES_CODEC, should_stop_when_full )
+{
+  const std::vector< Sample > samples = randomSeries( 3, 1000 );
+  for ( SeriesCoding coding : { SeriesCoding::DELTA, SeriesCoding::XOR } )
+  {
+    for ( std::size_t size : { 3u, 4u, 17u, 64u } )
+    {
+      const std::size_t added = roundTrip( samples, coding, size, 0 );
+      ASSERT_LT( added, samples.size() );
+    }
+  }
+  uint8_t header[] = { 1, 0, 7 };
+  SeriesDecoder badCoding( header, sizeof( header ));
+  ASSERT_EQ( 0u, badCoding.size() );
+  SeriesDecoder truncated( header, 2 );
+  ASSERT_EQ( 0u, truncated.size() );
+}
+
+/// @brief Regular samples of a steady value take 2 bits
+TEST( SERIES_CODEC, should_compress_steady_series )
+{
+  std::array< uint8_t, 64 > block;
+  for ( SeriesCoding coding : { SeriesCoding::DELTA, SeriesCoding::XOR } )
+  {
+    SeriesEncoder encoder( block.data(), block.size(), coding, 1000 );
+    for ( unsigned int i = 0; i < 100; ++i ) {
+      ASSERT_TRUE( encoder.append( 1000 + i * 1000, 500 ));
+    }
+    // The first value, the first gap, then 2 bits a sample
+    ASSERT_LE( encoder.bytesUsed(), SeriesEncoder::headerSize + ( 98 * 2 + 64 ) / 8 );
+  }
+}
+
+/// @brief Compression and speed on data recorded from firmware_sim
+TEST( SERIES_CODEC_BENCH, recorded_sim_telemetry )
+{
+  const auto recorded = recordedSeries();
+  ASSERT_FALSE( recorded.empty() );
+  for ( const auto& channel : recorded )
+  {
+    const std::vector< Sample >& samples = channel.second;
+    ASSERT_GT( samples.size(), 100u );
+    for ( SeriesCoding coding : { SeriesCoding::DELTA, SeriesCoding::XOR } )
+    {
+      // Blocks the size TelemetryFrame uses
+      std::array< uint8_t, 96 > block;
+      std::size_t bytes = 0;
+      std::size_t blocks = 0;
+      const unsigned int reps = 200;
+      using clock = std::chrono::steady_clock;
+      const auto start = clock::now();
+      for ( unsigned int rep = 0; rep < reps; ++rep )
+      {
+        bytes = 0;
+        blocks = 0;
+        SeriesEncoder encoder;
+        for ( std::size_t i = 0; i < samples.size(); ++i )
+        {
+          if ( !encoder.append( samples[i].timeMs, samples[i].value ))
+          {
+            bytes += encoder.bytesUsed();
+            ++blocks;
+            encoder = SeriesEncoder( block.data(), block.size(), coding, samples[i].timeMs );
+            ASSERT_TRUE( encoder.append( samples[i].timeMs, samples[i].value ));
+          }
+        }
+        bytes += encoder.bytesUsed();
+      }
+      const double ns = std::chrono::duration< double, std::nano >(
+        clock::now() - start ).count() / ( reps * samples.size() );
+
+      // Against 8 byte times and 4 byte values
+      const double raw = samples.size() * 12.0;
+      std::cout << "channel 0x" << std::hex << (unsigned int) channel.first << std::dec
+                << ( coding == SeriesCoding::DELTA ? " delta: " : " xor: " )
+                << samples.size() << " samples in " << bytes << " bytes ("
+                << blocks << " blocks), " << 8.0 * bytes / samples.size()
+                << " bits/sample, " << raw / bytes << "x, " << ns << " ns/sample\n";
+      ASSERT_LT( bytes, raw / 4 );
+    }
+  }
+}
@@ -0,0 +1,86 @@
+///
+/// @brief SSound wired up to timed mocks, for unit tests
+///
+
+#ifndef __TEST_SOUND_HARNESS_H__
+#define __TEST_SOUND_HARNESS_H__
+
+#include <memory>
+#include <string>
+
+#include "sample_sound.h"
+#include "test_mock_debug.h"
+#include "test_mock_event.h"
+#include "test_mock_hardware.h"
+#include "test_mock_net.h"
+#include "test_mock_sample_timer.h"
+#include "test_mock_time.h"
+
+///
+/// @brief SSound wired up to timed mocks
+///
+/// runFor calls SSound::loop, moving the mocks' time forward by the delay
+/// SSound asks for plus any time spent in an analog burst.  In TIMER mode
+/// the sample timer fires as time passes.
+///
+class SoundHarness
+{
+  public:
+
+  SoundHarness( FS::SampleMode mode, const TimedStringEvents& input,
+    unsigned int wallSeconds = 0 ) :
+    net{ std::make_shared<NetMockSimpleTimed>( input ) },
+    hw{ std::make_shared<HWMockTimed>( HWTimedEvents(), 
+      std::vector<unsigned short>{ 195, 205 } ) },
+    debug{ std::make_shared<DebugInterfaceIgnoreMock>() },
+    time{ std::make_shared<TimeMockTimed>( wallSeconds ) },
+    timer{ std::make_shared<SampleTimerMock>( hw ) },
+    sampler{ std::make_shared<SoundSampler>( timer ) },
+    sound{ net, hw, debug, time, mode, sampler },
+    nowUs{ 0 }
+  {
+  }
+
+  void runFor( unsigned int ms )
+  {
+    const unsigned long long endUs = nowUs + ms * 1000ULL;
+    while ( nowUs < endUs )
+    {
+      const unsigned long long burstBefore = hw->getBurstUs();
+      unsigned long long delay = sound.loop();
+      delay += hw->getBurstUs() - burstBefore;
+
+      const unsigned int oldMs = nowUs / 1000;
+      nowUs += delay;
+      const unsigned int newMs = nowUs / 1000;
+      net->advanceTime( newMs - oldMs );
+      time->advanceTime( newMs - oldMs );
+      timer->advanceTime( delay );
+    }
+  }
+
+  /// @brief Get the value of a "name   value" line from the status output
+  int statusValue( const std::string& name )
+  {
+    for ( const auto& e : net->getOutput() )
+    {
+      if ( e.event.find( name ) == 0 )
+      {
+        return std::stoi( e.event.substr( name.size() ));
+      }
+    }
+    return -1;
+  }
+
+  std::shared_ptr<NetMockSimpleTimed> net;
+  std::shared_ptr<HWMockTimed> hw;
+  std::shared_ptr<DebugInterfaceIgnoreMock> debug;
+  std::shared_ptr<TimeMockTimed> time;
+  std::shared_ptr<SampleTimerMock> timer;
+  std::shared_ptr<SoundSampler> sampler;
+  FS::SSound sound;
+  unsigned long long nowUs;
+};
+
+#endif
+
@@ -0,0 +1,123 @@
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+
+#include "sound_sampler.h"
+#include "test_mock_hardware.h"
+#include "test_mock_sample_timer.h"
+
+/// @brief Elements come out in the order they went in, across wrap around
+TEST( SPSC_RING, should_be_fifo )
+{
+  SpscRing< int, 4 > ring;
+  int out[4];
+
+  for ( int round = 0; round < 5; ++round )
+  {
+    ASSERT_TRUE( ring.push( round * 10 + 1 ));
+    ASSERT_TRUE( ring.push( round * 10 + 2 ));
+    ASSERT_TRUE( ring.push( round * 10 + 3 ));
+    ASSERT_EQ( 3u, ring.size() );
+    ASSERT_EQ( 2u, ring.pop( out, 2 ));
+    ASSERT_EQ( round * 10 + 1, out[0] );
+    ASSERT_EQ( round * 10 + 2, out[1] );
+    ASSERT_EQ( 1u, ring.pop( out, 4 ));
+    ASSERT_EQ( round * 10 + 3, out[0] );
+    ASSERT_EQ( 0u, ring.size() );
+  }
+}
+
+/// @brief A full ring refuses new elements
+TEST( SPSC_RING, should_refuse_when_full )
+{
+  SpscRing< int, 4 > ring;
+  for ( int i = 0; i < 4; ++i ) 
+  {
+    ASSERT_TRUE( ring.push( i ));
+  }
+  ASSERT_FALSE( ring.push( 4 ));
+  ASSERT_FALSE( ring.push( 4 ));
+  ASSERT_EQ( 2u, ring.getDropped() );
+  ring.discard();
+  ASSERT_EQ( 0u, ring.size() );
+  ASSERT_TRUE( ring.push( 5 ));
+}
+
+/// @brief A producer and consumer thread never lose or reorder elements
+TEST( SPSC_RING, should_work_across_threads )
+{
+  SpscRing< unsigned int, 64 > ring;
+  constexpr unsigned int total = 200000;
+
+  std::thread producer( [&] {
+    for ( unsigned int i = 0; i < total; ) 
+    {
+      if ( ring.push( i )) ++i;
+      else std::this_thread::yield();
+    }
+  });
+
+  unsigned int expected = 0;
+  unsigned int block[16];
+  while ( expected < total )
+  {
+    const std::size_t n = ring.pop( block, 16 );
+    if ( n == 0 ) std::this_thread::yield();
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+      ASSERT_EQ( expected, block[i] );
+      ++expected;
+    }
+  }
+  producer.join();
+}
+
+/// @brief The sampler reads the pin once per timer tick
+TEST( SOUND_SAMPLER, should_sample_at_the_timer_rate )
+{
+  auto hw = std::make_shared<HWMockTimed>( HWTimedEvents(), 
+    std::vector<unsigned short>{ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 } );
+  auto timer = std::make_shared<SampleTimerMock>( hw );
+  SoundSampler sampler( timer );
+
+  sampler.start( 100 );
+  ASSERT_TRUE( timer->isRunning() );
+  ASSERT_EQ( 100u, timer->getIntervalUs() );
+
+  timer->advanceTime( 1050 );
+  // Read as the timer fires, not when the ring is drained
+  ASSERT_EQ( 10u, hw->getAnalogReads() );
+  ASSERT_EQ( 10u, sampler.available() );
+
+  unsigned short out[ 20 ];
+  ASSERT_EQ( 10u, sampler.drain( out, 20 ));
+  ASSERT_EQ( 10u, hw->getAnalogReads() );
+  for ( unsigned short i = 0; i < 10; ++i )
+  {
+    ASSERT_EQ( i + 1, out[i] );
+  }
+  ASSERT_EQ( 0u, sampler.getOverruns() );
+
+  sampler.stop();
+  ASSERT_FALSE( timer->isRunning() );
+  timer->advanceTime( 1000 );
+  ASSERT_EQ( 0u, sampler.drain( out, 20 ));
+}
+
+/// @brief Samples that don't fit are counted, not silently lost
+TEST( SOUND_SAMPLER, should_count_overruns )
+{
+  auto hw = std::make_shared<HWMockTimed>( HWTimedEvents(), 
+    std::vector<unsigned short>{ 7 } );
+  auto timer = std::make_shared<SampleTimerMock>( hw );
+  SoundSampler sampler( timer );
+
+  sampler.start( 100 );
+  timer->advanceTime( 100 * ( SoundSampler::ringSize + 25 ));
+
+  ASSERT_EQ( 25u, sampler.getOverruns() );
+
+  std::vector< unsigned short > out( SoundSampler::ringSize * 2 );
+  ASSERT_EQ( SoundSampler::ringSize, sampler.drain( out.data(), out.size() ));
+}
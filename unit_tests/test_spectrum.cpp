@@ -0,0 +1,172 @@
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "fixed_fft.h"
+#include "fixed_math.h"
+#include "goertzel.h"
+
+namespace {
+
+constexpr double pi = 3.14159265358979323846;
+constexpr unsigned int sampleRate = 10000;
+
+/// @brief A 10 bit ADC reading of a sine wave on a 512 DC bias
+std::vector< unsigned short > adcTone( double hz, double amplitude, std::size_t n )
+{
+  std::vector< unsigned short > result;
+  for ( std::size_t i = 0; i < n; ++i )
+  {
+    result.push_back( (unsigned short) std::lround( 
+      512.0 + amplitude * std::sin( 2.0 * pi * hz * i / sampleRate )));
+  }
+  return result;
+}
+
+const std::array< GoertzelBandSpec, 4 > testBands = {{
+  { "hum",    100,  600 },
+  { "swarm",  200,  300 },
+  { "piping", 400,  500 },
+  { "high",   600, 2000 },
+}};
+
+}
+
+/// @brief Integer log and dB helpers
+TEST( FIXED_MATH, db10 )
+{
+  ASSERT_EQ( -1, BeeFocus::log2Floor( 0 ));
+  ASSERT_EQ( 0, BeeFocus::log2Floor( 1 ));
+  ASSERT_EQ( 10, BeeFocus::log2Floor( 1024 ));
+  ASSERT_EQ( 10, BeeFocus::log2Floor( 2047 ));
+  for ( uint64_t x : { 1ULL, 2ULL, 3ULL, 10ULL, 99ULL, 1000ULL, 123456ULL, 1ULL << 40 } )
+  {
+    ASSERT_NEAR( 10.0 * std::log10( (double) x ), BeeFocus::db10( x ), 0.51 );
+  }
+}
+
+/// @brief A sine wave on a bin shows up at that bin and its mirror
+TEST( FIXED_FFT, should_find_a_tone )
+{
+  using FFT = FixedFFT< 8 >;
+  FFT fft;
+  FFT::array_t re, im;
+  for ( std::size_t i = 0; i < FFT::size; ++i )
+  {
+    re[i] = (int16_t) std::lround( 16000.0 * std::cos( 2.0 * pi * 16 * i / FFT::size ));
+    im[i] = 0;
+  }
+  fft.transform( re, im );
+
+  for ( std::size_t i = 0; i < FFT::size; ++i )
+  {
+    const uint32_t mag = FFT::magnitudeSquared( re, im, i );
+    if ( i == 16 || i == FFT::size - 16 ) 
+    {
+      // 1/2 the amplitude on each side
+      ASSERT_NEAR( 8000.0, std::sqrt( (double) mag ), 80.0 );
+    }
+    else
+    {
+      ASSERT_LT( mag, 50u );
+    }
+  }
+}
+
+/// @brief An impulse has a flat spectrum
+TEST( FIXED_FFT, impulse_is_flat )
+{
+  using FFT = FixedFFT< 6 >;
+  FFT fft;
+  FFT::array_t re, im;
+  re.fill( 0 );
+  im.fill( 0 );
+  re[0] = 32767;
+  fft.transform( re, im );
+  for ( std::size_t i = 0; i < FFT::size; ++i )
+  {
+    ASSERT_NEAR( 32767 / 64, re[i], 1 );
+    ASSERT_NEAR( 0, im[i], 1 );
+  }
+}
+
+/// @brief A tone lands in the bands that contain it
+TEST( GOERTZEL, should_measure_band_energy )
+{
+  GoertzelBank< 4 > bank( testBands, sampleRate );
+  for ( auto s : adcTone( 450.0, 100.0, sampleRate ))
+  {
+    bank.insert( s );
+  }
+
+  // A sine wave with amplitude 100 has a mean square of 5000
+  ASSERT_NEAR( 5000.0, (double) bank.getMeanSquare( 2 ), 500.0 );   // piping
+  ASSERT_GT( bank.getMeanSquare( 0 ), 2500u );                      // hum
+  ASSERT_LT( bank.getMeanSquare( 1 ), 500u );                       // swarm
+  // 450 Hz is on the skirt of the wide 600-2000 Hz band's main lobe
+  ASSERT_LT( bank.getMeanSquare( 3 ), 2000u );                      // high
+}
+
+/// @brief The bias is removed, so silence has no energy
+TEST( GOERTZEL, should_ignore_dc )
+{
+  GoertzelBank< 4 > bank( testBands, sampleRate );
+  for ( std::size_t i = 0; i < sampleRate; ++i )
+  {
+    bank.insert( 700 );
+  }
+  for ( std::size_t b = 0; b < 4; ++b ) 
+  {
+    ASSERT_EQ( 0u, bank.getMeanSquare( b ));
+  }
+}
+
+/// @brief Benchmark - cost of the per window spectrum work
+///
+/// The ESP8266 runs at 80 MHz.  At 10 kHz sampling the Goertzel bank has
+/// to stay well under 8000 cycles per sample, and the FFT runs once per
+/// 256 samples.
+///
+TEST( SPECTRUM_BENCH, goertzel_and_fft )
+{
+  using clock = std::chrono::steady_clock;
+  const auto samples = adcTone( 250.0, 200.0, sampleRate );
+
+  GoertzelBank< 4 > bank( testBands, sampleRate );
+  const unsigned int windows = 20;
+  auto start = clock::now();
+  for ( unsigned int w = 0; w < windows; ++w )
+  {
+    bank.reset();
+    for ( auto s : samples ) 
+    {
+      bank.insert( s );
+    }
+  }
+  const double goertzelNs = std::chrono::duration<double, std::nano>( 
+    clock::now() - start ).count() / ( windows * samples.size() );
+  ASSERT_GT( bank.getMeanSquare( 1 ), 0u );
+
+  using FFT = FixedFFT< 8 >;
+  FFT fft;
+  FFT::array_t re, im;
+  const unsigned int ffts = 2000;
+  start = clock::now();
+  for ( unsigned int f = 0; f < ffts; ++f )
+  {
+    for ( std::size_t i = 0; i < FFT::size; ++i )
+    {
+      re[i] = (int16_t) (( samples[i] - 512 ) * 32 );
+      im[i] = 0;
+    }
+    fft.transform( re, im );
+  }
+  const double fftUs = std::chrono::duration<double, std::micro>( 
+    clock::now() - start ).count() / ffts;
+
+  std::cout << "Goertzel bank (4 bands): " << goertzelNs << " ns/sample\n";
+  std::cout << "FFT 256 points:          " << fftUs << " us/transform\n";
+}
@@ -0,0 +1,131 @@
+
+#include <gtest/gtest.h>
+
+#include "sample_sound.h"
+#include "snapshot.h"
+#include "state_machine.h"
+
+namespace {
+
+enum class Color { RED = 0, GREEN, BLUE, END };
+
+constexpr BeeFocus::EnumTable< Color, int, (std::size_t) Color::END > colorTable =
+{{
+  { Color::RED,   10 },
+  { Color::GREEN, 20 },
+  { Color::BLUE,  30 },
+}};
+
+constexpr BeeFocus::EnumTable< Color, int, (std::size_t) Color::END > missingEntry =
+{{
+  { Color::RED,   10 },
+  { Color::GREEN, 20 },
+}};
+
+constexpr BeeFocus::EnumTable< Color, int, (std::size_t) Color::END > outOfOrder =
+{{
+  { Color::RED,   10 },
+  { Color::BLUE,  30 },
+  { Color::GREEN, 20 },
+}};
+
+static_assert( colorTable.isDense(), "complete table is dense" );
+static_assert( !missingEntry.isDense(), "missing entries are caught" );
+static_assert( !outOfOrder.isDense(), "out of order entries are caught" );
+static_assert( colorTable[ Color::BLUE ] == 30, "lookups are constexpr" );
+
+}
+
+/// @brief Lookups index the table by enum value
+TEST( STATE_MACHINE, table_lookups_work )
+{
+  ASSERT_EQ( 10, colorTable[ Color::RED ] );
+  ASSERT_EQ( 20, colorTable[ Color::GREEN ] );
+  ASSERT_EQ( 30, colorTable[ Color::BLUE ] );
+}
+
+namespace {
+
+/// @brief Something to await
+struct Flag
+{
+  bool& set;
+  bool ready() const { return set; }
+  unsigned int pollUs() const { return 50; }
+};
+
+/// @brief Sleeps, then waits for a flag or a deadline, and counts laps
+class Stepper
+{
+  public:
+
+  enum class Point { START = 0, FIRST, SECOND, WAIT };
+
+  unsigned int loop()
+  {
+    BEEFOCUS_CO_BEGIN( co );
+    for ( ;; )
+    {
+      ++laps;
+      BEEFOCUS_CO_SLEEP( co, Point::FIRST, 10 );
+      BEEFOCUS_CO_SLEEP( co, Point::SECOND, 20 );
+      BEEFOCUS_CO_AWAIT_UNTIL( co, Point::WAIT, ( Flag{ flag } ), expired );
+    }
+    BEEFOCUS_CO_END( co );
+  }
+
+  BeeFocus::Coroutine co;
+  unsigned int laps = 0;
+  bool flag = false;
+  bool expired = false;
+};
+
+}
+
+/// @brief A coroutine picks up after each suspension
+TEST( STATE_MACHINE, coroutine_resumes_where_it_left_off )
+{
+  Stepper s;
+  ASSERT_EQ( 10u, s.loop() );
+  ASSERT_EQ( Stepper::Point::FIRST, s.co.getPoint< Stepper::Point >() );
+  ASSERT_EQ( 20u, s.loop() );
+  // Polls while the flag is down
+  ASSERT_EQ( 50u, s.loop() );
+  ASSERT_EQ( 50u, s.loop() );
+  ASSERT_EQ( 1u, s.laps );
+  s.flag = true;
+  ASSERT_EQ( 10u, s.loop() );
+  ASSERT_EQ( 2u, s.laps );
+
+  // A deadline ends the wait without the flag
+  s.flag = false;
+  ASSERT_EQ( 20u, s.loop() );
+  ASSERT_EQ( 50u, s.loop() );
+  s.expired = true;
+  ASSERT_EQ( 10u, s.loop() );
+  ASSERT_EQ( 3u, s.laps );
+}
+
+/// @brief A saved coroutine resumes at the same point
+TEST( STATE_MACHINE, coroutine_round_trips )
+{
+  Stepper before;
+  before.loop();
+  before.loop();
+  ASSERT_EQ( Stepper::Point::SECOND, before.co.getPoint< Stepper::Point >() );
+  SnapshotWriter out;
+  before.co.serialize( out );
+
+  Stepper after;
+  SnapshotReader in( out.getData().data(), out.getData().size() );
+  after.co.serialize( in );
+  ASSERT_TRUE( in.ok() );
+  // Goes straight on to the wait, without starting a lap
+  ASSERT_EQ( 50u, after.loop() );
+  ASSERT_EQ( 0u, after.laps );
+
+  after.co.restart();
+  ASSERT_EQ( 10u, after.loop() );
+  ASSERT_EQ( 1u, after.laps );
+}
+
@@ -0,0 +1,311 @@
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "state_saver.h"
+#include "storage_file.h"
+#include "histogram.h"
+#include "quantile_sketch.h"
+#include "rolling_histogram.h"
+#include "time_manager.h"
+#include "test_mock_debug.h"
+#include "test_sound_harness.h"
+
+namespace {
+
+/// @brief A fresh storage file for each test
+class StorageFileTest : public ::testing::Test
+{
+  protected:
+
+  void SetUp() override
+  {
+    path = std::string( "test_state_saver_" ) +
+      ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".bin";
+    std::remove( path.c_str() );
+  }
+
+  void TearDown() override
+  {
+    std::remove( path.c_str() );
+  }
+
+  std::string path;
+};
+
+/// @brief Something with a lot of state that rarely changes
+class BigState : public PersistentInterface
+{
+  public:
+
+  BigState() { data.fill( 0 ); }
+
+  void save( SnapshotWriter& out ) override { out.io( data ); }
+
+  bool restore( SnapshotReader& in ) override
+  {
+    std::array< unsigned int, 256 > restored;
+    in.io( restored );
+    if ( !in.ok() || !in.atEnd() ) {
+      return false;
+    }
+    data = restored;
+    return true;
+  }
+
+  std::array< unsigned int, 256 > data;
+};
+
+/// @brief Time source with no network; every query fails
+class TimeNoNetwork : public TimeInterface
+{
+  public:
+
+  unsigned int secondsSince1970() override { return 0; }
+  unsigned int msSinceDeviceStart() override { return ms; }
+
+  unsigned int ms = 0;
+};
+
+using Parts = std::vector< std::shared_ptr< PersistentInterface >>;
+
+}
+
+/// @brief Containers round trip through a snapshot
+TEST( SNAPSHOT, containers_round_trip )
+{
+  using Auto = Histogram< unsigned int, 10, AutoRangeBins< unsigned int, 10 >>;
+  RollingHistogram< Auto, 3 > rolling( 0u, 9u );
+  QuantileSketch< unsigned int, 16 > sketch;
+  rolling.advanceTo( 5 );
+  rolling.insert( 3u );
+  rolling.advanceTo( 6 );
+  rolling.insert( 300u );
+  for ( unsigned int i = 1; i < 100000; i *= 3 ) {
+    sketch.insert( i );
+  }
+
+  SnapshotWriter out;
+  rolling.serialize( out );
+  sketch.serialize( out );
+
+  RollingHistogram< Auto, 3 > rolling2( 0u, 9u );
+  QuantileSketch< unsigned int, 16 > sketch2;
+  SnapshotReader in( out.getData().data(), out.getData().size() );
+  rolling2.serialize( in );
+  sketch2.serialize( in );
+  ASSERT_TRUE( in.ok() );
+  ASSERT_TRUE( in.atEnd() );
+
+  ASSERT_EQ( 6u, rolling2.getSlotNumber() );
+  ASSERT_EQ( 2u, rolling2.getSlotsFilled() );
+  ASSERT_EQ( rolling.getSlot( 0 ).getLowerEdge( 1 ), rolling2.getSlot( 0 ).getLowerEdge( 1 ));
+  ASSERT_EQ( 2u, rolling2.getView( 2 ).getTotal() );
+  ASSERT_EQ( sketch.getCounts(), sketch2.getCounts() );
+  ASSERT_EQ( sketch.getQuantile( 50 ), sketch2.getQuantile( 50 ));
+
+  // Short data fails rather than reading garbage
+  SnapshotReader shortIn( out.getData().data(), out.getData().size() - 1 );
+  rolling2.serialize( shortIn );
+  sketch2.serialize( shortIn );
+  ASSERT_FALSE( shortIn.ok() );
+}
+
+/// @brief Nothing to restore on the first boot
+TEST_F( StorageFileTest, restore_without_snapshot )
+{
+  auto big = std::make_shared< BigState >();
+  StateSaver saver( std::make_shared< StorageFile >( path ), 
+    std::make_shared< DebugInterfaceIgnoreMock >(), Parts{ big } );
+  ASSERT_FALSE( saver.restore() );
+}
+
+/// @brief Only pages that changed are written
+TEST_F( StorageFileTest, saves_are_incremental )
+{
+  auto big = std::make_shared< BigState >();
+  auto storage = std::make_shared< StorageFile >( path );
+  StateSaver saver( storage, std::make_shared< DebugInterfaceIgnoreMock >(), Parts{ big } );
+
+  // 4 byte part size + 1024 bytes of data = 9 pages.
+  ASSERT_TRUE( saver.save() );
+  ASSERT_EQ( 9u, saver.getPagesWritten() );
+  ASSERT_TRUE( saver.save() );
+  ASSERT_EQ( 9u, saver.getPagesWritten() );
+  big->data[ 100 ] = 42;
+  ASSERT_TRUE( saver.save() );
+  ASSERT_EQ( 10u, saver.getPagesWritten() );
+
+  // A new boot restores, then only writes what changes after.
+  auto big2 = std::make_shared< BigState >();
+  StateSaver saver2( storage, std::make_shared< DebugInterfaceIgnoreMock >(), Parts{ big2 } );
+  ASSERT_TRUE( saver2.restore() );
+  ASSERT_EQ( 42u, big2->data[ 100 ] );
+  ASSERT_TRUE( saver2.save() );
+  ASSERT_EQ( 0u, saver2.getPagesWritten() );
+}
+
+/// @brief Damaged or mismatched snapshots are ignored
+TEST_F( StorageFileTest, bad_snapshots_are_ignored )
+{
+  auto big = std::make_shared< BigState >();
+  auto storage = std::make_shared< StorageFile >( path );
+  auto debug = std::make_shared< DebugInterfaceIgnoreMock >();
+  big->data.fill( 7 );
+  StateSaver( storage, debug, Parts{ big } ).save();
+
+  // Different parts
+  auto other = std::make_shared< BigState >();
+  ASSERT_FALSE( StateSaver( storage, debug, Parts{ other, other } ).restore() );
+
+  // An older layout, say from before an OTA update
+  const uint16_t oldVersion = 2;
+  storage->write( 4, reinterpret_cast< const uint8_t* >( &oldVersion ), sizeof( oldVersion ));
+  storage->commit();
+  ASSERT_FALSE( StateSaver( storage, debug, Parts{ other } ).restore() );
+  ASSERT_EQ( 0u, other->data[ 0 ] );
+  StateSaver( storage, debug, Parts{ big } ).save();
+
+  // A size that would take all the memory there is
+  const uint32_t hugeSize = 0xffffffff;
+  storage->write( 8, reinterpret_cast< const uint8_t* >( &hugeSize ), sizeof( hugeSize ));
+  storage->commit();
+  ASSERT_FALSE( StateSaver( storage, debug, Parts{ other } ).restore() );
+  StateSaver( storage, debug, Parts{ big } ).save();
+
+  // Flip a byte in the payload
+  const uint8_t junk = 0xff;
+  storage->write( 100, &junk, 1 );
+  storage->commit();
+  ASSERT_FALSE( StateSaver( storage, debug, Parts{ other } ).restore() );
+  ASSERT_EQ( 0u, other->data[ 0 ] );
+}
+
+/// @brief The wall clock comes back from a snapshot if the query fails
+TEST_F( StorageFileTest, time_manager_restores_wall_clock )
+{
+  auto storage = std::make_shared< StorageFile >( path );
+  auto debug = std::make_shared< DebugInterfaceIgnoreMock >();
+  auto before = std::make_shared< TimeManager >( std::make_shared< TimeMockTimed >( 5000 ));
+  StateSaver( storage, debug, Parts{ before } ).save();
+
+  // No network after the reboot, so the base time reads 0.
+  auto baseAfter = std::make_shared< TimeNoNetwork >();
+  auto after = std::make_shared< TimeManager >( baseAfter );
+  ASSERT_TRUE( StateSaver( storage, debug, Parts{ after } ).restore() );
+  baseAfter->ms = 2000;
+  ASSERT_EQ( 5002u, after->secondsSince1970() );
+}
+
+/// @brief SSound picks up its history and state after a reboot
+TEST_F( StorageFileTest, sound_resumes_after_reboot )
+{
+  auto storage = std::make_shared< StorageFile >( path );
+  auto debug = std::make_shared< DebugInterfaceIgnoreMock >();
+  auto noDelete = []( FS::SSound* ) {};
+
+  SoundHarness before( FS::SampleMode::POLLED, {} );
+  before.runFor( 7000 );
+  {
+    std::shared_ptr< FS::SSound > sound( &before.sound, noDelete );
+    ASSERT_TRUE( StateSaver( storage, debug, Parts{ sound } ).save() );
+  }
+
+  SoundHarness after( FS::SampleMode::POLLED, {{ 100, "status" }} );
+  {
+    std::shared_ptr< FS::SSound > sound( &after.sound, noDelete );
+    ASSERT_TRUE( StateSaver( storage, debug, Parts{ sound } ).restore() );
+  }
+  // Commands are checked once a second while pausing between windows.
+  after.runFor( 1500 );
+
+  // 7 s is two windows and a pause, and the history came back.
+  ASSERT_EQ( 2, after.statusValue( "last hour n" ));
+  ASSERT_EQ( 14, after.statusValue( "leq dB" ));
+  ASSERT_EQ( 14, after.statusValue( "leq p50 dB" ));
+
+  // and it keeps sampling where it left off.
+  after.runFor( 4000 );
+  ASSERT_GT( after.hw->getAnalogReads(), 9900u );
+}
+
+/// @brief The downtime is only known once the wall clock is synced
+TEST_F( StorageFileTest, sound_waits_for_sync_to_catch_up_downtime )
+{
+  auto storage = std::make_shared< StorageFile >( path );
+  auto debug = std::make_shared< DebugInterfaceIgnoreMock >();
+  auto noDelete = []( FS::SSound* ) {};
+
+  // Saved at 1007 s, back up at 1500 s
+  SoundHarness before( FS::SampleMode::POLLED, {}, 1000 );
+  before.runFor( 7000 );
+  {
+    std::shared_ptr< FS::SSound > sound( &before.sound, noDelete );
+    ASSERT_TRUE( StateSaver( storage, debug, Parts{ sound } ).save() );
+  }
+
+  SoundHarness unsynced( FS::SampleMode::POLLED, {{ 100, "status" }}, 1500 );
+  unsynced.time->setSynced( false );
+  {
+    std::shared_ptr< FS::SSound > sound( &unsynced.sound, noDelete );
+    ASSERT_TRUE( StateSaver( storage, debug, Parts{ sound } ).restore() );
+  }
+  unsynced.runFor( 1500 );
+  ASSERT_EQ( 0, unsynced.statusValue( "downtime s" ));
+
+  // Synced after running a while; the downtime is still to the restore
+  SoundHarness synced( FS::SampleMode::POLLED, {{ 2100, "status" }}, 1500 );
+  synced.time->setSynced( false );
+  {
+    std::shared_ptr< FS::SSound > sound( &synced.sound, noDelete );
+    ASSERT_TRUE( StateSaver( storage, debug, Parts{ sound } ).restore() );
+  }
+  synced.runFor( 1000 );
+  synced.time->setSynced( true );
+  synced.runFor( 2500 );
+  ASSERT_EQ( 493, synced.statusValue( "downtime s" ));
+}
+
+/// @brief A bad snapshot leaves SSound as it was
+TEST_F( StorageFileTest, sound_ignores_a_short_snapshot )
+{
+  SoundHarness before( FS::SampleMode::POLLED, {} );
+  before.runFor( 7000 );
+  SnapshotWriter out;
+  before.sound.save( out );
+
+  // Starts from scratch; one window, not the two saved plus one
+  SoundHarness after( FS::SampleMode::POLLED, {{ 2500, "status" }} );
+  SnapshotReader in( out.getData().data(), out.getData().size() - 1 );
+  ASSERT_FALSE( after.sound.restore( in ));
+  after.runFor( 3500 );
+  ASSERT_EQ( 1, after.statusValue( "last hour n" ));
+  ASSERT_EQ( 0, after.statusValue( "downtime s" ));
+}
+
+/// @brief A snapshot with more in it than expected isn't half applied
+TEST_F( StorageFileTest, parts_ignore_a_long_snapshot )
+{
+  SoundHarness before( FS::SampleMode::POLLED, {} );
+  before.runFor( 7000 );
+  SnapshotWriter out;
+  before.sound.save( out );
+  out.io( uint8_t( 0 ));
+
+  SoundHarness after( FS::SampleMode::POLLED, {{ 2500, "status" }} );
+  SnapshotReader in( out.getData().data(), out.getData().size() );
+  ASSERT_FALSE( after.sound.restore( in ));
+  after.runFor( 3500 );
+  ASSERT_EQ( 1, after.statusValue( "last hour n" ));
+
+  auto base = std::make_shared< TimeNoNetwork >();
+  TimeManager time( base );
+  SnapshotWriter timeOut;
+  timeOut.io( 5000u );
+  timeOut.io( uint8_t( 0 ));
+  SnapshotReader timeIn( timeOut.getData().data(), timeOut.getData().size() );
+  ASSERT_FALSE( time.restore( timeIn ));
+  ASSERT_EQ( 0u, time.secondsSince1970() );
+}
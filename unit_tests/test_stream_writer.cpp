@@ -0,0 +1,241 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include "stream_writer.h"
+#include "test_mock_clock.h"
+
+namespace {
+
+/// @brief A socket with a window that tests open and close
+class SinkMock : public StreamSink
+{
+  public:
+  bool isOpen() override { return open; }
+  std::size_t writeSpace() override { return window; }
+  std::size_t send( const char* data, std::size_t n ) override
+  {
+    n = std::min( n, window );
+    received.append( data, n );
+    window -= n;
+    ++sends;
+    return n;
+  }
+
+  bool open = true;
+  std::size_t window = 1000000;
+  std::string received;
+  unsigned int sends = 0;
+};
+
+/// @brief Waiting moves the clock, and may open a window
+class WaiterMock : public WakeInterface
+{
+  public:
+  WaiterMock( std::shared_ptr< ClockMock > clockArg ) : clock{ clockArg } {}
+  bool hasInput() override { return false; }
+  bool waitUs( unsigned int timeoutUs, bool ) override
+  {
+    clock->advanceTime( timeoutUs );
+    if ( drains ) {
+      drains->window += 64;
+    }
+    return false;
+  }
+  std::shared_ptr< ClockMock > clock;
+  SinkMock* drains = nullptr;
+};
+
+using Writer = StreamWriter< 16, 4, 2 >;
+
+const StreamWriterConfig dropConfig{ 32, 1000, StreamWriterConfig::WhenFull::DROP, 0 };
+const StreamWriterConfig blockConfig{ 32, 1000, StreamWriterConfig::WhenFull::BLOCK, 10000 };
+
+void write( Writer& writer, const std::string& s )
+{
+  writer.write( s.data(), s.size() );
+}
+
+}
+
+/// @brief Small writes wait for the size threshold or the deadline
+TEST( STREAM_WRITER, should_coalesce_until_size_or_deadline )
+{
+  auto clock = std::make_shared< ClockMock >();
+  WaiterMock waiter( clock );
+  Writer writer( clock, waiter, dropConfig );
+  SinkMock sink;
+  writer.attach( 0, &sink );
+  ASSERT_EQ( ~0u, writer.getUsUntilDue() );
+
+  for ( int i = 0; i < 3; ++i )
+  {
+    write( writer, "abc\n" );
+    writer.flush();
+    clock->advanceTime( 100 );
+  }
+  ASSERT_EQ( "", sink.received );
+  ASSERT_EQ( 3u, writer.getStats().deferred );
+  ASSERT_EQ( 700u, writer.getUsUntilDue() );
+
+  // The deadline passes
+  clock->advanceTime( 700 );
+  writer.flush();
+  ASSERT_EQ( "abc\nabc\nabc\n", sink.received );
+  ASSERT_EQ( 1u, writer.getStats().flushes );
+
+  // A packet's worth goes at once, without a flush.  The rest waits.
+  const std::string big( 40, 'x' );
+  write( writer, big );
+  ASSERT_EQ( "abc\nabc\nabc\n" + big.substr( 8 ), sink.received );
+  ASSERT_EQ( 52u, writer.getStats().bytesWritten );
+  ASSERT_EQ( 1000u, writer.getUsUntilDue() );
+}
+
+/// @brief Writes bigger than the whole buffer are chunked through it
+TEST( STREAM_WRITER, should_stream_large_writes )
+{
+  auto clock = std::make_shared< ClockMock >();
+  WaiterMock waiter( clock );
+  Writer writer( clock, waiter, dropConfig );
+  SinkMock sink;
+  writer.attach( 1, &sink );
+
+  std::string big;
+  for ( int i = 0; i < 500; ++i ) {
+    big += (char) ( 'a' + i % 26 );
+  }
+  write( writer, big );
+  writer.send();
+  ASSERT_EQ( big, sink.received );
+  ASSERT_EQ( 0u, writer.getStats().droppedBytes );
+}
+
+/// @brief With DROP, a full window makes only that sink skip
+TEST( STREAM_WRITER, should_drop_for_a_full_window )
+{
+  auto clock = std::make_shared< ClockMock >();
+  WaiterMock waiter( clock );
+  Writer writer( clock, waiter, dropConfig );
+  SinkMock fast;
+  SinkMock slow;
+  slow.window = 0;
+  writer.attach( 0, &fast );
+  writer.attach( 1, &slow );
+
+  const std::string big( 200, 'y' );
+  write( writer, big );
+  writer.send();
+  ASSERT_EQ( big, fast.received );
+  ASSERT_EQ( "", slow.received );
+  ASSERT_GT( writer.getStats().droppedBytes, 0u );
+  ASSERT_EQ( 0u, writer.getStats().blockedUs );
+
+  // The backlog is retried soon, and goes once the window opens
+  ASSERT_EQ( 1000u, writer.getUsUntilDue() );
+  slow.window = 1000;
+  writer.flush();
+  ASSERT_EQ( 200u, slow.received.size() + writer.getStats().droppedBytes );
+}
+
+/// @brief With BLOCK, write waits for the window, up to a limit
+TEST( STREAM_WRITER, should_block_for_a_full_window )
+{
+  auto clock = std::make_shared< ClockMock >();
+  WaiterMock waiter( clock );
+  Writer writer( clock, waiter, blockConfig );
+  SinkMock slow;
+  slow.window = 0;
+  waiter.drains = &slow;
+  writer.attach( 0, &slow );
+
+  const std::string big( 200, 'z' );
+  write( writer, big );
+  // The last of it waits for the window like any backlog
+  for ( int i = 0; i < 4 && slow.received.size() < big.size(); ++i )
+  {
+    waiter.waitUs( writer.getUsUntilDue(), false );
+    writer.flush();
+  }
+  ASSERT_EQ( big, slow.received );
+  ASSERT_EQ( 0u, writer.getStats().droppedBytes );
+  ASSERT_GT( writer.getStats().blockedUs, 0u );
+  ASSERT_LE( writer.getStats().blockedUs, 10000u );
+
+  // A window that never opens costs maxBlockUs, then data is dropped
+  waiter.drains = nullptr;
+  slow.window = 0;
+  const unsigned int blocked = writer.getStats().blockedUs;
+  write( writer, big );
+  ASSERT_GT( writer.getStats().droppedBytes, 0u );
+  ASSERT_GE( writer.getStats().blockedUs - blocked, 10000u );
+}
+
+/// @brief A stuck window is retried less and less often, then let go
+TEST( STREAM_WRITER, should_back_off_from_a_stuck_sink )
+{
+  auto clock = std::make_shared< ClockMock >();
+  WaiterMock waiter( clock );
+  Writer writer( clock, waiter, dropConfig );
+  SinkMock sink;
+  sink.window = 0;
+  writer.attach( 0, &sink );
+  write( writer, "0123456789" );
+  writer.send();
+  ASSERT_EQ( 2000u, writer.getUsUntilDue() );
+  clock->advanceTime( 500 );
+  ASSERT_EQ( 1500u, writer.getUsUntilDue() );
+
+  unsigned int retries = 0;
+  while ( writer.getUsUntilDue() != ~0u )
+  {
+    ASSERT_LE( writer.getUsUntilDue(), 64000u );
+    clock->advanceTime( writer.getUsUntilDue() );
+    writer.flush();
+    ++retries;
+  }
+  // Ten seconds of 64 ms retries, not ten thousand 1 ms ones
+  ASSERT_LT( retries, 200u );
+  ASSERT_EQ( 1u, writer.getStats().stalledSinks );
+  ASSERT_EQ( 10u, writer.getStats().droppedBytes );
+}
+
+/// @brief Any progress goes back to retrying soon
+TEST( STREAM_WRITER, should_retry_soon_after_progress )
+{
+  auto clock = std::make_shared< ClockMock >();
+  WaiterMock waiter( clock );
+  Writer writer( clock, waiter, dropConfig );
+  SinkMock sink;
+  sink.window = 0;
+  writer.attach( 0, &sink );
+  write( writer, "0123456789" );
+  for ( int i = 0; i < 4; ++i ) {
+    writer.send();
+  }
+  ASSERT_EQ( 16000u, writer.getUsUntilDue() );
+  sink.window = 4;
+  writer.send();
+  ASSERT_EQ( 1000u, writer.getUsUntilDue() );
+  ASSERT_EQ( "0123", sink.received );
+  ASSERT_EQ( 0u, writer.getStats().stalledSinks );
+}
+
+/// @brief A closed sink is let go, along with its backlog
+TEST( STREAM_WRITER, should_detach_closed_sinks )
+{
+  auto clock = std::make_shared< ClockMock >();
+  WaiterMock waiter( clock );
+  Writer writer( clock, waiter, dropConfig );
+  SinkMock sink;
+  sink.window = 0;
+  writer.attach( 0, &sink );
+  write( writer, "0123456789" );
+  writer.send();
+  sink.open = false;
+  writer.send();
+  ASSERT_EQ( 10u, writer.getStats().droppedBytes );
+  write( writer, "more" );
+  ASSERT_EQ( ~0u, writer.getUsUntilDue() );
+}
@@ -0,0 +1,142 @@
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "streaming_stats.h"
+
+using TestStats = StreamingStats< unsigned short >;
+
+/// @brief An empty stream reports zeros
+TEST( STREAMING_STATS, should_be_empty_after_reset )
+{
+  TestStats s;
+  s.insert( 10 );
+  s.reset();
+
+  ASSERT_EQ( 0u, s.getCount() );
+  ASSERT_EQ( 0u, s.getMean() );
+  ASSERT_EQ( 0u, s.getVariance() );
+  ASSERT_EQ( 0u, s.getAbsTotal() );
+  ASSERT_EQ( 0u, s.getMeanAbsDev() );
+}
+
+/// @brief Small hand checked example
+TEST( STREAMING_STATS, should_work_for_small_streams )
+{
+  TestStats s;
+  for ( unsigned short i : { 2, 4, 4, 4, 5, 5, 7, 9 } )
+  {
+    s.insert( i );
+  }
+
+  ASSERT_EQ( 8u, s.getCount() );
+  ASSERT_EQ( 2u, s.getMin() );
+  ASSERT_EQ( 9u, s.getMax() );
+  ASSERT_EQ( 5u, s.getMean() );
+  ASSERT_EQ( 4u, s.getVariance() );
+}
+
+namespace {
+
+/// @brief Population variance, rounded down, the long way
+unsigned int twoPassVariance( const std::vector< unsigned short >& raw )
+{
+  long long sum = 0;
+  long long sumSq = 0;
+  for ( auto i : raw )
+  {
+    sum += i;
+    sumSq += (long long) i * i;
+  }
+  const long long n = raw.size();
+  return ( n * sumSq - sum * sum ) / ( n * n );
+}
+
+}
+
+/// @brief Matches the two pass computation SSound used to do
+TEST( STREAMING_STATS, should_match_two_pass_on_microphone_data )
+{
+  // Roughly what the microphone looks like - a DC bias around 200 with
+  // a growing triangle wave on top.
+  std::vector< unsigned short > raw;
+  for ( unsigned int count = 0; count < 10000; ++count )
+  {
+    const int pos = (( count / 2 ) & 0xfff ) / 256;
+    raw.push_back( 200 + (( count & 1 ) ? pos : -pos ));
+  }
+
+  unsigned int mean = 0;
+  for ( auto i : raw ) { mean += i; }
+  mean /= raw.size();
+
+  unsigned int absTotal = 0;
+  for ( auto i : raw )
+  {
+    const int dev = ((int) mean) - ((int) i );
+    absTotal += dev < 0 ? -dev : dev;
+  }
+
+  TestStats s;
+  for ( auto i : raw ) { s.insert( i ); }
+
+  ASSERT_EQ( raw.size(), s.getCount() );
+  ASSERT_EQ( mean, s.getMean() );
+  ASSERT_EQ( 185u, s.getMin() );
+  ASSERT_EQ( 215u, s.getMax() );
+  ASSERT_EQ( absTotal, s.getAbsTotal() );
+  ASSERT_EQ( twoPassVariance( raw ), s.getVariance() );
+}
+
+/// @brief The mean moving slowly late in the window doesn't bias the variance
+TEST( STREAMING_STATS, should_follow_a_slowly_drifting_mean )
+{
+  // Steady for most of the window, then the bias creeps up by a count
+  // every 500 samples, with a small signal on top.
+  std::vector< unsigned short > raw;
+  for ( unsigned int count = 0; count < 10000; ++count )
+  {
+    const int drift = count < 6000 ? 0 : ( count - 6000 ) / 500;
+    raw.push_back( 500 + drift + (( count & 1 ) ? 3 : -3 ));
+  }
+
+  TestStats s;
+  for ( auto i : raw ) { s.insert( i ); }
+
+  ASSERT_EQ( twoPassVariance( raw ), s.getVariance() );
+  ASSERT_EQ( 14u, s.getVariance() );
+}
+
+/// @brief Deviations are from the window's own mean, whatever came first
+TEST( STREAMING_STATS, should_measure_from_its_own_mean )
+{
+  TestStats s;
+  for ( unsigned short i : { 10, 4, 16, 10, 13 } )
+  {
+    s.insert( i );
+  }
+  ASSERT_EQ( 10u, s.getMean() );
+  ASSERT_EQ( 15u, s.getAbsTotal() );
+  ASSERT_EQ( 3u, s.getMeanAbsDev() );
+
+  s.reset();
+  s.insert( 7 );
+  s.insert( 9 );
+  s.insert( 11 );
+  ASSERT_EQ( 9u, s.getMean() );
+  ASSERT_EQ( 4u, s.getAbsTotal() );
+}
+
+/// @brief Full scale 16 bit samples don't overflow the accumulators
+TEST( STREAMING_STATS, should_not_overflow )
+{
+  TestStats s;
+  for ( unsigned int i = 0; i < 100000; ++i )
+  {
+    s.insert( ( i & 1 ) ? 0xffff : 0 );
+  }
+
+  ASSERT_EQ( 100000u, s.getCount() );
+  ASSERT_EQ( 0x7fffu, s.getMean() );
+  ASSERT_NEAR( 0x8000u * 0x8000u, s.getVariance(), 0x8000u * 0x8000u / 1000 );
+}
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "data_mover.h"
+#include "net_interface.h"
+#include "telemetry_decode.h"
+#include "telemetry_frame.h"
+#include "temperature_interface.h"
+#include "test_mock_time.h"
+
+namespace {
+
+class TempMock : public TempInterface
+{
+  public:
+  float readTemperature() override { return celsius; }
+  float readHumidity() override { return 55.5f; }
+  float celsius = 21.3f;
+};
+
+/// @brief Keeps the raw bytes written, which needn't end in a newline
+class NetCapture : public NetInterface
+{
+  public:
+  bool getString( std::string& ) override { return false; }
+  std::streamsize write( const char_type* s, std::streamsize n ) override
+  {
+    bytes.insert( bytes.end(), s, s + n );
+    return n;
+  }
+  void flush() override {}
+  unsigned int loop() override { return 5000000; }
+  const char* debugName() override { return "NetCapture"; }
+  std::unique_ptr< NetConnection > connect( const std::string&, unsigned int ) override
+  {
+    return nullptr;
+  }
+  std::vector< uint8_t > bytes;
+};
+
+const auto temperature = TelemetryFrame::Type::TEMPERATURE;
+
+}
+
+/// @brief Readings decode to what was added
+TEST( TELEMETRY_FRAME, should_round_trip )
+{
+  TelemetryFrame frame( 0x12345678 );
+  const uint64_t base = 1760000000000ULL;
+  frame.add( temperature, 0, base, 213 );
+  frame.add( temperature, 1, base + 1000, -40 );
+  frame.add( temperature, 0, base + 2003, 214 );
+  frame.add( temperature, 0, base + 2003, -2147483647 - 1 );
+  frame.add( temperature, 1, base + 90000000, 2147483647 );
+  const std::vector< uint8_t >& bytes = frame.finish();
+  ASSERT_EQ( bytes, frame.finish() );
+
+  std::vector< TelemetryReading > readings;
+  ASSERT_EQ( bytes.size(), decodeTelemetryFrame( bytes.data(), bytes.size(), readings ));
+  ASSERT_EQ( 5u, readings.size() );
+  ASSERT_EQ( 0x12345678u, readings[1].deviceId );
+  ASSERT_EQ( 1u, readings[1].channel );
+  ASSERT_EQ( base + 1000, readings[1].timeMs );
+  ASSERT_EQ( -40, readings[1].value );
+  ASSERT_EQ( base + 2003, readings[2].timeMs );
+  ASSERT_EQ( 214, readings[2].value );
+  ASSERT_EQ( -2147483647 - 1, readings[3].value );
+  ASSERT_EQ( base + 90000000, readings[4].timeMs );
+  ASSERT_EQ( 2147483647, readings[4].value );
+  ASSERT_EQ( temperature, readings[4].type );
+
+  // Readings can be added after finish()
+  ASSERT_TRUE( frame.add( temperature, 0, base + 90000000, 0 ));
+  readings.clear();
+  ASSERT_NE( 0u, decodeTelemetryFrame( frame.finish().data(), frame.finish().size(), readings ));
+  ASSERT_EQ( 6u, readings.size() );
+}
+
+/// @brief Readings on a schedule with values moving by 1 take 9 bits
+TEST( TELEMETRY_FRAME, should_be_compact )
+{
+  TelemetryFrame frame( 1 );
+  for ( int i = 0; i < 30; ++i ) {
+    ASSERT_TRUE( frame.add( temperature, 0, 1760000000000ULL + i * 1000, 213 + ( i & 1 )));
+  }
+  // The first reading is 13 bits and the second, which sets the gap, 24
+  const std::size_t seriesBits = 13 + 24 + 28 * 9;
+  ASSERT_EQ( TelemetryFrame::headerSize + 2 + SeriesEncoder::headerSize +
+    ( seriesBits + 7 ) / 8 + TelemetryFrame::crcSize, frame.finish().size() );
+}
+
+/// @brief A full channel block ends the frame
+TEST( TELEMETRY_FRAME, should_fill_up )
+{
+  TelemetryFrame frame( 1 );
+  int added = 0;
+  while ( frame.add( temperature, 0, 1000ULL * added, added * 100003 )) {
+    ++added;
+  }
+  ASSERT_GT( added, 10 );
+  ASSERT_LT( added, 255 );
+  std::vector< TelemetryReading > readings;
+  const std::vector< uint8_t >& bytes = frame.finish();
+  ASSERT_EQ( bytes.size(), decodeTelemetryFrame( bytes.data(), bytes.size(), readings ));
+  ASSERT_EQ( (std::size_t) added, readings.size() );
+  ASSERT_EQ( ( added - 1 ) * 100003, readings.back().value );
+}
+
+/// @brief Frames are found among text; damaged ones are skipped
+TEST( TELEMETRY_FRAME, should_find_frames_in_a_capture )
+{
+  TelemetryFrame frame( 7 );
+  frame.add( temperature, 0, 5000, 100 );
+  frame.add( temperature, 0, 6000, 101 );
+  const std::vector< uint8_t > good = frame.finish();
+  std::vector< uint8_t > bad = good;
+  bad[ TelemetryFrame::headerSize ] ^= 1;
+
+  std::vector< uint8_t > capture;
+  const std::string text = "# Got: status\n\xb5 not a frame\n";
+  capture.insert( capture.end(), text.begin(), text.end() );
+  capture.insert( capture.end(), good.begin(), good.end() );
+  capture.insert( capture.end(), bad.begin(), bad.end() );
+  capture.insert( capture.end(), text.begin(), text.end() );
+  capture.insert( capture.end(), good.begin(), good.end() - 1 );   // cut short
+
+  std::vector< TelemetryReading > readings;
+  const TelemetryScan scan = findTelemetryFrames( capture, readings );
+  ASSERT_EQ( 1u, scan.frames );
+  ASSERT_EQ( 2u, scan.badFrames );
+  ASSERT_EQ( 2u, readings.size() );
+
+  std::ostringstream out;
+  writeTelemetry( out, readings );
+  ASSERT_EQ( "00000007 5000 temperature 0 100\n"
+             "00000007 6000 temperature 0 101\n", out.str() );
+}
+
+/// @brief DataMover sends one frame per N readings, once the time is known
+TEST( TELEMETRY_FRAME, should_batch_data_mover_readings )
+{
+  auto net = std::make_shared< NetCapture >();
+  auto temp = std::make_shared< TempMock >();
+  auto unknownTime = std::make_shared< TimeMockTimed >( 0 );
+  DataMover waiting( "sim", temp, net, unknownTime, 3 );
+  for ( int i = 0; i < 5; ++i ) {
+    ASSERT_EQ( 1000000u, waiting.loop() );
+  }
+  ASSERT_TRUE( net->bytes.empty() );
+
+  auto time = std::make_shared< TimeMockTimed >( 1760000000 );
+  DataMover mover( "sim", temp, net, time, 3 );
+  for ( int i = 0; i < 7; ++i )
+  {
+    mover.loop();
+    time->advanceTime( 1000 );
+    temp->celsius += 0.1f;
+  }
+
+  // Temperature and humidity each second
+  std::vector< TelemetryReading > readings;
+  const TelemetryScan scan = findTelemetryFrames( net->bytes, readings );
+  ASSERT_EQ( 2u, scan.frames );
+  ASSERT_EQ( 0u, scan.badFrames );
+  ASSERT_EQ( 12u, readings.size() );
+  ASSERT_EQ( TelemetryFrame::deviceIdFor( "sim" ), readings[0].deviceId );
+  ASSERT_EQ( 1760000000000ULL, readings[0].timeMs );
+  ASSERT_EQ( temperature, readings[0].type );
+  ASSERT_EQ( 213, readings[0].value );
+  ASSERT_EQ( TelemetryFrame::Type::HUMIDITY, readings[1].type );
+  ASSERT_EQ( 555, readings[1].value );
+  ASSERT_EQ( 1760000005000ULL, readings[10].timeMs );
+  ASSERT_NEAR( 218, readings[10].value, 1 );
+}
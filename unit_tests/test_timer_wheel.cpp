@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "timer_wheel.h"
+
+namespace {
+
+/// @brief Small, repeatable pseudo random numbers
+class Lcg
+{
+  public:
+  explicit Lcg( uint64_t seed ) : state{ seed } {}
+  uint64_t next()
+  {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return state >> 17;
+  }
+  private:
+  uint64_t state;
+};
+
+using Pending = std::pair< uint64_t, unsigned int >;
+using ReferenceQueue = std::priority_queue< Pending, std::vector< Pending >,
+  std::greater< Pending >>;
+
+}
+
+/// @brief Timers come out in deadline order, ties broken by id
+TEST( TIMER_WHEEL, should_expire_in_deadline_order )
+{
+  TimerWheel wheel;
+  for ( unsigned int i = 0; i < 4; ++i ) {
+    wheel.addTimer();
+  }
+  wheel.schedule( 0, 5000 );
+  wheel.schedule( 1, 70 );
+  wheel.schedule( 2, 5000 );
+  wheel.schedule( 3, 3 );
+
+  ASSERT_EQ( 3u, wheel.nextDeadline() );
+  ASSERT_EQ( std::vector< unsigned int >{ 3 }, wheel.advanceTo( 3 ));
+  ASSERT_EQ( 70u, wheel.nextDeadline() );
+  ASSERT_EQ( std::vector< unsigned int >{ 1 }, wheel.advanceTo( 70 ));
+  ASSERT_EQ( 5000u, wheel.nextDeadline() );
+  ASSERT_TRUE( wheel.advanceTo( 4999 ).empty() );
+  const std::vector< unsigned int > both{ 0, 2 };
+  ASSERT_EQ( both, wheel.advanceTo( 5000 ));
+  ASSERT_EQ( TimerWheel::never, wheel.nextDeadline() );
+  ASSERT_FALSE( wheel.isScheduled( 0 ));
+}
+
+/// @brief Cancelled timers never fire, rescheduled ones fire at the new time
+TEST( TIMER_WHEEL, should_cancel_and_reschedule )
+{
+  TimerWheel wheel( 1000 );
+  const auto a = wheel.addTimer();
+  const auto b = wheel.addTimer();
+  wheel.schedule( a, 2000 );
+  wheel.schedule( b, 3000 );
+  wheel.cancel( a );
+  wheel.cancel( a );
+  wheel.schedule( b, 1500 );
+
+  ASSERT_FALSE( wheel.isScheduled( a ));
+  ASSERT_EQ( 1500u, wheel.nextDeadline() );
+  ASSERT_EQ( std::vector< unsigned int >{ b }, wheel.advanceTo( 10000 ));
+  ASSERT_EQ( TimerWheel::never, wheel.nextDeadline() );
+}
+
+/// @brief A deadline that's already passed fires on the next advance
+TEST( TIMER_WHEEL, should_expire_past_deadlines_now )
+{
+  TimerWheel wheel( 1000000 );
+  const auto a = wheel.addTimer();
+  wheel.schedule( a, 10 );
+  ASSERT_EQ( 1000000u, wheel.nextDeadline() );
+  ASSERT_EQ( std::vector< unsigned int >{ a }, wheel.advanceTo( 1000000 ));
+}
+
+/// @brief Deadlines past the top level wait there until they're in range
+TEST( TIMER_WHEEL, should_handle_deadlines_past_the_top_level )
+{
+  TimerWheel wheel;
+  const auto a = wheel.addTimer();
+  const uint64_t far = ( 1ULL << 40 ) + 12345;
+  wheel.schedule( a, far );
+  ASSERT_EQ( far, wheel.nextDeadline() );
+  ASSERT_TRUE( wheel.advanceTo( far - 1 ).empty() );
+  ASSERT_EQ( far, wheel.nextDeadline() );
+  ASSERT_EQ( std::vector< unsigned int >{ a }, wheel.advanceTo( far ));
+}
+
+/// @brief Random periodic timers expire exactly as a binary heap says
+TEST( TIMER_WHEEL, should_match_a_heap )
+{
+  TimerWheel wheel;
+  ReferenceQueue heap;
+  Lcg rng( 42 );
+  std::vector< uint64_t > period;
+  for ( unsigned int i = 0; i < 200; ++i )
+  {
+    // Periods from 1 us to about 17 minutes
+    period.push_back( 1 + rng.next() % ( 1ULL << ( 1 + i % 30 )));
+    wheel.addTimer();
+    wheel.schedule( i, period[i] );
+    heap.push( Pending( period[i], i ));
+  }
+
+  for ( unsigned int step = 0; step < 20000; ++step )
+  {
+    const uint64_t next = wheel.nextDeadline();
+    ASSERT_EQ( heap.top().first, next );
+    std::vector< unsigned int > golden;
+    while ( heap.top().first == next )
+    {
+      golden.push_back( heap.top().second );
+      heap.pop();
+    }
+    const std::vector< unsigned int > actual = wheel.advanceTo( next );
+    ASSERT_EQ( golden, actual );
+    for ( auto id : actual )
+    {
+      wheel.schedule( id, next + period[ id ] );
+      heap.push( Pending( next + period[ id ], id ));
+    }
+  }
+}
+
+namespace {
+
+/// @brief ns per dispatch for a scheduler run on the same random periods
+template< class Dispatch >
+double dispatchNs( unsigned int dispatches, Dispatch dispatch )
+{
+  using clock = std::chrono::steady_clock;
+  const auto start = clock::now();
+  for ( unsigned int i = 0; i < dispatches; )
+  {
+    i += dispatch();
+  }
+  return std::chrono::duration< double, std::nano >(
+    clock::now() - start ).count() / dispatches;
+}
+
+}
+
+/// @brief Compare the wheel with the heap ActionManager used to use
+TEST( TIMER_WHEEL_BENCH, dispatch_cost )
+{
+  const unsigned int dispatches = 200000;
+  for ( unsigned int n : { 10u, 100u, 1000u } )
+  {
+    Lcg rng( n );
+    std::vector< uint64_t > period;
+    for ( unsigned int i = 0; i < n; ++i )
+    {
+      // Between 100 us and 10 s, like the real actions
+      period.push_back( 100 + rng.next() % 10000000 );
+    }
+
+    ReferenceQueue heap;
+    for ( unsigned int i = 0; i < n; ++i ) {
+      heap.push( Pending( 0, i ));
+    }
+    const double heapNs = dispatchNs( dispatches, [&]() -> unsigned int
+    {
+      const Pending top = heap.top();
+      heap.pop();
+      heap.push( Pending( top.first + period[ top.second ], top.second ));
+      return 1;
+    });
+
+    TimerWheel wheel;
+    for ( unsigned int i = 0; i < n; ++i )
+    {
+      wheel.addTimer();
+      wheel.schedule( i, 0 );
+    }
+    const double wheelNs = dispatchNs( dispatches, [&]() -> unsigned int
+    {
+      const uint64_t now = wheel.nextDeadline();
+      const std::vector< unsigned int >& due = wheel.advanceTo( now );
+      for ( auto id : due ) {
+        wheel.schedule( id, now + period[ id ] );
+      }
+      return (unsigned int) due.size();
+    });
+
+    std::cout << n << " actions: heap " << heapNs << " ns/dispatch, wheel "
+              << wheelNs << " ns/dispatch\n";
+    ASSERT_EQ( heap.size(), n );
+  }
+}
+
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "action_manager.h"
+#include "trace_json.h"
+#include "trace_log.h"
+#include "test_mock_clock.h"
+#include "test_mock_debug.h"
+#include "test_mock_hardware.h"
+#include "test_mock_net.h"
+
+namespace {
+
+/// @brief Action that takes busyUs to run and asks for a fixed delay
+class SteppingAction : public ActionInterface
+{
+  public:
+  SteppingAction( const char* nameArg, std::shared_ptr< ClockMock > clockArg,
+    unsigned int busyArg, unsigned int delayArg ) :
+    name{ nameArg }, clock{ clockArg }, busyUs{ busyArg }, delay{ delayArg } {}
+  unsigned int loop() override
+  {
+    clock->advanceTime( busyUs );
+    return delay;
+  }
+  const char* debugName() override { return name; }
+
+  const char* name;
+  std::shared_ptr< ClockMock > clock;
+  unsigned int busyUs;
+  unsigned int delay;
+};
+
+/// @brief Everything the net mock printed, one line per entry
+std::string joined( NetMockSimpleTimed& net )
+{
+  std::string all;
+  for ( const auto& line : net.getOutput() ) {
+    all += line.event + "\n";
+  }
+  return all;
+}
+
+}
+
+/// @brief A full ring overwrites its oldest events
+TEST( TRACE_LOG, should_keep_the_newest_events )
+{
+  TraceLog log( 3 );
+  log.begin( 0, 10 );
+  log.end( 0, 20, 100 );
+  log.begin( 1, 30 );
+  log.end( 1, 40, 200 );
+  ASSERT_EQ( 3u, log.size() );
+  ASSERT_EQ( 1u, log.getDropped() );
+  ASSERT_EQ( 20u, log[0].timeUs );
+  ASSERT_EQ( 100u, log[0].delayUs );
+  ASSERT_EQ( TraceLog::Type::END, log[0].type );
+  ASSERT_EQ( 40u, log[2].timeUs );
+  ASSERT_EQ( 1u, log[2].action );
+}
+
+/// @brief load() reads back what save() wrote
+TEST( TRACE_LOG, should_round_trip )
+{
+  TraceLog log( 8 );
+  log.setName( 1, "DataMover" );
+  log.setName( 0, "SSound" );
+  log.begin( 0, 5 );
+  log.end( 0, 9, 100 );
+  log.begin( 1, 9 );
+
+  SnapshotWriter out;
+  log.save( out );
+  SnapshotReader in( out.getData().data(), out.getData().size() );
+  std::vector< std::string > names;
+  std::vector< TraceLog::Event > events;
+  ASSERT_TRUE( TraceLog::load( in, names, events ));
+  ASSERT_TRUE( in.atEnd() );
+  ASSERT_EQ( ( std::vector< std::string >{ "SSound", "DataMover" } ), names );
+  ASSERT_EQ( 3u, events.size() );
+  ASSERT_EQ( 100u, events[1].delayUs );
+  ASSERT_EQ( 1u, events[2].action );
+
+  // A truncated log is rejected
+  SnapshotReader shortIn( out.getData().data(), out.getData().size() - 1 );
+  ASSERT_FALSE( TraceLog::load( shortIn, names, events ));
+}
+
+/// @brief The manager's trace dump converts to a Chrome trace
+TEST( TRACE_LOG, should_trace_actions_to_chrome_json )
+{
+  auto clock = std::make_shared< ClockMock >();
+  auto manager = std::make_shared< ActionManager >(
+    std::make_shared< NetMockSimpleTimed >( TimedStringEvents() ),
+    std::make_shared< HWMockTimed >( HWTimedEvents() ),
+    std::make_shared< DebugInterfaceIgnoreMock >(),
+    clock );
+  manager->addAction( std::make_shared< SteppingAction >( "sound", clock, 30, 100 ));
+  manager->setTraceLog( std::make_shared< TraceLog >( 16 ));
+  manager->addAction( std::make_shared< SteppingAction >( "\"net\"", clock, 5, 1000 ));
+
+  for ( unsigned int i = 0; i < 2; ++i ) {
+    clock->advanceTime( manager->loop() );
+  }
+
+  NetMockSimpleTimed net( TimedStringEvents{} );
+  manager->dumpTrace( net );
+  std::istringstream capture( "noise\n" + joined( net ) + "more noise\n" );
+  std::vector< uint8_t > bytes;
+  ASSERT_TRUE( readTraceDump( capture, bytes ));
+
+  SnapshotReader in( bytes.data(), bytes.size() );
+  std::vector< std::string > names;
+  std::vector< TraceLog::Event > events;
+  ASSERT_TRUE( TraceLog::load( in, names, events ));
+
+  std::ostringstream json;
+  writeChromeTrace( json, names, events );
+  const std::string golden =
+    "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+    "{\"name\":\"sound\",\"ph\":\"B\",\"ts\":0,\"pid\":1,\"tid\":1},\n"
+    "{\"name\":\"sound\",\"ph\":\"E\",\"ts\":30,\"pid\":1,\"tid\":1,\"args\":{\"delayUs\":100}},\n"
+    "{\"name\":\"\\\"net\\\"\",\"ph\":\"B\",\"ts\":30,\"pid\":1,\"tid\":1},\n"
+    "{\"name\":\"\\\"net\\\"\",\"ph\":\"E\",\"ts\":35,\"pid\":1,\"tid\":1,\"args\":{\"delayUs\":1000}},\n"
+    "{\"name\":\"sound\",\"ph\":\"B\",\"ts\":100,\"pid\":1,\"tid\":1},\n"
+    "{\"name\":\"sound\",\"ph\":\"E\",\"ts\":130,\"pid\":1,\"tid\":1,\"args\":{\"delayUs\":100}}\n"
+    "]}\n";
+  ASSERT_EQ( golden, json.str() );
+}
+
+/// @brief Ends whose begins were overwritten are left out
+TEST( TRACE_LOG, should_drop_unmatched_ends )
+{
+  std::vector< TraceLog::Event > events{
+    { 0xfffffff0u, 50, 0, TraceLog::Type::END, 0 },
+    { 0xfffffff8u, 0, 0, TraceLog::Type::BEGIN, 0 },
+    { 0x00000008u, 60, 0, TraceLog::Type::END, 0 },
+  };
+  std::ostringstream json;
+  writeChromeTrace( json, { "a" }, events );
+  ASSERT_EQ( std::string::npos, json.str().find( "\"delayUs\":50" ));
+  ASSERT_NE( std::string::npos, json.str().find( "\"ts\":24," ));
+}
+